@@ -0,0 +1,90 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveBenchmark.hpp"
+#include "LveFrustum.hpp"
+#include "LveJobSystem.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve::bench {
+
+	namespace {
+		constexpr uint32_t repetitions = 9;
+		constexpr uint32_t sphereCount = 1'000'000;
+		constexpr uint32_t cullGrainSize = 4096;
+		constexpr uint32_t emptyJobCount = 100'000;
+
+		// 1, 2, 4, ... threads up to the hardware concurrency, which is always included
+		std::vector<uint32_t> threadCounts() {
+			const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+			std::vector<uint32_t> counts;
+			for (uint32_t count = 1; count < hardwareThreads; count *= 2) {
+				counts.push_back(count);
+			}
+			counts.push_back(hardwareThreads);
+			return counts;
+		}
+	}
+
+	// Frustum culling of 1M bounding spheres with parallelFor, the work RenderSystem spreads over the job
+	// system each frame, and the cost of scheduling empty jobs, for 1 thread up to every hardware thread
+	void runJobSystemBenchmarks() {
+		std::mt19937 random{42};
+		std::uniform_real_distribution<float> position{-50.f, 50.f};
+		std::uniform_real_distribution<float> radius{.1f, 2.f};
+		std::vector<glm::vec4> spheres(sphereCount);
+		for (auto &sphere: spheres) {
+			sphere = {position(random), position(random), position(random), radius(random)};
+		}
+		auto projection = glm::perspective(glm::radians(50.f), 16.f / 9.f, .1f, 100.f);
+		auto view = glm::lookAt(glm::vec3{0.f, 0.f, -60.f}, glm::vec3{0.f}, glm::vec3{0.f, 1.f, 0.f});
+		auto frustum = LveFrustum::fromMatrix(projection * view);
+		std::vector<uint8_t> visible(sphereCount);
+
+		double cullBaseline = 0.;
+		double scheduleBaseline = 0.;
+		for (uint32_t threads: threadCounts()) {
+			LveJobSystem jobSystem{threads - 1};
+
+			double cull = measure(repetitions, [&]() {
+				jobSystem.parallelFor(sphereCount, cullGrainSize, [&](uint32_t begin, uint32_t end) {
+					for (uint32_t i = begin; i < end; i++) {
+						visible[i] = frustum.intersectsSphere(glm::vec3{spheres[i]}, spheres[i].w);
+					}
+				});
+			});
+
+			std::atomic<uint32_t> executed{0};
+			double schedule = measure(repetitions, [&]() {
+				LveJobCounter counter;
+				for (uint32_t i = 0; i < emptyJobCount; i++) {
+					jobSystem.run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				}
+				jobSystem.wait(counter);
+			});
+
+			if (threads == 1) {
+				cullBaseline = cull;
+				scheduleBaseline = schedule;
+			}
+			std::printf(" %u threads, speedup over 1 thread\n", threads);
+			report("cull 1M spheres", cull, cullBaseline);
+			report(("run and wait " + std::to_string(emptyJobCount) + " empty jobs").c_str(), schedule,
+			       scheduleBaseline);
+		}
+	}
+}
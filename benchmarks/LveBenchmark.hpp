@@ -0,0 +1,55 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEBENCHMARK_HPP
+#define VULKAN_TEST_LVEBENCHMARK_HPP
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace lve::bench {
+
+	// Runs setup and then body repetitions times and returns the median time of body in milliseconds, so a
+	// single preempted run does not skew the result. setup is not timed.
+	template<typename Setup, typename Body>
+	double measure(uint32_t repetitions, Setup &&setup, Body &&body) {
+		std::vector<double> times;
+		times.reserve(repetitions);
+		for (uint32_t i = 0; i < repetitions; i++) {
+			setup();
+			auto start = std::chrono::steady_clock::now();
+			body();
+			auto end = std::chrono::steady_clock::now();
+			times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+		return times[times.size() / 2];
+	}
+
+	template<typename Body>
+	double measure(uint32_t repetitions, Body &&body) {
+		return measure(repetitions, []() {}, body);
+	}
+
+	// One line per result: name, the median in milliseconds and, when given, the speedup over a baseline
+	inline void report(const char *name, double milliseconds, double baselineMilliseconds = 0.) {
+		if (baselineMilliseconds > 0.) {
+			std::printf("  %-40s %10.3f ms  %6.2fx\n", name, milliseconds, baselineMilliseconds / milliseconds);
+		} else {
+			std::printf("  %-40s %10.3f ms\n", name, milliseconds);
+		}
+	}
+
+	void runRadixSortBenchmarks();
+
+	void runJobSystemBenchmarks();
+
+	void runSceneGraphBenchmarks();
+}
+
+#endif //VULKAN_TEST_LVEBENCHMARK_HPP
@@ -0,0 +1,69 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveBenchmark.hpp"
+#include "LveJobSystem.hpp"
+#include "LveRadixSort.hpp"
+
+// std
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace lve::bench {
+
+	namespace {
+		constexpr uint32_t repetitions = 9;
+
+		bool isSorted(const std::vector<SortItem> &items) {
+			return std::is_sorted(items.begin(), items.end(), [](const SortItem &a, const SortItem &b) {
+				return a.m_key < b.m_key;
+			});
+		}
+	}
+
+	// Render queue keys, uniformly random over all 64 bits, from 1k up to 1M items
+	void runRadixSortBenchmarks() {
+		LveJobSystem jobSystem;
+		std::mt19937_64 random{42};
+
+		for (uint32_t count: {1'000u, 10'000u, 100'000u, 1'000'000u}) {
+			std::vector<SortItem> input(count);
+			for (uint32_t i = 0; i < count; i++) {
+				input[i] = {random(), i};
+			}
+			std::vector<SortItem> items;
+			std::vector<SortItem> scratch;
+			auto reset = [&]() { items = input; };
+
+			double stdSort = measure(repetitions, reset, [&]() {
+				std::sort(items.begin(), items.end(), [](const SortItem &a, const SortItem &b) {
+					return a.m_key < b.m_key;
+				});
+			});
+			double stableSort = measure(repetitions, reset, [&]() {
+				std::stable_sort(items.begin(), items.end(), [](const SortItem &a, const SortItem &b) {
+					return a.m_key < b.m_key;
+				});
+			});
+			double sequential = measure(repetitions, reset, [&]() { radixSort(items, scratch); });
+			if (!isSorted(items)) {
+				throw std::runtime_error("radixSort left items unsorted");
+			}
+			double parallel = measure(repetitions, reset, [&]() { radixSort(items, scratch, 64, &jobSystem); });
+			if (!isSorted(items)) {
+				throw std::runtime_error("radixSort on the job system left items unsorted");
+			}
+
+			std::printf(" %u items, speedup over std::sort\n", count);
+			report("std::sort", stdSort, stdSort);
+			report("std::stable_sort", stableSort, stdSort);
+			report("radixSort", sequential, stdSort);
+			report(("radixSort, " + std::to_string(jobSystem.getThreadCount()) + " threads").c_str(), parallel,
+			       stdSort);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveBenchmark.hpp"
+#include "LveJobSystem.hpp"
+#include "LveSceneGraph.hpp"
+
+// std
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace lve::bench {
+
+	namespace {
+		constexpr uint32_t repetitions = 9;
+		constexpr uint32_t nodeCount = 1 << 17;
+
+		// A chain of nodeCount nodes, one per level, so each level is too small to split over threads
+		SceneNode buildDeep(LveSceneGraph &sceneGraph) {
+			const SceneNode root = sceneGraph.createNode();
+			SceneNode parent = root;
+			for (uint32_t i = 1; i < nodeCount; i++) {
+				parent = sceneGraph.createNode(parent, {{0.f, .01f, 0.f}, {1.f, 1.f, 1.f}, {0.f, .001f, 0.f}});
+			}
+			return root;
+		}
+
+		// One root with every other node as its child, a single level of nodeCount - 1 nodes
+		SceneNode buildWide(LveSceneGraph &sceneGraph) {
+			const SceneNode root = sceneGraph.createNode();
+			for (uint32_t i = 1; i < nodeCount; i++) {
+				const auto offset = static_cast<float>(i);
+				sceneGraph.createNode(root, {{offset, 0.f, 0.f}, {1.f, 1.f, 1.f}, {0.f, offset * .001f, 0.f}});
+			}
+			return root;
+		}
+
+		// Moves the root before each update, so every node is recomputed
+		double measureUpdate(LveJobSystem *jobSystem, SceneNode (*build)(LveSceneGraph &)) {
+			LveSceneGraph sceneGraph{jobSystem};
+			const SceneNode root = build(sceneGraph);
+			sceneGraph.update();
+			if (sceneGraph.getNodeCount() != nodeCount) {
+				throw std::runtime_error("Scene graph lost nodes");
+			}
+
+			float x = 0.f;
+			return measure(repetitions,
+			               [&]() { sceneGraph.setLocalTransform(root, {{x += 1.f, 0.f, 0.f}}); },
+			               [&]() { sceneGraph.update(); });
+		}
+	}
+
+	// Full updates of a deep and a wide graph of 128k nodes, on the calling thread and on the job system
+	void runSceneGraphBenchmarks() {
+		LveJobSystem jobSystem;
+		const std::string parallel = "job system, " + std::to_string(jobSystem.getThreadCount()) + " threads";
+
+		struct Shape {
+			const char *m_name;
+			SceneNode (*m_build)(LveSceneGraph &);
+		};
+		for (const auto &shape: {Shape{"deep", buildDeep}, Shape{"wide", buildWide}}) {
+			double single = measureUpdate(nullptr, shape.m_build);
+			double threaded = measureUpdate(&jobSystem, shape.m_build);
+
+			std::printf(" %s, %u nodes, speedup over the calling thread\n", shape.m_name, nodeCount);
+			report("calling thread", single, single);
+			report(parallel.c_str(), threaded, single);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#include "LveBenchmark.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    struct Group {
+        const char *m_name;
+        void (*m_run)();
+    };
+
+    constexpr Group groups[] = {
+            {"radix_sort", lve::bench::runRadixSortBenchmarks},
+            {"job_system", lve::bench::runJobSystemBenchmarks},
+            {"scene_graph", lve::bench::runSceneGraphBenchmarks},
+    };
+}
+
+int main(int argc, char **argv) {
+    // Runs every benchmark group, or only the groups named on the command line
+    try {
+        for (const auto &group: groups) {
+            bool selected = argc < 2;
+            for (int i = 1; i < argc; i++) {
+                selected |= std::strcmp(argv[i], group.m_name) == 0;
+            }
+            if (selected) {
+                std::cout << group.m_name << std::endl;
+                group.m_run();
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,47 @@
+# Generates a C++ source with every compiled SPIR-V module as an aligned uint32_t array, registered in
+# lve::embeddedShaders under the path it is loaded from at runtime (see src/LveShaderCode.hpp).
+#
+# Run in script mode with:
+#   SHADER_FILES  comma separated list of .spv files
+#   NAME_PREFIX   prepended to each file name to form the lookup path, e.g. "src/shaders/"
+#   OUTPUT_FILE   the source to generate
+
+string(REPLACE "," ";" SHADER_FILES "${SHADER_FILES}")
+
+set(ARRAYS "")
+set(ENTRIES "")
+foreach (source IN LISTS SHADER_FILES)
+    get_filename_component(FILENAME ${source} NAME)
+    string(MAKE_C_IDENTIFIER ${FILENAME} SYMBOL)
+
+    file(READ ${source} HEX HEX)
+    # SPIR-V is stored in host byte order, little-endian on every platform this builds for
+    string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u, " WORDS "${HEX}")
+    # Eight words per line
+    set(WORD "0x[0-9a-f]+u, ")
+    string(REGEX REPLACE "(${WORD}${WORD}${WORD}${WORD}${WORD}${WORD}${WORD}${WORD})" "\\1\n" WORDS "${WORDS}")
+    string(REGEX REPLACE " \n" "\n\t\t\t\t" WORDS "${WORDS}")
+    string(STRIP "${WORDS}" WORDS)
+
+    string(APPEND ARRAYS "\t\talignas(4) constexpr uint32_t ${SYMBOL}[] = {\n\t\t\t\t${WORDS}\n\t\t};\n\n")
+    string(APPEND ENTRIES "\t\t\t{\"${NAME_PREFIX}${FILENAME}\", ${SYMBOL}, sizeof(${SYMBOL}) / sizeof(uint32_t)},\n")
+endforeach ()
+
+set(CONTENT "// Generated by cmake/EmbedShaders.cmake, do not edit
+
+#include \"LveShaderCode.hpp\"
+
+namespace lve {
+	namespace {
+${ARRAYS}	}
+
+	const EmbeddedShader embeddedShaders[] = {
+${ENTRIES}			{nullptr, nullptr, 0},
+	};
+}
+")
+
+# Only touch the output when it changes, so unchanged shaders do not trigger a recompile
+file(WRITE ${OUTPUT_FILE}.tmp "${CONTENT}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT_FILE}.tmp ${OUTPUT_FILE})
+file(REMOVE ${OUTPUT_FILE}.tmp)
@@ -1,61 +1,273 @@
 #include "FirstApp.hpp"
+#include "LveBindlessHeap.hpp"
+#include "LveShaderWatcher.hpp"
 #include "RenderSystem.hpp"
+#include "GpuDrivenRenderSystem.hpp"
 #include "LveCamera.hpp"
 #include "KeyboardMovementController.hpp"
+#include "LveTripleBuffer.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
 #include <chrono>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <thread>
 
 
 namespace lve {
 
-	FirstApp::FirstApp() {
+	FirstApp::FirstApp(bool headless) : m_lveWindow_{m_width, m_height, "Hello Vulkan!", headless} {
 		loadGameObjects();
 	}
 
 	FirstApp::~FirstApp() {}
 
+	void FirstApp::setFrameRegression(LveFrameRegression::Settings settings) {
+		if (settings.m_shots.empty()) {
+			constexpr auto depthView = static_cast<uint32_t>(RenderSystem::DebugView::Depth);
+			constexpr auto materialView = static_cast<uint32_t>(RenderSystem::DebugView::Material);
+			settings.m_shots = {
+					{"front", {0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}},
+					{"close", {0.f, 0.f, 1.4f}, {0.f, 0.f, 0.f}},
+					{"side", {-1.5f, 0.f, 1.f}, {0.f, glm::quarter_pi<float>(), 0.f}},
+					{"above", {0.f, -1.5f, 1.f}, {-glm::quarter_pi<float>(), 0.f, 0.f}},
+					{"front_default_layer", {0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}, 1u},
+					{"front_depth", {0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}, ~0u, depthView},
+					{"side_material", {-1.5f, 0.f, 1.f}, {0.f, glm::quarter_pi<float>(), 0.f}, ~0u, materialView},
+			};
+			loadRegressionObjects();
+		}
+		m_regressionSettings_ = std::move(settings);
+	}
+
 	void FirstApp::run() {
-		RenderSystem simpleRenderSystem{m_lveDevice_, m_lveRenderer_.getSwapChainRenderPass()};
+		std::unique_ptr<LveBindlessHeap> bindlessHeap;
+		if (LveBindlessHeap::isSupported(m_lveDevice_)) {
+			bindlessHeap = std::make_unique<LveBindlessHeap>(m_lveDevice_);
+		}
+		LveTextureManager textureManager{m_lveDevice_, m_lveRenderer_.getDeletionQueue(), bindlessHeap.get(), {}};
+		std::vector<TextureId> textures;
+		for (const auto &path: m_texturePaths_) {
+			textures.push_back(textureManager.load(path));
+		}
+		// Objects with a model take the textures in turn
+		for (size_t i = 0, next = 0; i < m_gameObjects_.size() && !textures.empty(); i++) {
+			if (m_gameObjects_[i].m_model) {
+				m_gameObjects_[i].m_texture = textures[next++ % textures.size()];
+			}
+		}
+		RenderSystem simpleRenderSystem{m_lveDevice_,
+		                                m_lveRenderer_.getSwapChainRenderTarget(),
+		                                m_pipelineCompiler_,
+		                                bindlessHeap.get(),
+		                                &textureManager,
+		                                &m_jobSystem_};
+		std::unique_ptr<GpuDrivenRenderSystem> gpuDrivenRenderSystem;
+		if (GpuDrivenRenderSystem::isSupported(m_lveDevice_)) {
+			gpuDrivenRenderSystem = std::make_unique<GpuDrivenRenderSystem>(
+					m_lveDevice_,
+					m_lveRenderer_.getSwapChainRenderTarget(),
+					m_pipelineCompiler_,
+					m_lveRenderer_.getDeletionQueue());
+		}
+		bool texturesLoaded = textures.empty();
+		std::unique_ptr<LveFrameCapture> frameCapture;
+		if (m_captureSettings_) {
+			if (!m_lveRenderer_.isSwapChainTransferSource()) {
+				throw std::runtime_error("The surface does not allow reading back swap chain images");
+			}
+			frameCapture = std::make_unique<LveFrameCapture>(m_lveDevice_, *m_captureSettings_);
+		}
+		std::unique_ptr<LveFrameRegression> regression;
+		if (m_regressionSettings_) {
+			if (!m_lveRenderer_.isSwapChainTransferSource()) {
+				throw std::runtime_error("The surface does not allow reading back swap chain images");
+			}
+			regression = std::make_unique<LveFrameRegression>(m_lveDevice_, *m_regressionSettings_);
+		}
+#ifdef LVE_SHADER_HOT_RELOAD
+		LveShaderWatcher shaderWatcher{LVE_SHADER_SOURCE_DIR, LVE_SHADER_BINARY_DIR, LVE_GLSLC_EXECUTABLE};
+#endif
 		LveCamera camera{};
 		camera.setViewTarget(glm::vec3{-1.f, -2.f, 2.f}, glm::vec3{0.f, 0.f, 2.5f});
 		auto viewerObject = LveGameObject::createGameObject();
 		KeyboardMovementController cameraController{};
+		// The objects of the current regression shot, when it draws a subset of the scene
+		std::vector<RenderObject> shotObjects;
 
-		float aspect = m_lveRenderer_.getAspectRatio();
+		// The render thread records frame N from a snapshot while the main thread, which has to poll the
+		// window, simulates frame N + 1. Everything on the GPU side is only touched by the render thread
+		// from here on.
+		LveTripleBuffer<FrameSnapshot> snapshots;
+		std::exception_ptr renderError;
+		std::thread renderThread{[&]() {
+			try {
+				while (true) {
+					snapshots.waitForPublish();
+					if (!snapshots.acquire()) {
+						break;
+					}
+					const auto &snapshot = snapshots.getReadBuffer();
+					const std::vector<RenderObject> *renderObjects = &snapshot.m_objects;
+					auto debugView = RenderSystem::DebugView::Shaded;
 
+					// Shots are rendered in lockstep with the regression, whatever the simulation did
+					if (regression) {
+						if (regression->isFinished()) {
+							break;
+						}
+						const auto &shot = regression->getCurrentShot();
+						camera.setViewYXZ(shot.m_translation, shot.m_rotation);
+						if (shot.m_renderLayers != ~0u) {
+							shotObjects.clear();
+							std::copy_if(snapshot.m_objects.begin(), snapshot.m_objects.end(),
+							             std::back_inserter(shotObjects),
+							             [&](const RenderObject &object) {
+								             return (object.m_renderLayers & shot.m_renderLayers) != 0;
+							             });
+							renderObjects = &shotObjects;
+						}
+						// A golden image of a debug view must not catch the shaded fallback
+						debugView = static_cast<RenderSystem::DebugView>(shot.m_debugView);
+						simpleRenderSystem.setDebugView(debugView);
+						simpleRenderSystem.waitForDebugView();
+					} else {
+						camera.setViewYXZ(snapshot.m_cameraTranslation, snapshot.m_cameraRotation);
+					}
+					float aspect = m_lveRenderer_.getAspectRatio();
+//					camera.setOrthographicProjection(-aspect, aspect, -1., 1., -1., 1.);
+					camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 10.f);
+					if (auto commandBuffer = m_lveRenderer_.beginFrame()) {
+						int frameIndex = m_lveRenderer_.getFrameIndex();
+						FrameInfo frameInfo{frameIndex, snapshot.m_frameTime, commandBuffer, camera};
+						if (bindlessHeap) {
+							bindlessHeap->beginFrame(frameIndex);
+						}
+						textureManager.beginFrame(frameIndex);
+						if (frameCapture) {
+							frameCapture->beginFrame(frameIndex);
+						}
+						if (regression) {
+							regression->beginFrame(frameIndex);
+						}
+#ifdef LVE_SHADER_HOT_RELOAD
+						auto changedShaders = shaderWatcher.takeChangedShaders();
+						simpleRenderSystem.reloadShaders(changedShaders, m_lveRenderer_.getDeletionQueue());
+						if (gpuDrivenRenderSystem) {
+							gpuDrivenRenderSystem->reloadShaders(changedShaders, m_lveRenderer_.getDeletionQueue());
+						}
+#endif
+
+						// the graph orders culling, drawing and the depth pyramid, and records them in endFrame
+						auto &renderGraph = m_lveRenderer_.getRenderGraph();
+						auto targets = m_lveRenderer_.importSwapChainTargets();
+						if (regression) {
+							regression->addBeginPasses(renderGraph, frameIndex);
+						}
+						textureManager.addUploadPass(renderGraph, frameIndex);
+						if (!texturesLoaded) {
+							texturesLoaded = std::none_of(textures.begin(), textures.end(), [&](TextureId texture) {
+								auto state = textureManager.getResidency(texture).m_state;
+								return state == LveTextureManager::State::Loading ||
+								       state == LveTextureManager::State::Streaming;
+							});
+							if (texturesLoaded) {
+								std::cout << "textures resident" << std::endl;
+							}
+						}
+						// Debug views and textures are only drawn by the render system
+						if (gpuDrivenRenderSystem && debugView == RenderSystem::DebugView::Shaded && textures.empty()) {
+							gpuDrivenRenderSystem->addRenderPasses(renderGraph, frameInfo, *renderObjects,
+							                                       targets.m_color, targets.m_depth);
+						} else {
+							simpleRenderSystem.addRenderPass(renderGraph, frameInfo, *renderObjects,
+							                                 targets.m_color, targets.m_depth);
+						}
+						if (frameCapture) {
+							frameCapture->addCapturePass(renderGraph, frameIndex, targets.m_color);
+						}
+						if (regression) {
+							regression->addEndPasses(renderGraph, frameIndex, targets.m_color);
+						}
+						m_lveRenderer_.endFrame();
+						if (regression) {
+							regression->endFrame();
+						}
+					}
+				}
+			} catch (...) {
+				renderError = std::current_exception();
+			}
+			// Also stops the simulation when rendering ended first
+			snapshots.close();
+		}};
+
+		// The view of the previous simulation step, rendering blends from it to the current one
+		TransformComponent previousViewer = viewerObject.m_transform;
+
+		// Stages of a simulation step. The camera reads the keyboard, so it stays on the main thread, while
+		// the transforms are updated on the job system next to it.
+		LveJobGraph simulationStages;
+		simulationStages.addStage("camera", [&]() {
+			previousViewer = viewerObject.m_transform;
+			cameraController.moveInPlaneXZ(m_lveWindow_.getWindow(), m_simulationStep_, viewerObject);
+		}, {}, true);
+		simulationStages.addStage("transforms", [this]() { updateTransforms(); });
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
+		float accumulator = 0.f;
 
-		while (!m_lveWindow_.shouldClose()) {
-			glfwPollEvents();
+		while (!m_lveWindow_.shouldClose() && !snapshots.isClosed()) {
+			m_lveWindow_.pollEvents();
 
 			auto newTime = std::chrono::high_resolution_clock::now();
 			float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
 			currentTime = newTime;
 
-			frameTime = std::min(frameTime, 0.1f);
-
-			cameraController.moveInPlaneXZ(m_lveWindow_.getWindow(), frameTime, viewerObject);
-			camera.setViewYXZ(viewerObject.m_transform.m_translation, viewerObject.m_transform.m_rotation);
-
-			aspect = m_lveRenderer_.getAspectRatio();
-//			camera.setOrthographicProjection(-aspect, aspect, -1., 1., -1., 1.);
-			camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 10.f);
-			if (auto commandBuffer = m_lveRenderer_.beginFrame()) {
-				// render system
-				m_lveRenderer_.beginSwapChainRenderPass(commandBuffer);
-				simpleRenderSystem.renderGameObjects(commandBuffer, m_gameObjects_, camera);
-				m_lveRenderer_.endSwapChainRenderPass(commandBuffer);
-				m_lveRenderer_.endFrame();
+			// The simulation advances in fixed steps however fast frames are rendered, catching up with
+			// several steps after a slow frame
+			accumulator += frameTime;
+			uint32_t steps = 0;
+			while (accumulator >= m_simulationStep_) {
+				// Steps that take longer than the time they simulate would fall further behind every frame;
+				// let the simulation run slower than real time instead
+				if (steps == m_maxSimulationSteps) {
+					accumulator = 0.f;
+					break;
+				}
+				simulationStages.run(m_jobSystem_);
+				accumulator -= m_simulationStep_;
+				steps++;
 			}
+
+			writeSnapshot(snapshots.getWriteBuffer(), frameTime, accumulator / m_simulationStep_, previousViewer,
+			              viewerObject);
+			snapshots.publish();
+			// Keeps the simulation a single snapshot ahead of the frame being recorded
+			snapshots.waitForAcquire();
 		}
+		snapshots.close();
+		renderThread.join();
 
 		vkDeviceWaitIdle(m_lveDevice_.device());
+		if (renderError) {
+			std::rethrow_exception(renderError);
+		}
+		if (frameCapture) {
+			auto droppedFrames = frameCapture->getDroppedFrameCount();
+			// writes out the frames still queued
+			frameCapture.reset();
+			std::cout << "frame capture dropped " << droppedFrames << " frames" << std::endl;
+		}
+		if (regression) {
+			regression->finish();
+		}
 	}
 
 
@@ -115,7 +327,23 @@ namespace lve {
 		for (auto &v: vertices) {
 			v.m_position += offset;
 		}
-		return std::make_unique<LveModel>(device, vertices);
+
+		// Share vertices between the two triangles of each face; indexed models are required for
+		// GPU-driven rendering.
+		LveModel::Builder builder{};
+		for (const auto &v: vertices) {
+			auto existing = std::find_if(builder.m_vertices.begin(), builder.m_vertices.end(), [&](const auto &u) {
+				return u.m_position == v.m_position && u.m_color == v.m_color;
+			});
+			if (existing == builder.m_vertices.end()) {
+				builder.m_indices.push_back(static_cast<uint32_t>(builder.m_vertices.size()));
+				builder.m_vertices.push_back(v);
+			} else {
+				builder.m_indices.push_back(static_cast<uint32_t>(existing - builder.m_vertices.begin()));
+			}
+		}
+		builder.m_buildMeshlets = true;
+		return std::make_unique<LveModel>(device, builder);
 	}
 
 	void FirstApp::loadGameObjects() {
@@ -125,7 +353,95 @@ namespace lve {
 		cube.m_model = lveModel;
 		cube.m_transform.m_translation = {0.f, 0.f, 2.5f};
 		cube.m_transform.m_scale = {.5, .5f, .5f};
-		m_gameObjects_.push_back(std::move(cube));
+		addGameObject(std::move(cube));
+	}
+
+	void FirstApp::loadRegressionObjects() {
+		std::shared_ptr<LveModel> lveModel = createCubeModel(m_lveDevice_, {0.f, 0.f, 0.f});
+
+		// Blended in front of the cube
+		auto glass = LveGameObject::createGameObject();
+		glass.m_model = lveModel;
+		glass.m_opacity = .5f;
+		glass.m_renderLayers = m_regressionLayer;
+		glass.m_transform.m_translation = {.6f, -.3f, 1.8f};
+		glass.m_transform.m_scale = {.3f, .3f, .3f};
+		addGameObject(std::move(glass));
+
+		// Partly hidden behind the cube, for occlusion culling
+		for (int i = 0; i < 5; i++) {
+			auto cube = LveGameObject::createGameObject();
+			cube.m_model = lveModel;
+			cube.m_renderLayers = m_regressionLayer;
+			cube.m_transform.m_translation = {-1.5f + .75f * static_cast<float>(i), 0.f, 4.f};
+			cube.m_transform.m_scale = {.25f, .25f, .25f};
+			addGameObject(std::move(cube));
+		}
+	}
+
+	void FirstApp::addGameObject(LveGameObject object) {
+		object.m_sceneNode = m_sceneGraph_.createNode(LveSceneGraph::m_invalidNode, object.m_transform);
+		// Not blended in from the origin on its first frame
+		object.m_worldMatrix = object.m_transform.mat4();
+		object.m_previousWorldMatrix = object.m_worldMatrix;
+		LveGameObject::getHandleAllocator().setValue(object.getId(), static_cast<uint32_t>(m_gameObjects_.size()));
+		m_gameObjects_.push_back(std::move(object));
+	}
+
+	LveGameObject *FirstApp::findGameObject(LveGameObject::id_t id) {
+		uint32_t index = LveGameObject::getHandleAllocator().lookup(id);
+		return index == LveHandleAllocator::m_invalidValue ? nullptr : &m_gameObjects_[index];
+	}
+
+	void FirstApp::destroyGameObject(LveGameObject::id_t id) {
+		uint32_t index = LveGameObject::getHandleAllocator().lookup(id);
+		if (index == LveHandleAllocator::m_invalidValue) {
+			return;
+		}
+
+		// The last object takes the freed position, so the array stays dense
+		m_sceneGraph_.destroyNode(m_gameObjects_[index].m_sceneNode);
+		if (index + 1 != m_gameObjects_.size()) {
+			m_gameObjects_[index] = std::move(m_gameObjects_.back());
+			LveGameObject::getHandleAllocator().setValue(m_gameObjects_[index].getId(), index);
+		}
+		m_gameObjects_.pop_back();
+	}
+
+	void FirstApp::writeSnapshot(FrameSnapshot &snapshot,
+	                             float frameTime,
+	                             float alpha,
+	                             const TransformComponent &previousViewer,
+	                             const LveGameObject &viewerObject) const {
+		const auto viewer = interpolate(previousViewer, viewerObject.m_transform, alpha);
+		snapshot.m_frameTime = frameTime;
+		snapshot.m_cameraTranslation = viewer.m_translation;
+		snapshot.m_cameraRotation = viewer.m_rotation;
+		snapshot.m_objects.clear();
+		for (const auto &obj: m_gameObjects_) {
+			if (obj.m_model) {
+				snapshot.m_objects.push_back({obj.m_model,
+				                              interpolate(obj.m_previousWorldMatrix, obj.m_worldMatrix, alpha),
+				                              obj.m_color,
+				                              obj.m_opacity,
+				                              obj.m_renderLayers,
+				                              obj.m_texture});
+			}
+		}
+	}
+
+	void FirstApp::updateTransforms() {
+		for (auto &obj: m_gameObjects_) {
+			m_sceneGraph_.setLocalTransform(obj.m_sceneNode, obj.m_transform);
+		}
+		m_sceneGraph_.update();
+		m_jobSystem_.parallelFor(static_cast<uint32_t>(m_gameObjects_.size()), 1024, [this](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				auto &obj = m_gameObjects_[i];
+				obj.m_previousWorldMatrix = obj.m_worldMatrix;
+				obj.m_worldMatrix = m_sceneGraph_.getWorldMatrix(obj.m_sceneNode);
+			}
+		});
 	}
 
 }
\ No newline at end of file
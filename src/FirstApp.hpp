@@ -7,13 +7,20 @@
 
 #include "LveWindow.hpp"
 #include "LvePipeline.hpp"
+#include "LvePipelineCompiler.hpp"
 #include "LveGameObject.hpp"
+#include "LveJobSystem.hpp"
 #include "LveDevice.hpp"
+#include "LveFrameCapture.hpp"
+#include "LveFrameRegression.hpp"
+#include "LveFrameSnapshot.hpp"
 #include "LveSwapChain.hpp"
 #include "LveModel.hpp"
 #include "LveRenderer.hpp"
+#include "LveTextureManager.hpp"
 
 #include <memory>
+#include <optional>
 #include <vector>
 #include <stdexcept>
 
@@ -21,8 +28,11 @@ namespace lve {
     class FirstApp {
     public:
 	    static constexpr int m_width = 800, m_height = 600;
+	    // Simulation steps run per rendered frame at most, time beyond them is dropped
+	    static constexpr uint32_t m_maxSimulationSteps = 8;
 
-        FirstApp();
+        // A headless app renders offscreen without a display, for regression runs on CI
+        explicit FirstApp(bool headless = false);
 
         ~FirstApp();
 
@@ -30,15 +40,60 @@ namespace lve {
 
 	    FirstApp &operator=(const FirstApp &) = delete;
 
+	    // Records every presented frame; takes effect on the next run()
+	    void setFrameCapture(LveFrameCapture::Settings settings) { m_captureSettings_ = std::move(settings); }
+
+	    // Makes run() render the regression shots instead of following the keyboard, then check them. When
+	    // settings has no shots, default ones are used and a few objects are added to the scene for them.
+	    void setFrameRegression(LveFrameRegression::Settings settings);
+
+	    // Steps per second of the simulation, independent of the rate frames are rendered at
+	    void setSimulationRate(float stepsPerSecond) { m_simulationStep_ = 1.f / stepsPerSecond; }
+
+	    // Streams a KTX2 texture in during run()
+	    void addTexture(const std::string &path) { m_texturePaths_.push_back(path); }
+
 	    void run();
 
+	    // Null once the object has been destroyed
+	    LveGameObject *findGameObject(LveGameObject::id_t id);
+
+	    void destroyGameObject(LveGameObject::id_t id);
+
     private:
+	    // Render layer of the objects only regression runs add to the scene
+	    static constexpr uint32_t m_regressionLayer = 2u;
+
 	    void loadGameObjects();
 
-	    LveWindow m_lveWindow_{m_width, m_height, "Hello Vulkan!"};
+	    // Adds objects in m_regressionLayer, so the default shots cover blending and occlusion as well
+	    void loadRegressionObjects();
+
+	    // Gives object a root scene node and records its position in m_gameObjects_ as the value of its id
+	    void addGameObject(LveGameObject object);
+
+	    // Pushes the local transforms of the game objects through the scene graph into their world matrices
+	    void updateTransforms();
+
+	    // Copies what the render thread needs of the game objects and the camera, blended alpha of the way from
+	    // the previous simulation step to the current one
+	    void writeSnapshot(FrameSnapshot &snapshot,
+	                       float frameTime,
+	                       float alpha,
+	                       const TransformComponent &previousViewer,
+	                       const LveGameObject &viewerObject) const;
+
+	    LveWindow m_lveWindow_;
 	    LveDevice m_lveDevice_{m_lveWindow_};
 	    LveRenderer m_lveRenderer_{m_lveWindow_, m_lveDevice_};
+	    LvePipelineCompiler m_pipelineCompiler_{m_lveDevice_};
+	    LveJobSystem m_jobSystem_;
+	    LveSceneGraph m_sceneGraph_{&m_jobSystem_};
 	    std::vector<LveGameObject> m_gameObjects_;
+	    std::optional<LveFrameCapture::Settings> m_captureSettings_;
+	    std::optional<LveFrameRegression::Settings> m_regressionSettings_;
+	    std::vector<std::string> m_texturePaths_;
+	    float m_simulationStep_ = 1.f / 60.f;
     };
 }
 
@@ -0,0 +1,572 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "GpuDrivenRenderSystem.hpp"
+#include "LveFrustum.hpp"
+#include "LveShaderCode.hpp"
+#include "LveShaderReflection.hpp"
+#include "LveSwapChain.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t cullWorkgroupSize = 64;
+		constexpr uint32_t initialObjectCapacity = 256;
+		constexpr uint32_t initialBatchCapacity = 16;
+
+		constexpr const char *vertFilePath = "src/shaders/gpu_driven.vert.spv";
+		constexpr const char *fragFilePath = "src/shaders/gpu_driven.frag.spv";
+		constexpr const char *cullFilePath = "src/shaders/gpu_cull.comp.spv";
+
+		// Mirrors ObjectData in gpu_cull.comp and gpu_driven.vert (std430)
+		struct GpuObjectData {
+			glm::mat4 m_model{1.f};
+			glm::vec4 m_boundingSphere{0.f};
+			glm::vec4 m_color{0.f};
+			uint32_t m_batch;
+			uint32_t m_drawSlot;
+			uint32_t m_pad0;
+			uint32_t m_pad1;
+		};
+
+		// Mirrors BatchData in gpu_cull.comp (std430)
+		struct GpuBatchData {
+			uint32_t m_indexCount;
+			uint32_t m_firstIndex;
+			int32_t m_vertexOffset;
+			uint32_t m_commandOffset;
+		};
+
+		// Mirrors CullData in gpu_cull.comp (std140)
+		struct GpuCullData {
+			glm::vec4 m_frustumPlanes[6];
+			glm::mat4 m_projectionView{1.f};
+			glm::mat4 m_previousProjectionView{1.f};
+			glm::vec2 m_pyramidSize{0.f};
+			uint32_t m_pyramidLevels;
+			uint32_t m_objectCount;
+			uint32_t m_compact;
+			uint32_t m_occlusion;
+			uint32_t m_commandCapacity;
+			uint32_t m_batchCapacity;
+		};
+
+		struct CullPushConstantData {
+			uint32_t m_phase;
+		};
+
+		struct DrawPushConstantData {
+			glm::mat4 m_projectionView{1.f};
+		};
+
+		static_assert(sizeof(GpuObjectData) == 112, "GpuObjectData must match the std430 layout in the shaders");
+		static_assert(sizeof(GpuCullData) == 256, "GpuCullData must match the std140 layout in gpu_cull.comp");
+		static_assert(sizeof(GpuBatchData) == 16, "GpuBatchData must match the std430 layout in gpu_cull.comp");
+		static_assert(sizeof(VkDrawIndexedIndirectCommand) == 20, "DrawCommand in gpu_cull.comp assumes 20 bytes");
+	}
+
+	GpuDrivenRenderSystem::GpuDrivenRenderSystem(LveDevice &device,
+	                                             const RenderTargetInfo &renderTarget,
+	                                             LvePipelineCompiler &pipelineCompiler,
+	                                             LveDeletionQueue &deletionQueue)
+			: m_lveDevice_{device},
+			  m_renderTarget_{renderTarget},
+			  m_pipelineCompiler_{pipelineCompiler},
+			  m_depthPyramid_{device, deletionQueue} {
+		createLayouts();
+		createDescriptorPool();
+		m_pipelines_ = compilePipelines();
+		createFrameResources();
+	}
+
+	GpuDrivenRenderSystem::~GpuDrivenRenderSystem() {
+		m_frames_.clear();
+		vkDestroyDescriptorPool(m_lveDevice_.device(), m_descriptorPool_, nullptr);
+	}
+
+	void GpuDrivenRenderSystem::createDescriptorPool() {
+		std::array<VkDescriptorPoolSize, 3> poolSizes{};
+		poolSizes[0] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 * LveSwapChain::m_maxFramesInFlight};
+		poolSizes[1] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, LveSwapChain::m_maxFramesInFlight};
+		poolSizes[2] = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::m_maxFramesInFlight};
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = LveSwapChain::m_maxFramesInFlight;
+
+		if (vkCreateDescriptorPool(m_lveDevice_.device(), &poolInfo, nullptr, &m_descriptorPool_) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor pool");
+		}
+	}
+
+	void GpuDrivenRenderSystem::createLayouts() {
+		// The cull shader and the vertex shader share set 0: objects, batches, draw commands, draw counts,
+		// depth pyramid, pending objects and cull data. Layouts are owned by the device's layout cache.
+		std::vector<ShaderReflection> graphicsShaders{reflectShaderFile(vertFilePath),
+		                                              reflectShaderFile(fragFilePath)};
+		std::vector<ShaderReflection> computeShaders{reflectShaderFile(cullFilePath)};
+
+		std::vector<ShaderReflection> allShaders{graphicsShaders};
+		allShaders.insert(allShaders.end(), computeShaders.begin(), computeShaders.end());
+
+		auto &layoutCache = m_lveDevice_.pipelineLayoutCache();
+		m_descriptorSetLayout_ = layoutCache.getDescriptorSetLayout(allShaders, 0);
+		m_graphicsPipelineLayout_ = layoutCache.getPipelineLayout(graphicsShaders, {m_descriptorSetLayout_});
+		m_computePipelineLayout_ = layoutCache.getPipelineLayout(computeShaders, {m_descriptorSetLayout_});
+	}
+
+	GpuDrivenRenderSystem::Pipelines GpuDrivenRenderSystem::compilePipelines() {
+#ifndef NDEBUG
+		assert(m_graphicsPipelineLayout_ != nullptr && "Cannot create pipeline before pipeline layout");
+#endif
+		RenderTargetInfo renderTarget = m_renderTarget_;
+		VkPipelineLayout graphicsPipelineLayout = m_graphicsPipelineLayout_;
+		VkPipelineLayout computePipelineLayout = m_computePipelineLayout_;
+
+		Pipelines pipelines{};
+		pipelines.m_graphics = m_pipelineCompiler_.compile(
+				vertFilePath,
+				fragFilePath,
+				[renderTarget, graphicsPipelineLayout](PipelineConfigInfo &pipelineConfig) {
+					LvePipeline::setRenderTarget(pipelineConfig, renderTarget);
+					pipelineConfig.m_pipelineLayout = graphicsPipelineLayout;
+				});
+		pipelines.m_cull = m_pipelineCompiler_.compileCompute(
+				cullFilePath,
+				[computePipelineLayout](ComputePipelineConfigInfo &cullConfig) {
+					cullConfig.m_pipelineLayout = computePipelineLayout;
+					cullConfig.m_localSizeX = cullWorkgroupSize;
+				});
+		return pipelines;
+	}
+
+	void GpuDrivenRenderSystem::reloadShaders(const std::vector<std::string> &changedShaders,
+	                                          LveDeletionQueue &deletionQueue) {
+		// Changes that arrive while a reload is compiling are picked up by the next one
+		m_reloadRequested_ |= std::any_of(changedShaders.begin(), changedShaders.end(),
+		                                  [](const std::string &shaderName) {
+			                                  return shaderName == LveShaderCode::shaderName(vertFilePath) ||
+			                                         shaderName == LveShaderCode::shaderName(fragFilePath) ||
+			                                         shaderName == LveShaderCode::shaderName(cullFilePath);
+		                                  });
+
+		if (m_pendingPipelines_) {
+			if (!m_pendingPipelines_->m_graphics.isReady() || !m_pendingPipelines_->m_cull.isReady()) {
+				return;
+			}
+
+			try {
+				m_pendingPipelines_->m_graphics.wait();
+				m_pendingPipelines_->m_cull.wait();
+				deletionQueue.retire(std::make_unique<Pipelines>(std::move(m_pipelines_)));
+				m_pipelines_ = std::move(*m_pendingPipelines_);
+			} catch (const std::exception &e) {
+				std::cerr << "Shader reload failed, keeping the previous pipelines: " << e.what() << std::endl;
+			}
+			m_pendingPipelines_.reset();
+		}
+
+		if (m_reloadRequested_) {
+			m_pendingPipelines_ = compilePipelines();
+			m_reloadRequested_ = false;
+		}
+	}
+
+	void GpuDrivenRenderSystem::createFrameResources() {
+		m_frames_.resize(LveSwapChain::m_maxFramesInFlight);
+
+		std::vector<VkDescriptorSetLayout> layouts(m_frames_.size(), m_descriptorSetLayout_);
+		std::vector<VkDescriptorSet> descriptorSets(m_frames_.size());
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_descriptorPool_;
+		allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+		allocInfo.pSetLayouts = layouts.data();
+
+		if (vkAllocateDescriptorSets(m_lveDevice_.device(), &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate descriptor sets");
+		}
+
+		for (size_t i = 0; i < m_frames_.size(); i++) {
+			m_frames_[i].m_descriptorSet = descriptorSets[i];
+			ensureCapacity(m_frames_[i], initialObjectCapacity, initialBatchCapacity);
+		}
+	}
+
+	void GpuDrivenRenderSystem::ensureCapacity(FrameResources &frame, uint32_t objectCount, uint32_t batchCount) {
+		if (objectCount <= frame.m_objectCapacity && batchCount <= frame.m_batchCapacity) {
+			return;
+		}
+
+		// Only called for the frame being recorded, whose previous submission has been waited on, so its
+		// buffers and descriptor set can be replaced.
+		uint32_t objectCapacity = std::max(frame.m_objectCapacity, initialObjectCapacity);
+		while (objectCapacity < objectCount) {
+			objectCapacity *= 2;
+		}
+		uint32_t batchCapacity = std::max(frame.m_batchCapacity, initialBatchCapacity);
+		while (batchCapacity < batchCount) {
+			batchCapacity *= 2;
+		}
+
+		frame.m_objectBuffer = std::make_unique<LveBuffer>(
+				m_lveDevice_,
+				sizeof(GpuObjectData),
+				objectCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		frame.m_objectBuffer->map();
+
+		frame.m_batchBuffer = std::make_unique<LveBuffer>(
+				m_lveDevice_,
+				sizeof(GpuBatchData),
+				batchCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		frame.m_batchBuffer->map();
+
+		// Commands and counts hold the early phase followed by the late phase
+		frame.m_drawCommandBuffer = std::make_unique<LveBuffer>(
+				m_lveDevice_,
+				sizeof(VkDrawIndexedIndirectCommand),
+				2 * objectCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		frame.m_drawCountBuffer = std::make_unique<LveBuffer>(
+				m_lveDevice_,
+				sizeof(uint32_t),
+				2 * batchCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		frame.m_pendingBuffer = std::make_unique<LveBuffer>(
+				m_lveDevice_,
+				sizeof(uint32_t),
+				objectCapacity,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		if (!frame.m_cullDataBuffer) {
+			frame.m_cullDataBuffer = std::make_unique<LveBuffer>(
+					m_lveDevice_,
+					sizeof(GpuCullData),
+					1,
+					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			);
+			frame.m_cullDataBuffer->map();
+		}
+
+		frame.m_objectCapacity = objectCapacity;
+		frame.m_batchCapacity = batchCapacity;
+		writeDescriptorSet(frame);
+	}
+
+	void GpuDrivenRenderSystem::writeDescriptorSet(FrameResources &frame) {
+		std::array<VkDescriptorBufferInfo, 7> bufferInfos{
+				frame.m_objectBuffer->descriptorInfo(),
+				frame.m_batchBuffer->descriptorInfo(),
+				frame.m_drawCommandBuffer->descriptorInfo(),
+				frame.m_drawCountBuffer->descriptorInfo(),
+				VkDescriptorBufferInfo{},
+				frame.m_pendingBuffer->descriptorInfo(),
+				frame.m_cullDataBuffer->descriptorInfo()
+		};
+		VkDescriptorImageInfo pyramidInfo{
+				m_depthPyramid_.getSampler(),
+				m_depthPyramid_.getImageView(),
+				VK_IMAGE_LAYOUT_GENERAL
+		};
+
+		std::vector<VkWriteDescriptorSet> writes;
+		for (uint32_t i = 0; i < bufferInfos.size(); i++) {
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = frame.m_descriptorSet;
+			write.dstBinding = i;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write.descriptorCount = 1;
+			write.pBufferInfo = &bufferInfos[i];
+
+			if (i == 4) {
+				// The pyramid only exists once the depth extent is known, see addRenderPasses
+				if (pyramidInfo.imageView == VK_NULL_HANDLE) {
+					continue;
+				}
+				write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				write.pBufferInfo = nullptr;
+				write.pImageInfo = &pyramidInfo;
+			} else if (i == 6) {
+				write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			}
+			writes.push_back(write);
+		}
+
+		vkUpdateDescriptorSets(m_lveDevice_.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		frame.m_pyramidView = pyramidInfo.imageView;
+	}
+
+	void GpuDrivenRenderSystem::addRenderPasses(LveRenderGraph &graph,
+	                                            FrameInfo &frameInfo,
+	                                            const std::vector<RenderObject> &renderObjects,
+	                                            RenderGraphResource color,
+	                                            RenderGraphResource depth) {
+		// A resize does not wait for the device; the old pyramid stays alive until the frames in flight
+		// are done with it, and each frame's set moves to the new one once that frame has completed
+		if (m_depthPyramid_.resize(graph.getImage(depth).m_extent)) {
+			m_depthPyramidValid_ = false;
+		}
+
+		auto &frame = m_frames_[frameInfo.m_frameIndex];
+		if (frame.m_pyramidView != m_depthPyramid_.getImageView()) {
+			writeDescriptorSet(frame);
+		}
+		uploadGameObjects(frameInfo, frame, renderObjects);
+
+		auto drawCommands = graph.importBuffer("gpu draw commands", frame.m_drawCommandBuffer->getBuffer());
+		auto drawCount = graph.importBuffer("gpu draw count", frame.m_drawCountBuffer->getBuffer());
+		auto pending = graph.importBuffer("gpu pending objects", frame.m_pendingBuffer->getBuffer());
+		// Without valid contents the pyramid may just have been created, so its layout is not known yet
+		auto pyramid = graph.importImage("depth pyramid",
+		                                 {m_depthPyramid_.getImage(), m_depthPyramid_.getImageView(),
+		                                  m_depthPyramid_.getFormat(), m_depthPyramid_.getExtent()},
+		                                 m_depthPyramidValid_ ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED,
+		                                 VK_IMAGE_LAYOUT_GENERAL,
+		                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		                                 VK_ACCESS_SHADER_WRITE_BIT);
+
+		constexpr VkAccessFlags cullAccess = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		auto declareCull = [&](RenderGraphPassBuilder &pass) {
+			pass.writeBuffer(drawCommands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, cullAccess)
+					.writeBuffer(drawCount, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					             VK_ACCESS_TRANSFER_WRITE_BIT | cullAccess)
+					.writeBuffer(pending, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, cullAccess)
+					.sampledImage(pyramid, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_IMAGE_LAYOUT_GENERAL);
+		};
+		auto declareDraw = [&](RenderGraphPassBuilder &pass, VkAttachmentLoadOp loadOp) {
+			pass.colorAttachment(color, loadOp, {{0.01f, 0.01f, 0.01f, 1.0f}})
+					.depthAttachment(depth, loadOp)
+					.readBuffer(drawCommands, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT)
+					.readBuffer(drawCount, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+		};
+
+		const bool compact = m_lveDevice_.supportsDrawIndirectCount();
+		auto projectionView = frameInfo.m_camera.getProjection() * frameInfo.m_camera.getView();
+
+		graph.addPass("gpu cull", LveRenderGraph::PassType::Compute, declareCull,
+		              [this, &frame, compact](VkCommandBuffer commandBuffer) {
+			              if (frame.m_objectCount == 0) {
+				              return;
+			              }
+			              if (compact) {
+				              vkCmdFillBuffer(commandBuffer, frame.m_drawCountBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+				              LveComputePipeline::bufferBarrier(commandBuffer,
+				                                                frame.m_drawCountBuffer->getBuffer(),
+				                                                VK_PIPELINE_STAGE_TRANSFER_BIT,
+				                                                VK_ACCESS_TRANSFER_WRITE_BIT,
+				                                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				                                                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+			              }
+			              recordCull(commandBuffer, frame, EarlyPhase);
+		              });
+		graph.addPass("gpu draw", LveRenderGraph::PassType::Raster,
+		              [&](RenderGraphPassBuilder &pass) { declareDraw(pass, VK_ATTACHMENT_LOAD_OP_CLEAR); },
+		              [this, &frame, projectionView](VkCommandBuffer commandBuffer) {
+			              drawBatches(commandBuffer, frame, projectionView, EarlyPhase);
+		              });
+
+		if (!m_occlusionCulling) {
+			m_depthPyramidValid_ = false;
+			return;
+		}
+
+		// The pyramid built here is what the next frame's early cull tests against
+		const int frameIndex = frameInfo.m_frameIndex;
+		graph.addPass("depth pyramid", LveRenderGraph::PassType::Compute,
+		              [&](RenderGraphPassBuilder &pass) {
+			              pass.sampledImage(depth, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+					              .storageImage(pyramid, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, true);
+		              },
+		              [this, &graph, depth, frameIndex](VkCommandBuffer commandBuffer) {
+			              m_depthPyramid_.build(commandBuffer, frameIndex, graph.getImage(depth));
+		              });
+		m_depthPyramidValid_ = true;
+		m_depthPyramidProjectionView_ = projectionView;
+
+		graph.addPass("gpu cull occluded", LveRenderGraph::PassType::Compute, declareCull,
+		              [this, &frame](VkCommandBuffer commandBuffer) {
+			              if (frame.m_objectCount != 0) {
+				              recordCull(commandBuffer, frame, LatePhase);
+			              }
+		              });
+		graph.addPass("gpu draw occluded", LveRenderGraph::PassType::Raster,
+		              [&](RenderGraphPassBuilder &pass) { declareDraw(pass, VK_ATTACHMENT_LOAD_OP_LOAD); },
+		              [this, &frame, projectionView](VkCommandBuffer commandBuffer) {
+			              drawBatches(commandBuffer, frame, projectionView, LatePhase);
+		              });
+	}
+
+	void GpuDrivenRenderSystem::uploadGameObjects(FrameInfo &frameInfo,
+	                                              FrameResources &frame,
+	                                              const std::vector<RenderObject> &renderObjects) {
+		// Group objects per model; each batch gets a contiguous range of draw commands.
+		frame.m_batches.clear();
+		std::unordered_map<LveModel *, uint32_t> batchLookup;
+		uint32_t objectCount = 0;
+		for (auto &obj: renderObjects) {
+			if (!obj.m_model) {
+				continue;
+			}
+			if (!obj.m_model->hasIndexBuffer()) {
+				throw std::runtime_error("GPU-driven rendering requires indexed models");
+			}
+			auto [it, inserted] = batchLookup.try_emplace(obj.m_model.get(),
+			                                              static_cast<uint32_t>(frame.m_batches.size()));
+			if (inserted) {
+				frame.m_batches.push_back({obj.m_model.get(), 0, 0});
+			}
+			frame.m_batches[it->second].m_objectCount++;
+			objectCount++;
+		}
+
+		uint32_t commandOffset = 0;
+		for (auto &batch: frame.m_batches) {
+			batch.m_commandOffset = commandOffset;
+			commandOffset += batch.m_objectCount;
+		}
+
+		const auto batchCount = static_cast<uint32_t>(frame.m_batches.size());
+		ensureCapacity(frame, objectCount, batchCount);
+
+		auto *objects = static_cast<GpuObjectData *>(frame.m_objectBuffer->getMappedMemory());
+		std::vector<uint32_t> batchCursor(batchCount, 0);
+		uint32_t objectIndex = 0;
+		for (auto &obj: renderObjects) {
+			if (!obj.m_model) {
+				continue;
+			}
+			uint32_t batchIndex = batchLookup[obj.m_model.get()];
+
+			GpuObjectData &data = objects[objectIndex++];
+			data.m_model = obj.m_worldMatrix;
+			data.m_boundingSphere = obj.m_model->getBoundingSphere();
+			data.m_color = glm::vec4{obj.m_color, 1.f};
+			data.m_batch = batchIndex;
+			data.m_drawSlot = frame.m_batches[batchIndex].m_commandOffset + batchCursor[batchIndex]++;
+		}
+
+		auto *batches = static_cast<GpuBatchData *>(frame.m_batchBuffer->getMappedMemory());
+		for (uint32_t i = 0; i < batchCount; i++) {
+			batches[i] = {frame.m_batches[i].m_model->getIndexCount(), 0, 0, frame.m_batches[i].m_commandOffset};
+		}
+
+		frame.m_objectCount = objectCount;
+		if (objectCount == 0) {
+			return;
+		}
+
+		auto projectionView = frameInfo.m_camera.getProjection() * frameInfo.m_camera.getView();
+		auto frustum = LveFrustum::fromMatrix(projectionView);
+		const bool compact = m_lveDevice_.supportsDrawIndirectCount();
+
+		GpuCullData cullData{};
+		for (size_t i = 0; i < frustum.m_planes.size(); i++) {
+			cullData.m_frustumPlanes[i] = frustum.m_planes[i];
+		}
+		cullData.m_projectionView = projectionView;
+		cullData.m_previousProjectionView = m_depthPyramidProjectionView_;
+		cullData.m_pyramidSize = glm::vec2{
+				static_cast<float>(m_depthPyramid_.getExtent().width),
+				static_cast<float>(m_depthPyramid_.getExtent().height)};
+		cullData.m_pyramidLevels = m_depthPyramid_.getMipLevels();
+		cullData.m_objectCount = objectCount;
+		cullData.m_compact = compact ? 1 : 0;
+		cullData.m_occlusion = m_occlusionCulling && m_depthPyramidValid_ ? 1 : 0;
+		cullData.m_commandCapacity = frame.m_objectCapacity;
+		cullData.m_batchCapacity = frame.m_batchCapacity;
+		frame.m_cullDataBuffer->writeToBuffer(&cullData);
+	}
+
+	void GpuDrivenRenderSystem::recordCull(VkCommandBuffer commandBuffer, FrameResources &frame, CullPhase phase) {
+		CullPushConstantData push{phase};
+
+		auto &cullPipeline = m_pipelines_.m_cull.wait();
+		cullPipeline.bind(commandBuffer);
+		cullPipeline.bindDescriptorSets(commandBuffer, &frame.m_descriptorSet);
+		cullPipeline.pushConstants(commandBuffer, &push, sizeof(CullPushConstantData));
+		cullPipeline.dispatch(commandBuffer, frame.m_objectCount);
+	}
+
+	void GpuDrivenRenderSystem::drawBatches(VkCommandBuffer commandBuffer,
+	                                        FrameResources &frame,
+	                                        const glm::mat4 &projectionView,
+	                                        CullPhase phase) {
+		if (frame.m_objectCount == 0) {
+			return;
+		}
+
+		m_pipelines_.m_graphics.wait().bind(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer,
+		                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+		                        m_graphicsPipelineLayout_,
+		                        0, 1, &frame.m_descriptorSet,
+		                        0, nullptr);
+
+		DrawPushConstantData push{};
+		push.m_projectionView = projectionView;
+		vkCmdPushConstants(commandBuffer,
+		                   m_graphicsPipelineLayout_,
+		                   VK_SHADER_STAGE_VERTEX_BIT,
+		                   0,
+		                   sizeof(DrawPushConstantData),
+		                   &push);
+
+		constexpr auto stride = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand));
+		VkBuffer drawCommands = frame.m_drawCommandBuffer->getBuffer();
+		const VkDeviceSize commandBase = static_cast<VkDeviceSize>(phase) * frame.m_objectCapacity * stride;
+		const VkDeviceSize countBase = static_cast<VkDeviceSize>(phase) * frame.m_batchCapacity * sizeof(uint32_t);
+		for (size_t i = 0; i < frame.m_batches.size(); i++) {
+			const auto &batch = frame.m_batches[i];
+			VkDeviceSize offset = commandBase + static_cast<VkDeviceSize>(batch.m_commandOffset) * stride;
+
+			batch.m_model->bind(commandBuffer);
+			if (m_lveDevice_.supportsDrawIndirectCount()) {
+				m_lveDevice_.cmdDrawIndexedIndirectCount(commandBuffer,
+				                                         drawCommands, offset,
+				                                         frame.m_drawCountBuffer->getBuffer(),
+				                                         countBase + i * sizeof(uint32_t),
+				                                         batch.m_objectCount, stride);
+			} else if (m_lveDevice_.supportsMultiDrawIndirect()) {
+				vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, offset, batch.m_objectCount, stride);
+			} else {
+				for (uint32_t j = 0; j < batch.m_objectCount; j++) {
+					vkCmdDrawIndexedIndirect(commandBuffer, drawCommands, offset + j * stride, 1, stride);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,150 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_GPUDRIVENRENDERSYSTEM_HPP
+#define VULKAN_TEST_GPUDRIVENRENDERSYSTEM_HPP
+
+#include "LveBuffer.hpp"
+#include "LveComputePipeline.hpp"
+#include "LveDeletionQueue.hpp"
+#include "LveDepthPyramid.hpp"
+#include "LveDevice.hpp"
+#include "LveFrameInfo.hpp"
+#include "LveFrameSnapshot.hpp"
+#include "LvePipeline.hpp"
+#include "LvePipelineCompiler.hpp"
+#include "LveRenderGraph.hpp"
+#include "LveSwapChain.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Renders game objects without per-object CPU work in the command buffer: transforms and bounds are
+	// streamed into a storage buffer, a compute pass frustum and occlusion culls them and writes indirect
+	// draw commands, and each model is drawn with a single indirect call.
+	//
+	// Occlusion culling is two-phase. The early phase tests against the Hi-Z pyramid of the previous
+	// frame and draws what passes; the pyramid is then rebuilt from that depth and the late phase re-tests
+	// and draws the objects the early phase rejected.
+	class GpuDrivenRenderSystem {
+	public:
+		// deletionQueue must be the queue of the renderer recording the passes
+		GpuDrivenRenderSystem(LveDevice &device,
+		                      const RenderTargetInfo &renderTarget,
+		                      LvePipelineCompiler &pipelineCompiler,
+		                      LveDeletionQueue &deletionQueue);
+
+		~GpuDrivenRenderSystem();
+
+		GpuDrivenRenderSystem(const GpuDrivenRenderSystem &) = delete;
+
+		GpuDrivenRenderSystem &operator=(const GpuDrivenRenderSystem &) = delete;
+
+		// Requires firstInstance in indirect draws to carry the object index to the vertex shader.
+		static bool isSupported(LveDevice &device) { return device.supportsDrawIndirectFirstInstance(); }
+
+		// Uploads the objects and declares the culling and drawing passes, rendering into color and depth.
+		// With occlusion culling the late cull samples depth after the early draw, so it has to be sampleable.
+		void addRenderPasses(LveRenderGraph &graph,
+		                     FrameInfo &frameInfo,
+		                     const std::vector<RenderObject> &renderObjects,
+		                     RenderGraphResource color,
+		                     RenderGraphResource depth);
+
+		// Recompiles the graphics and cull pipelines when one of their shaders is in changedShaders, and swaps
+		// them in on a later call once compilation has finished, like RenderSystem::reloadShaders(). Must be
+		// called outside a render pass.
+		void reloadShaders(const std::vector<std::string> &changedShaders, LveDeletionQueue &deletionQueue);
+
+		bool m_occlusionCulling{true};
+
+	private:
+		enum CullPhase : uint32_t {
+			EarlyPhase = 0,
+			LatePhase = 1,
+		};
+
+		struct Pipelines {
+			LveAsyncPipeline<LvePipeline> m_graphics;
+			LveAsyncPipeline<LveComputePipeline> m_cull;
+		};
+
+		struct Batch {
+			LveModel *m_model;
+			uint32_t m_commandOffset;
+			uint32_t m_objectCount;
+		};
+
+		struct FrameResources {
+			std::unique_ptr<LveBuffer> m_objectBuffer;
+			std::unique_ptr<LveBuffer> m_batchBuffer;
+			std::unique_ptr<LveBuffer> m_drawCommandBuffer;
+			std::unique_ptr<LveBuffer> m_drawCountBuffer;
+			std::unique_ptr<LveBuffer> m_pendingBuffer;
+			std::unique_ptr<LveBuffer> m_cullDataBuffer;
+			VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+			// Pyramid the descriptor set refers to; the set is only rewritten when its own frame comes around
+			VkImageView m_pyramidView = VK_NULL_HANDLE;
+			uint32_t m_objectCapacity = 0;
+			uint32_t m_batchCapacity = 0;
+			uint32_t m_objectCount = 0;
+			std::vector<Batch> m_batches;
+		};
+
+		void createLayouts();
+
+		void createDescriptorPool();
+
+		Pipelines compilePipelines();
+
+		void createFrameResources();
+
+		void ensureCapacity(FrameResources &frame, uint32_t objectCount, uint32_t batchCount);
+
+		void writeDescriptorSet(FrameResources &frame);
+
+		void uploadGameObjects(FrameInfo &frameInfo,
+		                       FrameResources &frame,
+		                       const std::vector<RenderObject> &renderObjects);
+
+		void recordCull(VkCommandBuffer commandBuffer, FrameResources &frame, CullPhase phase);
+
+		void drawBatches(VkCommandBuffer commandBuffer,
+		                 FrameResources &frame,
+		                 const glm::mat4 &projectionView,
+		                 CullPhase phase);
+
+		LveDevice &m_lveDevice_;
+		VkDescriptorSetLayout m_descriptorSetLayout_;
+		VkDescriptorPool m_descriptorPool_;
+		VkPipelineLayout m_graphicsPipelineLayout_;
+		VkPipelineLayout m_computePipelineLayout_;
+		RenderTargetInfo m_renderTarget_;
+		LvePipelineCompiler &m_pipelineCompiler_;
+		Pipelines m_pipelines_;
+		std::optional<Pipelines> m_pendingPipelines_;
+		bool m_reloadRequested_ = false;
+		std::vector<FrameResources> m_frames_;
+
+		// One pyramid is carried from frame to frame, whatever frame in flight built it: the graph imports it
+		// as last written by a compute shader, so each frame's first use waits for the build submitted before
+		LveDepthPyramid m_depthPyramid_;
+		// Whether the pyramid holds the depth of the last frame declared, which m_depthPyramidProjectionView_
+		// was rendered with
+		bool m_depthPyramidValid_ = false;
+		glm::mat4 m_depthPyramidProjectionView_{1.f};
+	};
+}
+
+#endif //VULKAN_TEST_GPUDRIVENRENDERSYSTEM_HPP
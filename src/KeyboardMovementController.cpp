@@ -7,6 +7,11 @@
 
 namespace lve {
 	void KeyboardMovementController::moveInPlaneXZ(GLFWwindow *window, float dt, LveGameObject &gameObject) {
+		// A headless window has no keyboard
+		if (window == nullptr) {
+			return;
+		}
+
 		glm::vec3 rotate{0};
 		if (glfwGetKey(window, m_keys.lookRight) == GLFW_PRESS) rotate.y += 1.f;
 		if (glfwGetKey(window, m_keys.lookLeft) == GLFW_PRESS) rotate.y -= 1.f;
@@ -0,0 +1,130 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveBindlessHeap.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		// Upper bounds, the device limits usually allow far more but every slot costs descriptor memory
+		constexpr uint32_t maxBindlessTextures = 16384;
+		constexpr uint32_t maxBindlessBuffers = 4096;
+	}
+
+	LveSlotAllocator::LveSlotAllocator(uint32_t capacity) : m_capacity_{capacity} {
+		m_retiredSlots_.resize(LveSwapChain::m_maxFramesInFlight);
+	}
+
+	uint32_t LveSlotAllocator::allocate() {
+		uint32_t slot;
+		if (!m_freeSlots_.empty()) {
+			slot = m_freeSlots_.back();
+			m_freeSlots_.pop_back();
+		} else if (m_nextSlot_ < m_capacity_) {
+			slot = m_nextSlot_++;
+		} else {
+			throw std::runtime_error("Bindless descriptor heap is full");
+		}
+		m_allocatedCount_++;
+		return slot;
+	}
+
+	void LveSlotAllocator::release(uint32_t slot) {
+#ifndef NDEBUG
+		assert(slot < m_nextSlot_ && "Releasing a slot that was never allocated");
+#endif
+		m_retiredSlots_[m_frameIndex_].push_back(slot);
+		m_allocatedCount_--;
+	}
+
+	void LveSlotAllocator::beginFrame(int frameIndex) {
+		m_frameIndex_ = frameIndex;
+		auto &retired = m_retiredSlots_[frameIndex];
+		m_freeSlots_.insert(m_freeSlots_.end(), retired.begin(), retired.end());
+		retired.clear();
+	}
+
+	LveBindlessHeap::LveBindlessHeap(LveDevice &device)
+			: m_lveDevice_{device},
+			  m_textureSlots_{std::min(device.maxBindlessSampledImages(), maxBindlessTextures)},
+			  m_bufferSlots_{std::min(device.maxBindlessStorageBuffers(), maxBindlessBuffers)} {
+		if (!isSupported(device)) {
+			throw std::runtime_error("Bindless descriptors require Vulkan 1.2 descriptor indexing");
+		}
+
+		constexpr VkDescriptorBindingFlags bindingFlags =
+				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+				VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+				VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		constexpr VkShaderStageFlags stages =
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+		m_setLayout_ = LveDescriptorSetLayout::Builder(m_lveDevice_)
+				.addBinding(m_textureBinding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, stages,
+				            m_textureSlots_.capacity(), bindingFlags)
+				.addBinding(m_bufferBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages,
+				            m_bufferSlots_.capacity(), bindingFlags)
+				.build();
+
+		m_descriptorPool_ = LveDescriptorPool::Builder(m_lveDevice_)
+				.setMaxSets(1)
+				.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+				.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_textureSlots_.capacity())
+				.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_bufferSlots_.capacity())
+				.build();
+
+		if (!m_descriptorPool_->allocateDescriptorSet(m_setLayout_->getDescriptorSetLayout(), m_descriptorSet_)) {
+			throw std::runtime_error("Failed to allocate bindless descriptor set");
+		}
+	}
+
+	void LveBindlessHeap::beginFrame(int frameIndex) {
+		m_textureSlots_.beginFrame(frameIndex);
+		m_bufferSlots_.beginFrame(frameIndex);
+	}
+
+	uint32_t LveBindlessHeap::addTexture(VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout) {
+		uint32_t handle = m_textureSlots_.allocate();
+		VkDescriptorImageInfo imageInfo{sampler, imageView, imageLayout};
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descriptorSet_;
+		write.dstBinding = m_textureBinding;
+		write.dstArrayElement = handle;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount = 1;
+		write.pImageInfo = &imageInfo;
+		vkUpdateDescriptorSets(m_lveDevice_.device(), 1, &write, 0, nullptr);
+		return handle;
+	}
+
+	uint32_t LveBindlessHeap::addBuffer(const VkDescriptorBufferInfo &bufferInfo) {
+		uint32_t handle = m_bufferSlots_.allocate();
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descriptorSet_;
+		write.dstBinding = m_bufferBinding;
+		write.dstArrayElement = handle;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.descriptorCount = 1;
+		write.pBufferInfo = &bufferInfo;
+		vkUpdateDescriptorSets(m_lveDevice_.device(), 1, &write, 0, nullptr);
+		return handle;
+	}
+
+	void LveBindlessHeap::bind(VkCommandBuffer commandBuffer,
+	                           VkPipelineBindPoint bindPoint,
+	                           VkPipelineLayout pipelineLayout,
+	                           uint32_t set) const {
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, set, 1, &m_descriptorSet_, 0, nullptr);
+	}
+}
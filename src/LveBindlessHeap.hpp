@@ -0,0 +1,92 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEBINDLESSHEAP_HPP
+#define VULKAN_TEST_LVEBINDLESSHEAP_HPP
+
+#include "LveDescriptors.hpp"
+#include "LveDevice.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// Hands out indices into a fixed size array. Released slots are only reused once every frame in flight
+	// that could still reference them has completed.
+	class LveSlotAllocator {
+	public:
+		explicit LveSlotAllocator(uint32_t capacity);
+
+		uint32_t allocate();
+
+		void release(uint32_t slot);
+
+		// Recycles the slots released the last time this frame index was recorded
+		void beginFrame(int frameIndex);
+
+		uint32_t capacity() const { return m_capacity_; }
+
+		uint32_t allocatedCount() const { return m_allocatedCount_; }
+
+	private:
+		uint32_t m_capacity_;
+		uint32_t m_nextSlot_ = 0;
+		uint32_t m_allocatedCount_ = 0;
+		int m_frameIndex_ = 0;
+		std::vector<uint32_t> m_freeSlots_;
+		std::vector<std::vector<uint32_t>> m_retiredSlots_;
+	};
+
+	// One global descriptor set with large arrays of sampled images and storage buffers. Shaders index them
+	// with handles passed per object, so render systems bind it once per pipeline layout instead of binding
+	// descriptor sets per draw.
+	//
+	// Requires LveDevice::supportsDescriptorIndexing(); slots are written with update-after-bind while the
+	// set is bound in command buffers that are still executing.
+	class LveBindlessHeap {
+	public:
+		static constexpr uint32_t m_textureBinding = 0;
+		static constexpr uint32_t m_bufferBinding = 1;
+
+		explicit LveBindlessHeap(LveDevice &device);
+
+		LveBindlessHeap(const LveBindlessHeap &) = delete;
+
+		LveBindlessHeap &operator=(const LveBindlessHeap &) = delete;
+
+		static bool isSupported(LveDevice &device) { return device.supportsDescriptorIndexing(); }
+
+		void beginFrame(int frameIndex);
+
+		uint32_t addTexture(VkImageView imageView,
+		                    VkSampler sampler,
+		                    VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		uint32_t addBuffer(const VkDescriptorBufferInfo &bufferInfo);
+
+		// The descriptor is left in place; the slot is handed out again once no frame in flight can use it
+		void removeTexture(uint32_t handle) { m_textureSlots_.release(handle); }
+
+		void removeBuffer(uint32_t handle) { m_bufferSlots_.release(handle); }
+
+		void bind(VkCommandBuffer commandBuffer,
+		          VkPipelineBindPoint bindPoint,
+		          VkPipelineLayout pipelineLayout,
+		          uint32_t set) const;
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return m_setLayout_->getDescriptorSetLayout(); }
+
+	private:
+		LveDevice &m_lveDevice_;
+		LveSlotAllocator m_textureSlots_;
+		LveSlotAllocator m_bufferSlots_;
+		std::unique_ptr<LveDescriptorSetLayout> m_setLayout_;
+		std::unique_ptr<LveDescriptorPool> m_descriptorPool_;
+		VkDescriptorSet m_descriptorSet_ = VK_NULL_HANDLE;
+	};
+}
+
+#endif //VULKAN_TEST_LVEBINDLESSHEAP_HPP
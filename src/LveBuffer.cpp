@@ -0,0 +1,87 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveBuffer.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+
+namespace lve {
+
+	VkDeviceSize LveBuffer::getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment) {
+		if (minOffsetAlignment > 0) {
+			return (instanceSize + minOffsetAlignment - 1) & ~(minOffsetAlignment - 1);
+		}
+		return instanceSize;
+	}
+
+	LveBuffer::LveBuffer(
+			LveDevice &device,
+			VkDeviceSize instanceSize,
+			uint32_t instanceCount,
+			VkBufferUsageFlags usageFlags,
+			VkMemoryPropertyFlags memoryPropertyFlags,
+			VkDeviceSize minOffsetAlignment)
+			: m_lveDevice_{device},
+			  m_instanceCount_{instanceCount},
+			  m_instanceSize_{instanceSize} {
+		m_alignmentSize_ = getAlignment(instanceSize, minOffsetAlignment);
+		m_bufferSize_ = m_alignmentSize_ * instanceCount;
+		m_lveDevice_.createBuffer(m_bufferSize_, usageFlags, memoryPropertyFlags, m_buffer_, m_memory_);
+	}
+
+	LveBuffer::~LveBuffer() {
+		unmap();
+		vkDestroyBuffer(m_lveDevice_.device(), m_buffer_, nullptr);
+		vkFreeMemory(m_lveDevice_.device(), m_memory_, nullptr);
+	}
+
+	VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
+#ifndef NDEBUG
+		assert(m_buffer_ && m_memory_ && "Called map on buffer before create");
+#endif
+		return vkMapMemory(m_lveDevice_.device(), m_memory_, offset, size, 0, &m_mapped_);
+	}
+
+	void LveBuffer::unmap() {
+		if (m_mapped_) {
+			vkUnmapMemory(m_lveDevice_.device(), m_memory_);
+			m_mapped_ = nullptr;
+		}
+	}
+
+	void LveBuffer::writeToBuffer(const void *data, VkDeviceSize size, VkDeviceSize offset) {
+#ifndef NDEBUG
+		assert(m_mapped_ && "Cannot copy to unmapped buffer");
+#endif
+		if (size == VK_WHOLE_SIZE) {
+			memcpy(m_mapped_, data, m_bufferSize_);
+		} else {
+			auto *memOffset = static_cast<char *>(m_mapped_) + offset;
+			memcpy(memOffset, data, size);
+		}
+	}
+
+	VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
+		VkMappedMemoryRange mappedRange = {};
+		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		mappedRange.memory = m_memory_;
+		mappedRange.offset = offset;
+		mappedRange.size = size;
+		return vkFlushMappedMemoryRanges(m_lveDevice_.device(), 1, &mappedRange);
+	}
+
+	VkDescriptorBufferInfo LveBuffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) const {
+		return VkDescriptorBufferInfo{m_buffer_, offset, size};
+	}
+
+	void LveBuffer::writeToIndex(const void *data, uint32_t index) {
+		writeToBuffer(data, m_instanceSize_, index * m_alignmentSize_);
+	}
+
+	VkDescriptorBufferInfo LveBuffer::descriptorInfoForIndex(uint32_t index) const {
+		return descriptorInfo(m_alignmentSize_, index * m_alignmentSize_);
+	}
+}
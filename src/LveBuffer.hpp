@@ -0,0 +1,71 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEBUFFER_HPP
+#define VULKAN_TEST_LVEBUFFER_HPP
+
+#include "LveDevice.hpp"
+
+namespace lve {
+
+	// A VkBuffer and its memory, laid out as instanceCount instances of instanceSize bytes, each aligned to
+	// minOffsetAlignment so individual instances can be bound with descriptor offsets.
+	class LveBuffer {
+	public:
+		LveBuffer(
+				LveDevice &device,
+				VkDeviceSize instanceSize,
+				uint32_t instanceCount,
+				VkBufferUsageFlags usageFlags,
+				VkMemoryPropertyFlags memoryPropertyFlags,
+				VkDeviceSize minOffsetAlignment = 1);
+
+		~LveBuffer();
+
+		LveBuffer(const LveBuffer &) = delete;
+
+		LveBuffer &operator=(const LveBuffer &) = delete;
+
+		VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+		void unmap();
+
+		void writeToBuffer(const void *data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+		VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+		VkDescriptorBufferInfo descriptorInfo(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+
+		void writeToIndex(const void *data, uint32_t index);
+
+		VkDescriptorBufferInfo descriptorInfoForIndex(uint32_t index) const;
+
+		VkBuffer getBuffer() const { return m_buffer_; }
+
+		void *getMappedMemory() const { return m_mapped_; }
+
+		uint32_t getInstanceCount() const { return m_instanceCount_; }
+
+		VkDeviceSize getInstanceSize() const { return m_instanceSize_; }
+
+		VkDeviceSize getAlignmentSize() const { return m_alignmentSize_; }
+
+		VkDeviceSize getBufferSize() const { return m_bufferSize_; }
+
+	private:
+		static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+
+		LveDevice &m_lveDevice_;
+		void *m_mapped_ = nullptr;
+		VkBuffer m_buffer_ = VK_NULL_HANDLE;
+		VkDeviceMemory m_memory_ = VK_NULL_HANDLE;
+
+		VkDeviceSize m_bufferSize_;
+		uint32_t m_instanceCount_;
+		VkDeviceSize m_instanceSize_;
+		VkDeviceSize m_alignmentSize_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEBUFFER_HPP
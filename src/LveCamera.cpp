@@ -40,19 +40,7 @@ namespace lve {
 		const glm::vec3 u{glm::normalize(glm::cross(w, up))};
 		const glm::vec3 v{glm::cross(w, u)};
 
-		m_viewMatrix_ = glm::mat4{1.f};
-		m_viewMatrix_[0][0] = u.x;
-		m_viewMatrix_[1][0] = u.y;
-		m_viewMatrix_[2][0] = u.z;
-		m_viewMatrix_[0][1] = v.x;
-		m_viewMatrix_[1][1] = v.y;
-		m_viewMatrix_[2][1] = v.z;
-		m_viewMatrix_[0][2] = w.x;
-		m_viewMatrix_[1][2] = w.y;
-		m_viewMatrix_[2][2] = w.z;
-		m_viewMatrix_[3][0] = -glm::dot(u, position);
-		m_viewMatrix_[3][1] = -glm::dot(v, position);
-		m_viewMatrix_[3][2] = -glm::dot(w, position);
+		setViewBasis(position, u, v, w);
 	}
 
 	void LveCamera::setViewTarget(glm::vec3 position, glm::vec3 target, glm::vec3 up) {
@@ -69,6 +57,10 @@ namespace lve {
 		const glm::vec3 u{(c1 * c3 + s1 * s2 * s3), (c2 * s3), (c1 * s2 * s3 - c3 * s1)};
 		const glm::vec3 v{(c3 * s1 * s2 - c1 * s3), (c2 * c3), (c1 * c3 * s2 + s1 * s3)};
 		const glm::vec3 w{(c2 * s1), (-s2), (c1 * c2)};
+		setViewBasis(position, u, v, w);
+	}
+
+	void LveCamera::setViewBasis(glm::vec3 position, glm::vec3 u, glm::vec3 v, glm::vec3 w) {
 		m_viewMatrix_ = glm::mat4{1.f};
 		m_viewMatrix_[0][0] = u.x;
 		m_viewMatrix_[1][0] = u.y;
@@ -82,6 +74,20 @@ namespace lve {
 		m_viewMatrix_[3][0] = -glm::dot(u, position);
 		m_viewMatrix_[3][1] = -glm::dot(v, position);
 		m_viewMatrix_[3][2] = -glm::dot(w, position);
+
+		m_inverseViewMatrix_ = glm::mat4{1.f};
+		m_inverseViewMatrix_[0][0] = u.x;
+		m_inverseViewMatrix_[0][1] = u.y;
+		m_inverseViewMatrix_[0][2] = u.z;
+		m_inverseViewMatrix_[1][0] = v.x;
+		m_inverseViewMatrix_[1][1] = v.y;
+		m_inverseViewMatrix_[1][2] = v.z;
+		m_inverseViewMatrix_[2][0] = w.x;
+		m_inverseViewMatrix_[2][1] = w.y;
+		m_inverseViewMatrix_[2][2] = w.z;
+		m_inverseViewMatrix_[3][0] = position.x;
+		m_inverseViewMatrix_[3][1] = position.y;
+		m_inverseViewMatrix_[3][2] = position.z;
 	}
 
 }
\ No newline at end of file
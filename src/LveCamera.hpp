@@ -33,9 +33,17 @@ namespace lve {
 
 		const glm::mat4 &getView() const { return m_viewMatrix_; }
 
+		const glm::mat4 &getInverseView() const { return m_inverseViewMatrix_; }
+
+		glm::vec3 getPosition() const { return glm::vec3{m_inverseViewMatrix_[3]}; }
+
 	private:
+		// u, v and w are the orthonormal right, down and forward axes of the camera in world space
+		void setViewBasis(glm::vec3 position, glm::vec3 u, glm::vec3 v, glm::vec3 w);
+
 		glm::mat4 m_projectionMatrix_{1.f};
 		glm::mat4 m_viewMatrix_{1.f};
+		glm::mat4 m_inverseViewMatrix_{1.f};
 	};
 
 }
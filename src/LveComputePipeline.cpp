@@ -0,0 +1,127 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveComputePipeline.hpp"
+#include "LvePipeline.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	LveComputePipeline::LveComputePipeline(LveDevice &device,
+	                                       const std::string &compFilePath,
+	                                       const ComputePipelineConfigInfo &configInfo) : m_lveDevice_{device} {
+		createComputePipeline(compFilePath, configInfo);
+	}
+
+	LveComputePipeline::~LveComputePipeline() {
+		vkDestroyPipeline(m_lveDevice_.device(), m_computePipeline_, nullptr);
+	}
+
+	void LveComputePipeline::createComputePipeline(const std::string &compFilePath,
+	                                               const ComputePipelineConfigInfo &configInfo) {
+#ifndef NDEBUG
+		assert(
+				configInfo.m_pipelineLayout != VK_NULL_HANDLE &&
+				"Cannot create compute pipeline: no m_pipelineLayout provided in config_info");
+		assert(
+				configInfo.m_localSizeX > 0 && configInfo.m_localSizeY > 0 && configInfo.m_localSizeZ > 0 &&
+				"Cannot create compute pipeline: workgroup size must be at least 1");
+#endif
+		m_pipelineLayout_ = configInfo.m_pipelineLayout;
+		m_localSize_[0] = configInfo.m_localSizeX;
+		m_localSize_[1] = configInfo.m_localSizeY;
+		m_localSize_[2] = configInfo.m_localSizeZ;
+
+		auto compCode = LveShaderCode::load(compFilePath);
+		LveShaderStageModule compModule{m_lveDevice_.shaderModuleCache(), compCode};
+
+		std::vector<VkSpecializationMapEntry> mapEntries;
+		VkSpecializationInfo specialization = configInfo.m_specialization.getInfo(mapEntries);
+
+		VkPipelineShaderStageCreateInfo shaderStage{};
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.pName = "main";
+		shaderStage.flags = 0;
+		shaderStage.pNext = nullptr;
+		compModule.fill(shaderStage);
+		shaderStage.pSpecializationInfo = configInfo.m_specialization.empty() ? nullptr : &specialization;
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shaderStage;
+		pipelineInfo.layout = configInfo.m_pipelineLayout;
+		pipelineInfo.basePipelineIndex = -1;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		if (vkCreateComputePipelines(m_lveDevice_.device(), m_lveDevice_.pipelineCache(), 1, &pipelineInfo, nullptr,
+		                             &m_computePipeline_) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create compute pipeline.");
+		}
+	}
+
+	void LveComputePipeline::bind(VkCommandBuffer commandBuffer) {
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline_);
+	}
+
+	void LveComputePipeline::bindDescriptorSets(VkCommandBuffer commandBuffer,
+	                                            const VkDescriptorSet *descriptorSets,
+	                                            uint32_t descriptorSetCount,
+	                                            uint32_t firstSet) {
+		vkCmdBindDescriptorSets(commandBuffer,
+		                        VK_PIPELINE_BIND_POINT_COMPUTE,
+		                        m_pipelineLayout_,
+		                        firstSet, descriptorSetCount, descriptorSets,
+		                        0, nullptr);
+	}
+
+	void LveComputePipeline::pushConstants(VkCommandBuffer commandBuffer,
+	                                       const void *data,
+	                                       uint32_t size,
+	                                       uint32_t offset) {
+		vkCmdPushConstants(commandBuffer, m_pipelineLayout_, VK_SHADER_STAGE_COMPUTE_BIT, offset, size, data);
+	}
+
+	void LveComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t width, uint32_t height, uint32_t depth) {
+		vkCmdDispatch(commandBuffer,
+		              (width + m_localSize_[0] - 1) / m_localSize_[0],
+		              (height + m_localSize_[1] - 1) / m_localSize_[1],
+		              (depth + m_localSize_[2] - 1) / m_localSize_[2]);
+	}
+
+	void LveComputePipeline::memoryBarrier(VkCommandBuffer commandBuffer,
+	                                       VkPipelineStageFlags srcStageMask,
+	                                       VkAccessFlags srcAccessMask,
+	                                       VkPipelineStageFlags dstStageMask,
+	                                       VkAccessFlags dstAccessMask) {
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	void LveComputePipeline::bufferBarrier(VkCommandBuffer commandBuffer,
+	                                       VkBuffer buffer,
+	                                       VkPipelineStageFlags srcStageMask,
+	                                       VkAccessFlags srcAccessMask,
+	                                       VkPipelineStageFlags dstStageMask,
+	                                       VkAccessFlags dstAccessMask,
+	                                       uint32_t srcQueueFamilyIndex,
+	                                       uint32_t dstQueueFamilyIndex) {
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+		barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+}
@@ -0,0 +1,89 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVECOMPUTEPIPELINE_HPP
+#define VULKAN_TEST_LVECOMPUTEPIPELINE_HPP
+
+#include "LveDevice.hpp"
+#include "LveShaderCode.hpp"
+#include "LveSpecializationConstants.hpp"
+
+// std
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	struct ComputePipelineConfigInfo {
+		ComputePipelineConfigInfo() = default;
+
+		ComputePipelineConfigInfo(const ComputePipelineConfigInfo &) = delete;
+
+		ComputePipelineConfigInfo &operator=(const ComputePipelineConfigInfo &) = delete;
+
+		// Not owned by the pipeline, so several compute pipelines can share one layout and descriptor sets
+		VkPipelineLayout m_pipelineLayout = nullptr;
+
+		// Must match local_size_x/y/z of the shader, used by LveComputePipeline::dispatch
+		uint32_t m_localSizeX = 1;
+		uint32_t m_localSizeY = 1;
+		uint32_t m_localSizeZ = 1;
+
+		SpecializationConstants m_specialization;
+	};
+
+	class LveComputePipeline {
+	public:
+		LveComputePipeline(LveDevice &device,
+		                   const std::string &compFilePath,
+		                   const ComputePipelineConfigInfo &configInfo);
+
+		~LveComputePipeline();
+
+		LveComputePipeline(const LveComputePipeline &) = delete;
+
+		LveComputePipeline &operator=(const LveComputePipeline &) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+
+		void bindDescriptorSets(VkCommandBuffer commandBuffer,
+		                        const VkDescriptorSet *descriptorSets,
+		                        uint32_t descriptorSetCount = 1,
+		                        uint32_t firstSet = 0);
+
+		void pushConstants(VkCommandBuffer commandBuffer, const void *data, uint32_t size, uint32_t offset = 0);
+
+		// Dispatches enough workgroups to cover width x height x depth invocations
+		void dispatch(VkCommandBuffer commandBuffer, uint32_t width, uint32_t height = 1, uint32_t depth = 1);
+
+		VkPipelineLayout getPipelineLayout() const { return m_pipelineLayout_; }
+
+		static void memoryBarrier(VkCommandBuffer commandBuffer,
+		                          VkPipelineStageFlags srcStageMask,
+		                          VkAccessFlags srcAccessMask,
+		                          VkPipelineStageFlags dstStageMask,
+		                          VkAccessFlags dstAccessMask);
+
+		// With distinct queue families this records one half of a queue family ownership transfer, it
+		// has to be recorded on both the releasing and the acquiring queue.
+		static void bufferBarrier(VkCommandBuffer commandBuffer,
+		                          VkBuffer buffer,
+		                          VkPipelineStageFlags srcStageMask,
+		                          VkAccessFlags srcAccessMask,
+		                          VkPipelineStageFlags dstStageMask,
+		                          VkAccessFlags dstAccessMask,
+		                          uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		                          uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+
+	private:
+		void createComputePipeline(const std::string &compFilePath, const ComputePipelineConfigInfo &configInfo);
+
+		LveDevice &m_lveDevice_;
+		VkPipeline m_computePipeline_;
+		VkPipelineLayout m_pipelineLayout_;
+		uint32_t m_localSize_[3];
+	};
+}
+
+#endif //VULKAN_TEST_LVECOMPUTEPIPELINE_HPP
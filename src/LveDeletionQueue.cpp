@@ -0,0 +1,36 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveDeletionQueue.hpp"
+#include "LveSwapChain.hpp"
+
+namespace lve {
+
+	LveDeletionQueue::LveDeletionQueue() {
+		m_deleters_.resize(LveSwapChain::m_maxFramesInFlight);
+	}
+
+	LveDeletionQueue::~LveDeletionQueue() {
+		for (auto &deleters: m_deleters_) {
+			flush(deleters);
+		}
+	}
+
+	void LveDeletionQueue::push(std::function<void()> deleter) {
+		m_deleters_[m_frameIndex_].push_back(std::move(deleter));
+	}
+
+	void LveDeletionQueue::beginFrame(int frameIndex) {
+		m_frameIndex_ = frameIndex;
+		flush(m_deleters_[frameIndex]);
+	}
+
+	void LveDeletionQueue::flush(std::vector<std::function<void()>> &deleters) {
+		// Destroy in reverse order of retirement, like scoped objects
+		for (auto it = deleters.rbegin(); it != deleters.rend(); ++it) {
+			(*it)();
+		}
+		deleters.clear();
+	}
+}
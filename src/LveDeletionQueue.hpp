@@ -0,0 +1,48 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEDELETIONQUEUE_HPP
+#define VULKAN_TEST_LVEDELETIONQUEUE_HPP
+
+// std
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// Defers destroying GPU objects until no frame in flight can still use them. Deleters pushed while a
+	// frame is being recorded run when that frame index begins again, after its fence has been waited on.
+	class LveDeletionQueue {
+	public:
+		LveDeletionQueue();
+
+		// Runs every pending deleter; the owner must have waited for the device to become idle
+		~LveDeletionQueue();
+
+		LveDeletionQueue(const LveDeletionQueue &) = delete;
+
+		LveDeletionQueue &operator=(const LveDeletionQueue &) = delete;
+
+		void push(std::function<void()> deleter);
+
+		template<typename T>
+		void retire(std::unique_ptr<T> object) {
+			if (object) {
+				T *retired = object.release();
+				push([retired]() { delete retired; });
+			}
+		}
+
+		void beginFrame(int frameIndex);
+
+	private:
+		void flush(std::vector<std::function<void()>> &deleters);
+
+		std::vector<std::vector<std::function<void()>>> m_deleters_;
+		int m_frameIndex_ = 0;
+	};
+}
+
+#endif //VULKAN_TEST_LVEDELETIONQUEUE_HPP
@@ -0,0 +1,261 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveDepthPyramid.hpp"
+#include "LveShaderReflection.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t downsampleWorkgroupSize = 8;
+
+		struct DownsamplePushConstantData {
+			int32_t m_inputWidth;
+			int32_t m_inputHeight;
+			int32_t m_outputWidth;
+			int32_t m_outputHeight;
+		};
+
+		uint32_t previousPowerOfTwo(uint32_t value) {
+			uint32_t result = 1;
+			while (result * 2 <= value) {
+				result *= 2;
+			}
+			return result;
+		}
+	}
+
+	LveDepthPyramid::Pyramid::~Pyramid() {
+		if (m_image == VK_NULL_HANDLE) {
+			return;
+		}
+
+		vkDestroyDescriptorPool(m_device.device(), m_descriptorPool, nullptr);
+		for (auto view: m_mipViews) {
+			vkDestroyImageView(m_device.device(), view, nullptr);
+		}
+		vkDestroyImageView(m_device.device(), m_imageView, nullptr);
+		vkDestroyImage(m_device.device(), m_image, nullptr);
+		vkFreeMemory(m_device.device(), m_imageMemory, nullptr);
+	}
+
+	LveDepthPyramid::LveDepthPyramid(LveDevice &device, LveDeletionQueue &deletionQueue)
+			: m_lveDevice_{device}, m_deletionQueue_{deletionQueue} {
+		createSampler();
+		createPipeline();
+	}
+
+	LveDepthPyramid::~LveDepthPyramid() {
+		m_pyramid_.reset();
+		m_downsamplePipeline_.reset();
+		vkDestroySampler(m_lveDevice_.device(), m_sampler_, nullptr);
+	}
+
+	void LveDepthPyramid::createSampler() {
+		// All reads use texelFetch, the sampler only exists to satisfy the combined image sampler binding
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.minLod = 0.f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		if (vkCreateSampler(m_lveDevice_.device(), &samplerInfo, nullptr, &m_sampler_) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create depth pyramid sampler");
+		}
+	}
+
+	void LveDepthPyramid::createPipeline() {
+		// Layouts are built from the shader interface and owned by the device's layout cache
+		std::vector<ShaderReflection> shaders{reflectShaderFile("src/shaders/depth_pyramid.comp.spv")};
+		auto &layoutCache = m_lveDevice_.pipelineLayoutCache();
+		m_descriptorSetLayout_ = layoutCache.getDescriptorSetLayout(shaders, 0);
+		m_pipelineLayout_ = layoutCache.getPipelineLayout(shaders, {m_descriptorSetLayout_});
+
+		ComputePipelineConfigInfo pipelineConfig{};
+		pipelineConfig.m_pipelineLayout = m_pipelineLayout_;
+		pipelineConfig.m_localSizeX = downsampleWorkgroupSize;
+		pipelineConfig.m_localSizeY = downsampleWorkgroupSize;
+		m_downsamplePipeline_ = std::make_unique<LveComputePipeline>(
+				m_lveDevice_,
+				"src/shaders/depth_pyramid.comp.spv",
+				pipelineConfig
+		);
+	}
+
+	bool LveDepthPyramid::resize(VkExtent2D depthExtent) {
+		if (m_pyramid_ && depthExtent.width == m_pyramid_->m_depthExtent.width &&
+		    depthExtent.height == m_pyramid_->m_depthExtent.height) {
+			return false;
+		}
+
+		m_deletionQueue_.retire(std::move(m_pyramid_));
+		m_pyramid_ = createPyramid(depthExtent);
+		return true;
+	}
+
+	std::unique_ptr<LveDepthPyramid::Pyramid> LveDepthPyramid::createPyramid(VkExtent2D depthExtent) {
+		auto pyramid = std::make_unique<Pyramid>(m_lveDevice_);
+		pyramid->m_depthExtent = depthExtent;
+		pyramid->m_extent = {previousPowerOfTwo(depthExtent.width), previousPowerOfTwo(depthExtent.height)};
+		pyramid->m_mipLevels = 1;
+		while ((1u << pyramid->m_mipLevels) <= std::max(pyramid->m_extent.width, pyramid->m_extent.height)) {
+			pyramid->m_mipLevels++;
+		}
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = pyramid->m_extent.width;
+		imageInfo.extent.height = pyramid->m_extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = pyramid->m_mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.flags = 0;
+
+		m_lveDevice_.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		                                 pyramid->m_image, pyramid->m_imageMemory);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = pyramid->m_image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = pyramid->m_mipLevels;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(m_lveDevice_.device(), &viewInfo, nullptr, &pyramid->m_imageView) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create depth pyramid image view");
+		}
+
+		pyramid->m_mipViews.resize(pyramid->m_mipLevels, VK_NULL_HANDLE);
+		for (uint32_t i = 0; i < pyramid->m_mipLevels; i++) {
+			viewInfo.subresourceRange.baseMipLevel = i;
+			viewInfo.subresourceRange.levelCount = 1;
+			if (vkCreateImageView(m_lveDevice_.device(), &viewInfo, nullptr, &pyramid->m_mipViews[i]) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create depth pyramid image view");
+			}
+		}
+
+		const uint32_t setCount = LveSwapChain::m_maxFramesInFlight + pyramid->m_mipLevels - 1;
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount};
+		poolSizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount};
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = setCount;
+
+		if (vkCreateDescriptorPool(m_lveDevice_.device(), &poolInfo, nullptr, &pyramid->m_descriptorPool) !=
+		    VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor pool");
+		}
+
+		std::vector<VkDescriptorSetLayout> layouts(setCount, m_descriptorSetLayout_);
+		std::vector<VkDescriptorSet> sets(setCount);
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = pyramid->m_descriptorPool;
+		allocInfo.descriptorSetCount = setCount;
+		allocInfo.pSetLayouts = layouts.data();
+
+		if (vkAllocateDescriptorSets(m_lveDevice_.device(), &allocInfo, sets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to allocate descriptor sets");
+		}
+
+		pyramid->m_depthDescriptorSets.assign(sets.begin(), sets.begin() + LveSwapChain::m_maxFramesInFlight);
+		pyramid->m_mipDescriptorSets.assign(sets.begin() + LveSwapChain::m_maxFramesInFlight, sets.end());
+		for (uint32_t i = 1; i < pyramid->m_mipLevels; i++) {
+			writeDescriptorSet(pyramid->m_mipDescriptorSets[i - 1], pyramid->m_mipViews[i - 1],
+			                   VK_IMAGE_LAYOUT_GENERAL, pyramid->m_mipViews[i]);
+		}
+		return pyramid;
+	}
+
+	void LveDepthPyramid::writeDescriptorSet(VkDescriptorSet set,
+	                                         VkImageView input,
+	                                         VkImageLayout inputLayout,
+	                                         VkImageView output) {
+		VkDescriptorImageInfo inputInfo{m_sampler_, input, inputLayout};
+		VkDescriptorImageInfo outputInfo{VK_NULL_HANDLE, output, VK_IMAGE_LAYOUT_GENERAL};
+
+		std::array<VkWriteDescriptorSet, 2> writes{};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = set;
+		writes[0].dstBinding = 0;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].descriptorCount = 1;
+		writes[0].pImageInfo = &inputInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = set;
+		writes[1].dstBinding = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].descriptorCount = 1;
+		writes[1].pImageInfo = &outputInfo;
+
+		vkUpdateDescriptorSets(m_lveDevice_.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	void LveDepthPyramid::build(VkCommandBuffer commandBuffer, int frameIndex, const RenderGraphImageInfo &depth) {
+#ifndef NDEBUG
+		assert(m_pyramid_ && "Cannot build depth pyramid before resize");
+		assert(depth.m_extent.width == m_pyramid_->m_depthExtent.width &&
+		       depth.m_extent.height == m_pyramid_->m_depthExtent.height &&
+		       "Depth attachment does not match the pyramid size");
+#endif
+		auto &pyramid = *m_pyramid_;
+		writeDescriptorSet(pyramid.m_depthDescriptorSets[frameIndex], depth.m_imageView,
+		                   VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, pyramid.m_mipViews[0]);
+
+		m_downsamplePipeline_->bind(commandBuffer);
+
+		VkExtent2D inputExtent = depth.m_extent;
+		for (uint32_t level = 0; level < pyramid.m_mipLevels; level++) {
+			VkExtent2D outputExtent{std::max(pyramid.m_extent.width >> level, 1u),
+			                        std::max(pyramid.m_extent.height >> level, 1u)};
+			VkDescriptorSet set = level == 0 ? pyramid.m_depthDescriptorSets[frameIndex]
+			                                 : pyramid.m_mipDescriptorSets[level - 1];
+			m_downsamplePipeline_->bindDescriptorSets(commandBuffer, &set);
+
+			DownsamplePushConstantData push{
+					static_cast<int32_t>(inputExtent.width),
+					static_cast<int32_t>(inputExtent.height),
+					static_cast<int32_t>(outputExtent.width),
+					static_cast<int32_t>(outputExtent.height)};
+			m_downsamplePipeline_->pushConstants(commandBuffer, &push, sizeof(DownsamplePushConstantData));
+			m_downsamplePipeline_->dispatch(commandBuffer, outputExtent.width, outputExtent.height);
+
+			LveComputePipeline::memoryBarrier(commandBuffer,
+			                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			                                  VK_ACCESS_SHADER_WRITE_BIT,
+			                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			                                  VK_ACCESS_SHADER_READ_BIT);
+
+			inputExtent = outputExtent;
+		}
+	}
+}
@@ -0,0 +1,102 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEDEPTHPYRAMID_HPP
+#define VULKAN_TEST_LVEDEPTHPYRAMID_HPP
+
+#include "LveComputePipeline.hpp"
+#include "LveDeletionQueue.hpp"
+#include "LveDevice.hpp"
+#include "LveRenderGraph.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// Hierarchical depth buffer: an R32 mip chain where every texel holds the farthest depth of the region
+	// it covers. Level 0 is the depth attachment size rounded down to a power of two.
+	class LveDepthPyramid {
+	public:
+		// Replaced pyramids are handed to deletionQueue, which must be the queue of the renderer recording
+		// the builds
+		LveDepthPyramid(LveDevice &device, LveDeletionQueue &deletionQueue);
+
+		~LveDepthPyramid();
+
+		LveDepthPyramid(const LveDepthPyramid &) = delete;
+
+		LveDepthPyramid &operator=(const LveDepthPyramid &) = delete;
+
+		// Creates a new pyramid when the depth extent changed and returns true. The previous one is retired
+		// to the deletion queue, since frames in flight may still use it, so its image view is gone for new
+		// descriptor writes. A new pyramid has undefined contents and is in VK_IMAGE_LAYOUT_UNDEFINED until
+		// the render graph transitions it.
+		bool resize(VkExtent2D depthExtent);
+
+		// Records the downsample of the given depth attachment, which must be in
+		// VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL and visible to compute shaders. The pyramid must be
+		// in VK_IMAGE_LAYOUT_GENERAL and stays there.
+		void build(VkCommandBuffer commandBuffer, int frameIndex, const RenderGraphImageInfo &depth);
+
+		VkImage getImage() const { return m_pyramid_ ? m_pyramid_->m_image : VK_NULL_HANDLE; }
+
+		VkFormat getFormat() const { return VK_FORMAT_R32_SFLOAT; }
+
+		VkImageView getImageView() const { return m_pyramid_ ? m_pyramid_->m_imageView : VK_NULL_HANDLE; }
+
+		VkSampler getSampler() const { return m_sampler_; }
+
+		VkExtent2D getExtent() const { return m_pyramid_ ? m_pyramid_->m_extent : VkExtent2D{0, 0}; }
+
+		uint32_t getMipLevels() const { return m_pyramid_ ? m_pyramid_->m_mipLevels : 0; }
+
+	private:
+		// The image of one depth extent and everything referring to it
+		struct Pyramid {
+			explicit Pyramid(LveDevice &device) : m_device{device} {}
+
+			~Pyramid();
+
+			Pyramid(const Pyramid &) = delete;
+
+			Pyramid &operator=(const Pyramid &) = delete;
+
+			LveDevice &m_device;
+			VkExtent2D m_depthExtent{0, 0};
+			VkExtent2D m_extent{0, 0};
+			uint32_t m_mipLevels = 0;
+			VkImage m_image = VK_NULL_HANDLE;
+			VkDeviceMemory m_imageMemory = VK_NULL_HANDLE;
+			VkImageView m_imageView = VK_NULL_HANDLE;
+			std::vector<VkImageView> m_mipViews;
+
+			VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+			// Level 0 reads the depth attachment of the current swap chain image, so it gets a set per frame
+			// in flight that is rewritten every build. The other levels read the previous pyramid level.
+			std::vector<VkDescriptorSet> m_depthDescriptorSets;
+			std::vector<VkDescriptorSet> m_mipDescriptorSets;
+		};
+
+		void createSampler();
+
+		void createPipeline();
+
+		std::unique_ptr<Pyramid> createPyramid(VkExtent2D depthExtent);
+
+		void writeDescriptorSet(VkDescriptorSet set, VkImageView input, VkImageLayout inputLayout, VkImageView output);
+
+		LveDevice &m_lveDevice_;
+		LveDeletionQueue &m_deletionQueue_;
+		VkSampler m_sampler_ = VK_NULL_HANDLE;
+		VkDescriptorSetLayout m_descriptorSetLayout_ = VK_NULL_HANDLE;
+		VkPipelineLayout m_pipelineLayout_ = VK_NULL_HANDLE;
+		std::unique_ptr<LveComputePipeline> m_downsamplePipeline_;
+
+		std::unique_ptr<Pyramid> m_pyramid_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEDEPTHPYRAMID_HPP
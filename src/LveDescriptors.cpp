@@ -0,0 +1,218 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveDescriptors.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	// *************** Descriptor Set Layout Builder *********************
+
+	LveDescriptorSetLayout::Builder &LveDescriptorSetLayout::Builder::addBinding(
+			uint32_t binding,
+			VkDescriptorType descriptorType,
+			VkShaderStageFlags stageFlags,
+			uint32_t count,
+			VkDescriptorBindingFlags bindingFlags) {
+#ifndef NDEBUG
+		assert(m_bindings_.count(binding) == 0 && "Binding already in use");
+#endif
+		VkDescriptorSetLayoutBinding layoutBinding{};
+		layoutBinding.binding = binding;
+		layoutBinding.descriptorType = descriptorType;
+		layoutBinding.descriptorCount = count;
+		layoutBinding.stageFlags = stageFlags;
+		m_bindings_[binding] = layoutBinding;
+		m_bindingFlags_[binding] = bindingFlags;
+		return *this;
+	}
+
+	std::unique_ptr<LveDescriptorSetLayout> LveDescriptorSetLayout::Builder::build() const {
+		return std::make_unique<LveDescriptorSetLayout>(m_lveDevice_, m_bindings_, m_bindingFlags_);
+	}
+
+	// *************** Descriptor Set Layout *********************
+
+	LveDescriptorSetLayout::LveDescriptorSetLayout(
+			LveDevice &device,
+			std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+			const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags)
+			: m_lveDevice_{device}, m_bindings_{std::move(bindings)} {
+		std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+		std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
+		bool hasBindingFlags = false;
+		bool updateAfterBind = false;
+		for (auto &[binding, layoutBinding]: m_bindings_) {
+			setLayoutBindings.push_back(layoutBinding);
+
+			auto flags = bindingFlags.find(binding);
+			setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
+			hasBindingFlags |= setLayoutBindingFlags.back() != 0;
+			updateAfterBind |= (setLayoutBindingFlags.back() & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
+		descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+		descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
+		// Only chained when used, binding flags require Vulkan 1.2 or VK_EXT_descriptor_indexing
+		if (hasBindingFlags) {
+			descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+		}
+		if (updateAfterBind) {
+			descriptorSetLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		}
+
+		if (vkCreateDescriptorSetLayout(m_lveDevice_.device(), &descriptorSetLayoutInfo, nullptr,
+		                                &m_descriptorSetLayout_) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor set layout");
+		}
+	}
+
+	LveDescriptorSetLayout::~LveDescriptorSetLayout() {
+		vkDestroyDescriptorSetLayout(m_lveDevice_.device(), m_descriptorSetLayout_, nullptr);
+	}
+
+	// *************** Descriptor Pool Builder *********************
+
+	LveDescriptorPool::Builder &LveDescriptorPool::Builder::addPoolSize(VkDescriptorType descriptorType,
+	                                                                    uint32_t count) {
+		m_poolSizes_.push_back({descriptorType, count});
+		return *this;
+	}
+
+	LveDescriptorPool::Builder &LveDescriptorPool::Builder::setPoolFlags(VkDescriptorPoolCreateFlags flags) {
+		m_poolFlags_ = flags;
+		return *this;
+	}
+
+	LveDescriptorPool::Builder &LveDescriptorPool::Builder::setMaxSets(uint32_t count) {
+		m_maxSets_ = count;
+		return *this;
+	}
+
+	std::unique_ptr<LveDescriptorPool> LveDescriptorPool::Builder::build() const {
+		return std::make_unique<LveDescriptorPool>(m_lveDevice_, m_maxSets_, m_poolFlags_, m_poolSizes_);
+	}
+
+	// *************** Descriptor Pool *********************
+
+	LveDescriptorPool::LveDescriptorPool(
+			LveDevice &device,
+			uint32_t maxSets,
+			VkDescriptorPoolCreateFlags poolFlags,
+			const std::vector<VkDescriptorPoolSize> &poolSizes)
+			: m_lveDevice_{device} {
+		VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+		descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		descriptorPoolInfo.pPoolSizes = poolSizes.data();
+		descriptorPoolInfo.maxSets = maxSets;
+		descriptorPoolInfo.flags = poolFlags;
+
+		if (vkCreateDescriptorPool(m_lveDevice_.device(), &descriptorPoolInfo, nullptr, &m_descriptorPool_) !=
+		    VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor pool");
+		}
+	}
+
+	LveDescriptorPool::~LveDescriptorPool() {
+		vkDestroyDescriptorPool(m_lveDevice_.device(), m_descriptorPool_, nullptr);
+	}
+
+	bool LveDescriptorPool::allocateDescriptorSet(VkDescriptorSetLayout descriptorSetLayout,
+	                                              VkDescriptorSet &descriptor) const {
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_descriptorPool_;
+		allocInfo.pSetLayouts = &descriptorSetLayout;
+		allocInfo.descriptorSetCount = 1;
+
+		return vkAllocateDescriptorSets(m_lveDevice_.device(), &allocInfo, &descriptor) == VK_SUCCESS;
+	}
+
+	void LveDescriptorPool::freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const {
+		vkFreeDescriptorSets(
+				m_lveDevice_.device(),
+				m_descriptorPool_,
+				static_cast<uint32_t>(descriptors.size()),
+				descriptors.data());
+	}
+
+	void LveDescriptorPool::resetPool() {
+		vkResetDescriptorPool(m_lveDevice_.device(), m_descriptorPool_, 0);
+	}
+
+	// *************** Descriptor Writer *********************
+
+	LveDescriptorWriter::LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorPool &pool)
+			: m_setLayout_{setLayout}, m_pool_{pool} {}
+
+	LveDescriptorWriter &LveDescriptorWriter::writeBuffer(uint32_t binding,
+	                                                      const VkDescriptorBufferInfo *bufferInfo) {
+#ifndef NDEBUG
+		assert(m_setLayout_.m_bindings_.count(binding) == 1 && "Layout does not contain specified binding");
+#endif
+		auto &bindingDescription = m_setLayout_.m_bindings_[binding];
+#ifndef NDEBUG
+		assert(bindingDescription.descriptorCount == 1 && "Binding single descriptor info, but binding expects multiple");
+#endif
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.descriptorType = bindingDescription.descriptorType;
+		write.dstBinding = binding;
+		write.pBufferInfo = bufferInfo;
+		write.descriptorCount = 1;
+
+		m_writes_.push_back(write);
+		return *this;
+	}
+
+	LveDescriptorWriter &LveDescriptorWriter::writeImage(uint32_t binding, const VkDescriptorImageInfo *imageInfo) {
+#ifndef NDEBUG
+		assert(m_setLayout_.m_bindings_.count(binding) == 1 && "Layout does not contain specified binding");
+#endif
+		auto &bindingDescription = m_setLayout_.m_bindings_[binding];
+#ifndef NDEBUG
+		assert(bindingDescription.descriptorCount == 1 && "Binding single descriptor info, but binding expects multiple");
+#endif
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.descriptorType = bindingDescription.descriptorType;
+		write.dstBinding = binding;
+		write.pImageInfo = imageInfo;
+		write.descriptorCount = 1;
+
+		m_writes_.push_back(write);
+		return *this;
+	}
+
+	bool LveDescriptorWriter::build(VkDescriptorSet &set) {
+		if (!m_pool_.allocateDescriptorSet(m_setLayout_.getDescriptorSetLayout(), set)) {
+			return false;
+		}
+		overwrite(set);
+		return true;
+	}
+
+	void LveDescriptorWriter::overwrite(VkDescriptorSet &set) {
+		for (auto &write: m_writes_) {
+			write.dstSet = set;
+		}
+		vkUpdateDescriptorSets(m_pool_.m_lveDevice_.device(),
+		                       static_cast<uint32_t>(m_writes_.size()),
+		                       m_writes_.data(),
+		                       0, nullptr);
+	}
+}
@@ -0,0 +1,128 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEDESCRIPTORS_HPP
+#define VULKAN_TEST_LVEDESCRIPTORS_HPP
+
+#include "LveDevice.hpp"
+
+// std
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+	class LveDescriptorSetLayout {
+	public:
+		class Builder {
+		public:
+			explicit Builder(LveDevice &device) : m_lveDevice_{device} {}
+
+			Builder &addBinding(
+					uint32_t binding,
+					VkDescriptorType descriptorType,
+					VkShaderStageFlags stageFlags,
+					uint32_t count = 1,
+					VkDescriptorBindingFlags bindingFlags = 0);
+
+			std::unique_ptr<LveDescriptorSetLayout> build() const;
+
+		private:
+			LveDevice &m_lveDevice_;
+			std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> m_bindings_{};
+			std::unordered_map<uint32_t, VkDescriptorBindingFlags> m_bindingFlags_{};
+		};
+
+		// Bindings with VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT make the layout require a pool created
+		// with VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT.
+		LveDescriptorSetLayout(
+				LveDevice &device,
+				std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+				const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {});
+
+		~LveDescriptorSetLayout();
+
+		LveDescriptorSetLayout(const LveDescriptorSetLayout &) = delete;
+
+		LveDescriptorSetLayout &operator=(const LveDescriptorSetLayout &) = delete;
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return m_descriptorSetLayout_; }
+
+	private:
+		LveDevice &m_lveDevice_;
+		VkDescriptorSetLayout m_descriptorSetLayout_;
+		std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> m_bindings_;
+
+		friend class LveDescriptorWriter;
+	};
+
+	class LveDescriptorPool {
+	public:
+		class Builder {
+		public:
+			explicit Builder(LveDevice &device) : m_lveDevice_{device} {}
+
+			Builder &addPoolSize(VkDescriptorType descriptorType, uint32_t count);
+
+			Builder &setPoolFlags(VkDescriptorPoolCreateFlags flags);
+
+			Builder &setMaxSets(uint32_t count);
+
+			std::unique_ptr<LveDescriptorPool> build() const;
+
+		private:
+			LveDevice &m_lveDevice_;
+			std::vector<VkDescriptorPoolSize> m_poolSizes_{};
+			uint32_t m_maxSets_ = 1000;
+			VkDescriptorPoolCreateFlags m_poolFlags_ = 0;
+		};
+
+		LveDescriptorPool(
+				LveDevice &device,
+				uint32_t maxSets,
+				VkDescriptorPoolCreateFlags poolFlags,
+				const std::vector<VkDescriptorPoolSize> &poolSizes);
+
+		~LveDescriptorPool();
+
+		LveDescriptorPool(const LveDescriptorPool &) = delete;
+
+		LveDescriptorPool &operator=(const LveDescriptorPool &) = delete;
+
+		// Returns false instead of throwing when the pool is exhausted, so callers can fall back to another pool
+		bool allocateDescriptorSet(VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) const;
+
+		void freeDescriptors(std::vector<VkDescriptorSet> &descriptors) const;
+
+		void resetPool();
+
+	private:
+		LveDevice &m_lveDevice_;
+		VkDescriptorPool m_descriptorPool_;
+
+		friend class LveDescriptorWriter;
+	};
+
+	// Collects writes for a single set; the buffer and image infos must outlive build() or overwrite().
+	class LveDescriptorWriter {
+	public:
+		LveDescriptorWriter(LveDescriptorSetLayout &setLayout, LveDescriptorPool &pool);
+
+		LveDescriptorWriter &writeBuffer(uint32_t binding, const VkDescriptorBufferInfo *bufferInfo);
+
+		LveDescriptorWriter &writeImage(uint32_t binding, const VkDescriptorImageInfo *imageInfo);
+
+		bool build(VkDescriptorSet &set);
+
+		void overwrite(VkDescriptorSet &set);
+
+	private:
+		LveDescriptorSetLayout &m_setLayout_;
+		LveDescriptorPool &m_pool_;
+		std::vector<VkWriteDescriptorSet> m_writes_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEDESCRIPTORS_HPP
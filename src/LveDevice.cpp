@@ -1,6 +1,8 @@
 #include "LveDevice.hpp"
 
 // std headers
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -50,15 +52,27 @@ namespace lve {
 
 // class member functions
 	LveDevice::LveDevice(LveWindow &window) : m_window_{window} {
+		if (m_window_.isHeadless()) {
+			m_deviceExtensions_.clear();
+		}
 		createInstance();
 		setupDebugMessenger();
 		createSurface();
 		pickPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+		createPipelineCache();
+		m_pipelineLayoutCache_ = std::make_unique<LvePipelineLayoutCache>(m_device_);
+		m_shaderModuleCache_ = std::make_unique<LveShaderModuleCache>(m_device_, m_maintenance5_);
 	}
 
     LveDevice::~LveDevice() {
+	    m_shaderModuleCache_.reset();
+	    m_pipelineLayoutCache_.reset();
+	    vkDestroyPipelineCache(m_device_, m_pipelineCache_, nullptr);
+	    if (m_computeCommandPool_ != m_commandPool_) {
+		    vkDestroyCommandPool(m_device_, m_computeCommandPool_, nullptr);
+	    }
 	    vkDestroyCommandPool(m_device_, m_commandPool_, nullptr);
 	    vkDestroyDevice(m_device_, nullptr);
 
@@ -66,7 +80,9 @@ namespace lve {
 		    destroyDebugUtilsMessengerExt(m_instance_, m_debugMessenger_, nullptr);
 	    }
 
-	    vkDestroySurfaceKHR(m_instance_, m_surface_, nullptr);
+	    if (m_surface_ != VK_NULL_HANDLE) {
+		    vkDestroySurfaceKHR(m_instance_, m_surface_, nullptr);
+	    }
 	    vkDestroyInstance(m_instance_, nullptr);
     }
 
@@ -75,13 +91,28 @@ namespace lve {
 		    throw std::runtime_error("validation layers requested, but not available!");
 	    }
 
+	    // A 1.0 loader rejects instances asking for a newer version, so only request 1.2 or 1.3 when it is
+	    // available. vkEnumerateInstanceVersion itself does not exist before 1.1.
+	    auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion) vkGetInstanceProcAddr(
+			    nullptr,
+			    "vkEnumerateInstanceVersion");
+	    if (enumerateInstanceVersion != nullptr) {
+		    uint32_t loaderVersion = VK_API_VERSION_1_0;
+		    enumerateInstanceVersion(&loaderVersion);
+		    if (loaderVersion >= VK_API_VERSION_1_3) {
+			    m_instanceApiVersion_ = VK_API_VERSION_1_3;
+		    } else if (loaderVersion >= VK_API_VERSION_1_2) {
+			    m_instanceApiVersion_ = VK_API_VERSION_1_2;
+		    }
+	    }
+
         VkApplicationInfo appInfo = {};
         appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
         appInfo.pApplicationName = "LittleVulkanEngine App";
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = m_instanceApiVersion_;
 
 	    VkInstanceCreateInfo createInfo = {};
 	    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -133,13 +164,16 @@ namespace lve {
 
 	    vkGetPhysicalDeviceProperties(m_physicalDevice_, &m_properties);
 	    std::cout << "physical device: " << m_properties.deviceName << std::endl;
+
+	    m_apiVersion_ = std::min(m_instanceApiVersion_, m_properties.apiVersion);
     }
 
     void LveDevice::createLogicalDevice() {
 	    QueueFamilyIndices indices = findQueueFamilies(m_physicalDevice_);
 
 	    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	    std::set<uint32_t> uniqueQueueFamilies = {indices.m_graphicsFamily, indices.m_presentFamily};
+	    std::set<uint32_t> uniqueQueueFamilies = {indices.m_graphicsFamily, indices.m_presentFamily,
+	                                              indices.m_computeFamily};
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily: uniqueQueueFamilies) {
@@ -151,8 +185,142 @@ namespace lve {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+	    VkPhysicalDeviceFeatures supportedFeatures;
+	    vkGetPhysicalDeviceFeatures(m_physicalDevice_, &supportedFeatures);
+
 	    VkPhysicalDeviceFeatures deviceFeatures = {};
 	    deviceFeatures.samplerAnisotropy = VK_TRUE;
+	    // Used by GPU-driven rendering: many indirect draws per call, and firstInstance as the object index
+	    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+	    m_multiDrawIndirect_ = supportedFeatures.multiDrawIndirect == VK_TRUE;
+	    m_drawIndirectFirstInstance_ = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+	    // Block compressed textures, whichever families the device can sample
+	    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	    deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+	    deviceFeatures.textureCompressionETC2 = supportedFeatures.textureCompressionETC2;
+
+	    std::vector<const char *> enabledExtensions = m_deviceExtensions_;
+
+	    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+	    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	    VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+	    deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	    deviceFeatures2.pNext = &vulkan12Features;
+	    deviceFeatures2.features = deviceFeatures;
+
+	    VkPhysicalDeviceVulkan13Features vulkan13Features = {};
+	    vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+#ifdef VK_KHR_maintenance5
+	    VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features = {};
+	    maintenance5Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR;
+#endif
+
+	    // The 1.1 queries are loaded at runtime as well, so the binary still links against 1.0 loaders
+	    if (m_apiVersion_ >= VK_API_VERSION_1_1) {
+		    m_getPhysicalDeviceFeatures2_ = (PFN_vkGetPhysicalDeviceFeatures2) vkGetInstanceProcAddr(
+				    m_instance_, "vkGetPhysicalDeviceFeatures2");
+		    m_getPhysicalDeviceProperties2_ = (PFN_vkGetPhysicalDeviceProperties2) vkGetInstanceProcAddr(
+				    m_instance_, "vkGetPhysicalDeviceProperties2");
+		    m_getPhysicalDeviceMemoryProperties2_ = (PFN_vkGetPhysicalDeviceMemoryProperties2) vkGetInstanceProcAddr(
+				    m_instance_, "vkGetPhysicalDeviceMemoryProperties2");
+	    }
+
+	    bool drawIndirectCount = false;
+	    bool drawIndirectCountExtension = false;
+	    bool dynamicRendering = false;
+	    if (m_apiVersion_ >= VK_API_VERSION_1_2) {
+		    VkPhysicalDeviceVulkan12Features supported12 = {};
+		    supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		    VkPhysicalDeviceFeatures2 supported2 = {};
+		    supported2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		    supported2.pNext = &supported12;
+		    m_getPhysicalDeviceFeatures2_(m_physicalDevice_, &supported2);
+
+		    vulkan12Features.drawIndirectCount = supported12.drawIndirectCount;
+		    drawIndirectCount = supported12.drawIndirectCount == VK_TRUE;
+
+		    // Bindless resources: large, partially bound descriptor arrays that are indexed per object and
+		    // updated while other slots are in use by command buffers in flight
+		    m_descriptorIndexing_ =
+				    supported12.runtimeDescriptorArray &&
+				    supported12.descriptorBindingPartiallyBound &&
+				    supported12.descriptorBindingUpdateUnusedWhilePending &&
+				    supported12.descriptorBindingSampledImageUpdateAfterBind &&
+				    supported12.descriptorBindingStorageBufferUpdateAfterBind &&
+				    supported12.shaderSampledImageArrayNonUniformIndexing &&
+				    supported12.shaderStorageBufferArrayNonUniformIndexing;
+		    if (m_descriptorIndexing_) {
+			    vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+			    vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+			    vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			    vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			    vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+			    vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			    vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+
+			    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+			    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+			    VkPhysicalDeviceProperties2 properties2 = {};
+			    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			    properties2.pNext = &indexingProperties;
+			    m_getPhysicalDeviceProperties2_(m_physicalDevice_, &properties2);
+			    // Combined image samplers count against both the sampler and the sampled image limits
+			    m_maxBindlessSampledImages_ = std::min({
+					    indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+					    indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+					    indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages});
+			    m_maxBindlessStorageBuffers_ = std::min(
+					    indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+					    indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers);
+		    }
+
+		    // Dynamic rendering replaces render pass and framebuffer objects, see LveRenderer
+		    if (m_apiVersion_ >= VK_API_VERSION_1_3) {
+			    VkPhysicalDeviceVulkan13Features supported13 = {};
+			    supported13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+			    VkPhysicalDeviceFeatures2 supported2Vulkan13 = {};
+			    supported2Vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			    supported2Vulkan13.pNext = &supported13;
+			    m_getPhysicalDeviceFeatures2_(m_physicalDevice_, &supported2Vulkan13);
+
+			    vulkan13Features.dynamicRendering = supported13.dynamicRendering;
+			    dynamicRendering = supported13.dynamicRendering == VK_TRUE;
+			    vulkan12Features.pNext = &vulkan13Features;
+		    }
+
+#ifdef VK_KHR_maintenance5
+		    // Lets pipelines take SPIR-V directly instead of a shader module, see LveShaderModuleCache
+		    if (m_apiVersion_ >= VK_API_VERSION_1_3 &&
+		        isDeviceExtensionAvailable(m_physicalDevice_, VK_KHR_MAINTENANCE_5_EXTENSION_NAME)) {
+			    VkPhysicalDeviceMaintenance5FeaturesKHR supportedMaintenance5 = {};
+			    supportedMaintenance5.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR;
+			    VkPhysicalDeviceFeatures2 supported2Maintenance5 = {};
+			    supported2Maintenance5.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			    supported2Maintenance5.pNext = &supportedMaintenance5;
+			    m_getPhysicalDeviceFeatures2_(m_physicalDevice_, &supported2Maintenance5);
+			    m_maintenance5_ = supportedMaintenance5.maintenance5 == VK_TRUE;
+		    }
+		    if (m_maintenance5_) {
+			    enabledExtensions.push_back(VK_KHR_MAINTENANCE_5_EXTENSION_NAME);
+			    maintenance5Features.maintenance5 = VK_TRUE;
+			    vulkan13Features.pNext = &maintenance5Features;
+		    }
+#endif
+	    } else if (isDeviceExtensionAvailable(m_physicalDevice_, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+		    enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		    drawIndirectCount = true;
+		    drawIndirectCountExtension = true;
+	    }
+
+	    // Heap budgets for texture residency; reading them needs vkGetPhysicalDeviceMemoryProperties2 from 1.1
+	    if (m_apiVersion_ >= VK_API_VERSION_1_1 &&
+	        isDeviceExtensionAvailable(m_physicalDevice_, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+		    enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		    m_memoryBudget_ = true;
+	    }
 
 	    VkDeviceCreateInfo createInfo = {};
 	    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -160,9 +328,16 @@ namespace lve {
 	    createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	    createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-	    createInfo.pEnabledFeatures = &deviceFeatures;
-	    createInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions_.size());
-	    createInfo.ppEnabledExtensionNames = m_deviceExtensions_.data();
+	    // Feature structs for 1.1+ are chained through VkPhysicalDeviceFeatures2, which then replaces
+	    // pEnabledFeatures
+	    if (m_apiVersion_ >= VK_API_VERSION_1_2) {
+		    createInfo.pNext = &deviceFeatures2;
+		    createInfo.pEnabledFeatures = nullptr;
+	    } else {
+		    createInfo.pEnabledFeatures = &deviceFeatures;
+	    }
+	    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+	    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	    // might not really be necessary anymore because device specific validation layers
 	    // have been deprecated
@@ -179,8 +354,37 @@ namespace lve {
 
 	    vkGetDeviceQueue(m_device_, indices.m_graphicsFamily, 0, &m_graphicsQueue_);
 	    vkGetDeviceQueue(m_device_, indices.m_presentFamily, 0, &m_presentQueue_);
+	    vkGetDeviceQueue(m_device_, indices.m_computeFamily, 0, &m_computeQueue_);
+	    m_computeFamily_ = indices.m_computeFamily;
+	    m_asyncCompute_ = indices.m_computeFamily != indices.m_graphicsFamily;
+
+	    // Loaded at runtime so the binary still links against loaders that predate 1.2
+	    if (drawIndirectCount) {
+		    m_cmdDrawIndexedIndirectCount_ = (PFN_vkCmdDrawIndexedIndirectCount) vkGetDeviceProcAddr(
+				    m_device_,
+				    drawIndirectCountExtension ? "vkCmdDrawIndexedIndirectCountKHR" : "vkCmdDrawIndexedIndirectCount");
+	    }
+	    if (dynamicRendering) {
+		    m_cmdBeginRendering_ = (PFN_vkCmdBeginRendering) vkGetDeviceProcAddr(m_device_, "vkCmdBeginRendering");
+		    m_cmdEndRendering_ = (PFN_vkCmdEndRendering) vkGetDeviceProcAddr(m_device_, "vkCmdEndRendering");
+	    }
     }
 
+	void LveDevice::cmdDrawIndexedIndirectCount(
+			VkCommandBuffer commandBuffer,
+			VkBuffer buffer,
+			VkDeviceSize offset,
+			VkBuffer countBuffer,
+			VkDeviceSize countBufferOffset,
+			uint32_t maxDrawCount,
+			uint32_t stride) {
+#ifndef NDEBUG
+		assert(supportsDrawIndirectCount() && "vkCmdDrawIndexedIndirectCount is not supported by this device");
+#endif
+		m_cmdDrawIndexedIndirectCount_(commandBuffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount,
+		                               stride);
+	}
+
     void LveDevice::createCommandPool() {
         QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
 
@@ -193,17 +397,40 @@ namespace lve {
 	    if (vkCreateCommandPool(m_device_, &poolInfo, nullptr, &m_commandPool_) != VK_SUCCESS) {
 		    throw std::runtime_error("failed to create command pool!");
 	    }
+
+	    // Command buffers can only be submitted to queues of the family their pool was created for
+	    m_computeCommandPool_ = m_commandPool_;
+	    if (m_asyncCompute_) {
+		    poolInfo.queueFamilyIndex = m_computeFamily_;
+		    if (vkCreateCommandPool(m_device_, &poolInfo, nullptr, &m_computeCommandPool_) != VK_SUCCESS) {
+			    throw std::runtime_error("failed to create compute command pool!");
+		    }
+	    }
     }
 
-	void LveDevice::createSurface() { m_window_.createWindowSurface(m_instance_, &m_surface_); }
+	void LveDevice::createPipelineCache() {
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		if (vkCreatePipelineCache(m_device_, &cacheInfo, nullptr, &m_pipelineCache_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+	}
+
+	void LveDevice::createSurface() {
+		if (!m_window_.isHeadless()) {
+			m_window_.createWindowSurface(m_instance_, &m_surface_);
+		}
+	}
 
     bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        // Headless rendering goes to offscreen images, which any device can render to
+        bool swapChainAdequate = m_surface_ == VK_NULL_HANDLE;
+        if (extensionsSupported && !swapChainAdequate) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
 	        swapChainAdequate = !swapChainSupport.m_formats.empty() && !swapChainSupport.m_presentModes.empty();
         }
@@ -263,11 +490,12 @@ namespace lve {
     }
 
     std::vector<const char *> LveDevice::getRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char **glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char *> extensions;
+	    if (!m_window_.isHeadless()) {
+		    uint32_t glfwExtensionCount = 0;
+		    const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	    }
 
 	    if (m_enableValidationLayers) {
 		    extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -319,6 +547,25 @@ namespace lve {
         return requiredExtensions.empty();
     }
 
+	bool LveDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName) {
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(
+				device,
+				nullptr,
+				&extensionCount,
+				availableExtensions.data());
+
+		for (const auto &extension: availableExtensions) {
+			if (strcmp(extension.extensionName, extensionName) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
     QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
         QueueFamilyIndices indices;
 
@@ -333,9 +580,15 @@ namespace lve {
             if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
 	            indices.m_graphicsFamily = i;
 	            indices.m_graphicsFamilyHasValue = true;
+	            indices.m_graphicsTimestampValidBits = queueFamily.timestampValidBits;
             }
             VkBool32 presentSupport = false;
-	        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface_, &presentSupport);
+	        if (m_surface_ != VK_NULL_HANDLE) {
+		        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface_, &presentSupport);
+	        } else {
+		        // Without a surface nothing is presented, the graphics queue stands in for the present queue
+		        presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+	        }
             if (queueFamily.queueCount > 0 && presentSupport) {
 	            indices.m_presentFamily = i;
 	            indices.m_presentFamilyHasValue = true;
@@ -347,6 +600,22 @@ namespace lve {
             i++;
         }
 
+	    // Prefer a compute family without graphics, on most hardware that is the one scheduled concurrently
+	    for (uint32_t family = 0; family < queueFamilyCount; family++) {
+		    const auto &queueFamily = queueFamilies[family];
+		    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT &&
+		        !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+			    indices.m_computeFamily = family;
+			    indices.m_computeFamilyHasValue = true;
+			    break;
+		    }
+	    }
+	    if (!indices.m_computeFamilyHasValue && indices.m_graphicsFamilyHasValue) {
+		    // Graphics families are required to support compute
+		    indices.m_computeFamily = indices.m_graphicsFamily;
+		    indices.m_computeFamilyHasValue = true;
+	    }
+
         return indices;
     }
 
@@ -392,6 +661,44 @@ namespace lve {
         throw std::runtime_error("failed to find supported format!");
     }
 
+	LveDevice::MemoryBudget LveDevice::queryMemoryBudget() {
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		VkPhysicalDeviceMemoryProperties2 memoryProperties2 = {};
+		memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+
+		const VkPhysicalDeviceMemoryProperties *memoryProperties = &memoryProperties2.memoryProperties;
+		VkPhysicalDeviceMemoryProperties plainProperties;
+		if (m_memoryBudget_) {
+			memoryProperties2.pNext = &budgetProperties;
+			m_getPhysicalDeviceMemoryProperties2_(m_physicalDevice_, &memoryProperties2);
+		} else {
+			vkGetPhysicalDeviceMemoryProperties(m_physicalDevice_, &plainProperties);
+			memoryProperties = &plainProperties;
+		}
+
+		MemoryBudget budget{};
+		budget.m_exact = m_memoryBudget_;
+		for (uint32_t heap = 0; heap < memoryProperties->memoryHeapCount; heap++) {
+			if (!(memoryProperties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+				continue;
+			}
+			if (m_memoryBudget_) {
+				budget.m_budget += budgetProperties.heapBudget[heap];
+				budget.m_usage += budgetProperties.heapUsage[heap];
+			} else {
+				budget.m_budget += memoryProperties->memoryHeaps[heap].size;
+			}
+		}
+		return budget;
+	}
+
+	bool LveDevice::supportsFormat(VkFormat format, VkFormatFeatureFlags features) {
+		VkFormatProperties props;
+		vkGetPhysicalDeviceFormatProperties(m_physicalDevice_, format, &props);
+		return (props.optimalTilingFeatures & features) == features;
+	}
+
     uint32_t LveDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
         VkPhysicalDeviceMemoryProperties memProperties;
 	    vkGetPhysicalDeviceMemoryProperties(m_physicalDevice_, &memProperties);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "LvePipelineLayoutCache.hpp"
+#include "LveShaderModuleCache.hpp"
 #include "LveWindow.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -17,8 +20,12 @@ namespace lve {
 	struct QueueFamilyIndices {
 		uint32_t m_graphicsFamily;
 		uint32_t m_presentFamily;
+		uint32_t m_computeFamily;
 		bool m_graphicsFamilyHasValue = false;
 		bool m_presentFamilyHasValue = false;
+		bool m_computeFamilyHasValue = false;
+		// Meaningful bits of timestamps written on the graphics queue, 0 when it has no timestamps
+		uint32_t m_graphicsTimestampValidBits = 0;
 
 		bool isComplete() const { return m_graphicsFamilyHasValue && m_presentFamilyHasValue; }
 	};
@@ -31,6 +38,7 @@ namespace lve {
 		const bool m_enableValidationLayers = true;
 #endif
 
+        // Without a surface for a headless window, which leaves out presentation and the swap chain extension
         explicit LveDevice(LveWindow &window);
 
         ~LveDevice();
@@ -48,12 +56,36 @@ namespace lve {
 
 		VkDevice device() { return m_device_; }
 
+		// VK_NULL_HANDLE when the window is headless
 		VkSurfaceKHR surface() { return m_surface_; }
 
 		VkQueue graphicsQueue() { return m_graphicsQueue_; }
 
 		VkQueue presentQueue() { return m_presentQueue_; }
 
+		// A dedicated compute queue when the device has one, otherwise the graphics queue
+		VkQueue computeQueue() { return m_computeQueue_; }
+
+		// Pool for command buffers submitted to computeQueue(), the graphics pool when there is no async queue
+		VkCommandPool getComputeCommandPool() { return m_computeCommandPool_; }
+
+		uint32_t computeQueueFamily() const { return m_computeFamily_; }
+
+		// True when computeQueue() belongs to a different family than the graphics queue, so work submitted to
+		// it can overlap with graphics. Resources shared between the two need ownership transfers, see
+		// LveComputePipeline::bufferBarrier.
+		bool hasAsyncComputeQueue() const { return m_asyncCompute_; }
+
+		// Shared by all pipeline creation; Vulkan synchronizes access internally, so worker threads can use it
+		// concurrently, see LvePipelineCompiler
+		VkPipelineCache pipelineCache() { return m_pipelineCache_; }
+
+		// Pipeline and descriptor set layouts shared between all pipelines with the same interface
+		LvePipelineLayoutCache &pipelineLayoutCache() { return *m_pipelineLayoutCache_; }
+
+		// Shader modules shared between the pipelines being created from the same SPIR-V
+		LveShaderModuleCache &shaderModuleCache() { return *m_shaderModuleCache_; }
+
 		SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(m_physicalDevice_); }
 
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -86,6 +118,57 @@ namespace lve {
                 VkImage &image,
                 VkDeviceMemory &imageMemory);
 
+		struct MemoryBudget {
+			VkDeviceSize m_budget = 0;
+			VkDeviceSize m_usage = 0;
+			// Without VK_EXT_memory_budget the budget is the heap size and the usage is unknown
+			bool m_exact = false;
+		};
+
+		// Device local memory this process can allocate without degrading performance, and what it uses
+		MemoryBudget queryMemoryBudget();
+
+		// Whether images of format with optimal tiling support every one of features
+		bool supportsFormat(VkFormat format, VkFormatFeatureFlags features);
+
+		// Vulkan version usable on this device, the lower of what the loader and the driver support
+		uint32_t apiVersion() const { return m_apiVersion_; }
+
+		bool supportsMultiDrawIndirect() const { return m_multiDrawIndirect_; }
+
+		bool supportsDrawIndirectFirstInstance() const { return m_drawIndirectFirstInstance_; }
+
+		// Core in Vulkan 1.2, otherwise provided by VK_KHR_draw_indirect_count when available
+		bool supportsDrawIndirectCount() const { return m_cmdDrawIndexedIndirectCount_ != nullptr; }
+
+		// Vulkan 1.2 descriptor indexing with update-after-bind and partially bound arrays, see LveBindlessHeap
+		bool supportsDescriptorIndexing() const { return m_descriptorIndexing_; }
+
+		uint32_t maxBindlessSampledImages() const { return m_maxBindlessSampledImages_; }
+
+		uint32_t maxBindlessStorageBuffers() const { return m_maxBindlessStorageBuffers_; }
+
+		// Vulkan 1.3 dynamic rendering, rendering then needs no render pass or framebuffer objects
+		bool supportsDynamicRendering() const { return m_cmdBeginRendering_ != nullptr; }
+
+		void cmdBeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfo *renderingInfo) {
+			m_cmdBeginRendering_(commandBuffer, renderingInfo);
+		}
+
+		void cmdEndRendering(VkCommandBuffer commandBuffer) { m_cmdEndRendering_(commandBuffer); }
+
+		// VK_KHR_maintenance5 on Vulkan 1.3, pipelines can then be created without shader modules
+		bool supportsMaintenance5() const { return m_maintenance5_; }
+
+		void cmdDrawIndexedIndirectCount(
+				VkCommandBuffer commandBuffer,
+				VkBuffer buffer,
+				VkDeviceSize offset,
+				VkBuffer countBuffer,
+				VkDeviceSize countBufferOffset,
+				uint32_t maxDrawCount,
+				uint32_t stride);
+
 		VkPhysicalDeviceProperties m_properties;
 
     private:
@@ -101,6 +184,8 @@ namespace lve {
 
         void createCommandPool();
 
+		void createPipelineCache();
+
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
 
@@ -116,6 +201,8 @@ namespace lve {
 
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device);
 
+		bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName);
+
 		SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
 		VkInstance m_instance_;
@@ -123,14 +210,37 @@ namespace lve {
 		VkPhysicalDevice m_physicalDevice_ = VK_NULL_HANDLE;
 		LveWindow &m_window_;
 		VkCommandPool m_commandPool_;
+		VkCommandPool m_computeCommandPool_ = VK_NULL_HANDLE;
+		VkPipelineCache m_pipelineCache_ = VK_NULL_HANDLE;
+		std::unique_ptr<LvePipelineLayoutCache> m_pipelineLayoutCache_;
+		std::unique_ptr<LveShaderModuleCache> m_shaderModuleCache_;
 
 		VkDevice m_device_;
-		VkSurfaceKHR m_surface_;
+		VkSurfaceKHR m_surface_ = VK_NULL_HANDLE;
 		VkQueue m_graphicsQueue_;
 		VkQueue m_presentQueue_;
+		VkQueue m_computeQueue_;
+		uint32_t m_computeFamily_ = 0;
+		bool m_asyncCompute_ = false;
+
+		uint32_t m_instanceApiVersion_ = VK_API_VERSION_1_0;
+		uint32_t m_apiVersion_ = VK_API_VERSION_1_0;
+		bool m_multiDrawIndirect_ = false;
+		bool m_drawIndirectFirstInstance_ = false;
+		PFN_vkCmdDrawIndexedIndirectCount m_cmdDrawIndexedIndirectCount_ = nullptr;
+		bool m_descriptorIndexing_ = false;
+		uint32_t m_maxBindlessSampledImages_ = 0;
+		uint32_t m_maxBindlessStorageBuffers_ = 0;
+		bool m_maintenance5_ = false;
+		bool m_memoryBudget_ = false;
+		PFN_vkCmdBeginRendering m_cmdBeginRendering_ = nullptr;
+		PFN_vkCmdEndRendering m_cmdEndRendering_ = nullptr;
+		PFN_vkGetPhysicalDeviceFeatures2 m_getPhysicalDeviceFeatures2_ = nullptr;
+		PFN_vkGetPhysicalDeviceProperties2 m_getPhysicalDeviceProperties2_ = nullptr;
+		PFN_vkGetPhysicalDeviceMemoryProperties2 m_getPhysicalDeviceMemoryProperties2_ = nullptr;
 
 		const std::vector<const char *> m_validationLayers_ = {"VK_LAYER_KHRONOS_validation"};
-		const std::vector<const char *> m_deviceExtensions_ = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+		std::vector<const char *> m_deviceExtensions_ = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 	};
 
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,79 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveFrameAllocator.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace lve {
+
+	LveFrameAllocator::LveFrameAllocator(
+			LveDevice &device,
+			VkDeviceSize frameCapacity,
+			VkBufferUsageFlags usageFlags) : m_lveDevice_{device}, m_usageFlags_{usageFlags} {
+#ifndef NDEBUG
+		assert(frameCapacity > 0 && "Frame allocator capacity must be greater than zero");
+#endif
+		const auto &limits = m_lveDevice_.m_properties.limits;
+		if (usageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+			m_alignment_ = std::max(m_alignment_, limits.minUniformBufferOffsetAlignment);
+		}
+		if (usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+			m_alignment_ = std::max(m_alignment_, limits.minStorageBufferOffsetAlignment);
+		}
+
+		m_frames_.resize(LveSwapChain::m_maxFramesInFlight);
+		for (auto &frame: m_frames_) {
+			frame.m_buffer = createBuffer(frameCapacity);
+		}
+	}
+
+	std::unique_ptr<LveBuffer> LveFrameAllocator::createBuffer(VkDeviceSize size) const {
+		auto buffer = std::make_unique<LveBuffer>(
+				m_lveDevice_,
+				size,
+				1,
+				m_usageFlags_,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		buffer->map();
+		return buffer;
+	}
+
+	void LveFrameAllocator::beginFrame(int frameIndex) {
+#ifndef NDEBUG
+		assert(frameIndex >= 0 && frameIndex < static_cast<int>(m_frames_.size()) && "Frame index out of range");
+#endif
+		m_frameIndex_ = frameIndex;
+		auto &frame = m_frames_[frameIndex];
+		frame.m_retired.clear();
+		frame.m_cursor = 0;
+	}
+
+	LveFrameAllocation LveFrameAllocator::allocate(VkDeviceSize size) {
+		auto &frame = m_frames_[m_frameIndex_];
+		VkDeviceSize offset = (frame.m_cursor + m_alignment_ - 1) & ~(m_alignment_ - 1);
+
+		if (offset + size > frame.m_buffer->getBufferSize()) {
+			VkDeviceSize capacity = frame.m_buffer->getBufferSize() * 2;
+			while (capacity < size) {
+				capacity *= 2;
+			}
+			frame.m_retired.push_back(std::move(frame.m_buffer));
+			frame.m_buffer = createBuffer(capacity);
+			offset = 0;
+		}
+
+		frame.m_cursor = offset + size;
+		return {
+				frame.m_buffer->getBuffer(),
+				offset,
+				size,
+				static_cast<char *>(frame.m_buffer->getMappedMemory()) + offset
+		};
+	}
+}
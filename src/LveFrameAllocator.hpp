@@ -0,0 +1,80 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEFRAMEALLOCATOR_HPP
+#define VULKAN_TEST_LVEFRAMEALLOCATOR_HPP
+
+#include "LveBuffer.hpp"
+#include "LveDevice.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// A slice of a frame's buffer. Stays valid until the same frame index begins again.
+	struct LveFrameAllocation {
+		VkBuffer m_buffer = VK_NULL_HANDLE;
+		VkDeviceSize m_offset = 0;
+		VkDeviceSize m_size = 0;
+		void *m_data = nullptr;
+
+		VkDescriptorBufferInfo descriptorInfo() const { return {m_buffer, m_offset, m_size}; }
+
+		// For *_DYNAMIC descriptors written with offset 0 and range m_size
+		uint32_t dynamicOffset() const { return static_cast<uint32_t>(m_offset); }
+	};
+
+	// Linear allocator for data that is rewritten every frame, such as camera and per-object uniforms. Each
+	// frame in flight owns a persistently mapped, host coherent buffer; allocations are bumped from it and
+	// aligned so they can be bound as uniform or storage buffers at their offset.
+	//
+	// When a frame runs out of space a larger buffer replaces it, the old one is kept alive until the frame
+	// index comes around again so allocations already handed out stay valid.
+	class LveFrameAllocator {
+	public:
+		LveFrameAllocator(
+				LveDevice &device,
+				VkDeviceSize frameCapacity,
+				VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		LveFrameAllocator(const LveFrameAllocator &) = delete;
+
+		LveFrameAllocator &operator=(const LveFrameAllocator &) = delete;
+
+		// Must be called after the frame's fence has been waited on, see LveRenderer::beginFrame
+		void beginFrame(int frameIndex);
+
+		LveFrameAllocation allocate(VkDeviceSize size);
+
+		template<typename T>
+		LveFrameAllocation upload(const T &data) {
+			auto allocation = allocate(sizeof(T));
+			*static_cast<T *>(allocation.m_data) = data;
+			return allocation;
+		}
+
+		VkDeviceSize getAlignment() const { return m_alignment_; }
+
+		VkDeviceSize getUsedSize() const { return m_frames_[m_frameIndex_].m_cursor; }
+
+	private:
+		struct FrameArena {
+			std::unique_ptr<LveBuffer> m_buffer;
+			std::vector<std::unique_ptr<LveBuffer>> m_retired;
+			VkDeviceSize m_cursor = 0;
+		};
+
+		std::unique_ptr<LveBuffer> createBuffer(VkDeviceSize size) const;
+
+		LveDevice &m_lveDevice_;
+		VkBufferUsageFlags m_usageFlags_;
+		VkDeviceSize m_alignment_ = 1;
+		std::vector<FrameArena> m_frames_;
+		int m_frameIndex_ = 0;
+	};
+}
+
+#endif //VULKAN_TEST_LVEFRAMEALLOCATOR_HPP
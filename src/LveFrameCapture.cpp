@@ -0,0 +1,288 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveFrameCapture.hpp"
+#include "LveComputePipeline.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t bytesPerPixel = 4;
+
+		bool isBgra(VkFormat format) {
+			return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+		}
+
+		uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+			static const auto table = [] {
+				std::array<uint32_t, 256> result{};
+				for (uint32_t i = 0; i < 256; i++) {
+					uint32_t c = i;
+					for (int k = 0; k < 8; k++) {
+						c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+					}
+					result[i] = c;
+				}
+				return result;
+			}();
+
+			crc = ~crc;
+			for (size_t i = 0; i < size; i++) {
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		void appendBigEndian(std::vector<uint8_t> &out, uint32_t value) {
+			out.push_back(static_cast<uint8_t>(value >> 24));
+			out.push_back(static_cast<uint8_t>(value >> 16));
+			out.push_back(static_cast<uint8_t>(value >> 8));
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		void appendChunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data) {
+			appendBigEndian(out, static_cast<uint32_t>(data.size()));
+			size_t start = out.size();
+			out.insert(out.end(), type, type + 4);
+			out.insert(out.end(), data.begin(), data.end());
+			appendBigEndian(out, crc32(out.data() + start, out.size() - start));
+		}
+
+		// RGB8 PNG with stored (uncompressed) deflate blocks; encoding speed matters more than size here
+		std::vector<uint8_t> encodePng(const uint8_t *rgb, uint32_t width, uint32_t height) {
+			std::vector<uint8_t> scanlines;
+			scanlines.reserve(static_cast<size_t>(width * 3 + 1) * height);
+			for (uint32_t y = 0; y < height; y++) {
+				scanlines.push_back(0);
+				scanlines.insert(scanlines.end(), rgb + static_cast<size_t>(y) * width * 3,
+				                 rgb + static_cast<size_t>(y + 1) * width * 3);
+			}
+
+			std::vector<uint8_t> zlib{0x78, 0x01};
+			constexpr size_t maxBlock = 65535;
+			for (size_t offset = 0; offset < scanlines.size() || offset == 0; offset += maxBlock) {
+				auto length = static_cast<uint16_t>(std::min(maxBlock, scanlines.size() - offset));
+				auto inverse = static_cast<uint16_t>(~length);
+				zlib.push_back(offset + length >= scanlines.size() ? 1 : 0);
+				zlib.push_back(static_cast<uint8_t>(length));
+				zlib.push_back(static_cast<uint8_t>(length >> 8));
+				zlib.push_back(static_cast<uint8_t>(inverse));
+				zlib.push_back(static_cast<uint8_t>(inverse >> 8));
+				zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + length);
+				if (length == 0) {
+					break;
+				}
+			}
+			uint32_t a = 1;
+			uint32_t b = 0;
+			for (auto byte: scanlines) {
+				a = (a + byte) % 65521;
+				b = (b + a) % 65521;
+			}
+			appendBigEndian(zlib, (b << 16) | a);
+
+			std::vector<uint8_t> header;
+			appendBigEndian(header, width);
+			appendBigEndian(header, height);
+			header.insert(header.end(), {8, 2, 0, 0, 0});
+
+			std::vector<uint8_t> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+			appendChunk(png, "IHDR", header);
+			appendChunk(png, "IDAT", zlib);
+			appendChunk(png, "IEND", {});
+			return png;
+		}
+	}
+
+	LveFrameCapture::LveFrameCapture(LveDevice &device, Settings settings)
+			: m_lveDevice_{device}, m_settings_{std::move(settings)} {
+		if (m_settings_.m_format == Format::Raw) {
+			m_pipe_ = popen(m_settings_.m_output.c_str(), "w");
+			if (!m_pipe_) {
+				throw std::runtime_error("Failed to start frame capture command " + m_settings_.m_output);
+			}
+		}
+		m_slots_.resize(std::max(m_settings_.m_bufferCount, 1u));
+		m_encoder_ = std::thread(&LveFrameCapture::encode, this);
+	}
+
+	LveFrameCapture::~LveFrameCapture() {
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			for (uint32_t i = 0; i < m_slots_.size(); i++) {
+				if (m_slots_[i].m_state == SlotState::InFlight) {
+					m_slots_[i].m_state = SlotState::Encoding;
+					m_queue_.push_back(i);
+				}
+			}
+			m_stopping_ = true;
+		}
+		m_slotQueued_.notify_one();
+		m_encoder_.join();
+
+		if (m_pipe_) {
+			pclose(m_pipe_);
+		}
+	}
+
+	bool LveFrameCapture::isSupported(VkFormat format) {
+		return isBgra(format) || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+	}
+
+	void LveFrameCapture::beginFrame(int frameIndex) {
+		bool queued = false;
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			for (uint32_t i = 0; i < m_slots_.size(); i++) {
+				if (m_slots_[i].m_state == SlotState::InFlight && m_slots_[i].m_frameIndex == frameIndex) {
+					m_slots_[i].m_state = SlotState::Encoding;
+					m_queue_.push_back(i);
+					queued = true;
+				}
+			}
+		}
+		if (queued) {
+			m_slotQueued_.notify_one();
+		}
+	}
+
+	void LveFrameCapture::addCapturePass(LveRenderGraph &graph, int frameIndex, RenderGraphResource image) {
+		const auto &info = graph.getImage(image);
+		if (!isSupported(info.m_format)) {
+			throw std::runtime_error("Frame capture only supports 8-bit RGBA and BGRA images");
+		}
+		const uint64_t frameNumber = m_frameNumber_++;
+
+		Slot *slot = nullptr;
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			auto free = std::find_if(m_slots_.begin(), m_slots_.end(), [](const Slot &candidate) {
+				return candidate.m_state == SlotState::Free;
+			});
+			if (free != m_slots_.end()) {
+				slot = &*free;
+				slot->m_state = SlotState::InFlight;
+			}
+		}
+		if (!slot) {
+			m_droppedFrames_++;
+			return;
+		}
+
+		// A free buffer is neither read by the GPU nor by the encoder, so it can be replaced right away
+		const uint32_t pixelCount = info.m_extent.width * info.m_extent.height;
+		if (!slot->m_buffer || slot->m_buffer->getBufferSize() < static_cast<VkDeviceSize>(pixelCount) * bytesPerPixel) {
+			slot->m_buffer = std::make_unique<LveBuffer>(
+					m_lveDevice_,
+					bytesPerPixel,
+					pixelCount,
+					VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			slot->m_buffer->map();
+		}
+		slot->m_frameIndex = frameIndex;
+		slot->m_frameNumber = frameNumber;
+		slot->m_extent = info.m_extent;
+		slot->m_format = info.m_format;
+
+		VkBuffer buffer = slot->m_buffer->getBuffer();
+		graph.addPass("frame capture", LveRenderGraph::PassType::Transfer,
+		              [image](RenderGraphPassBuilder &pass) {
+			              // The readback buffer is outside the graph, so nothing in it reads the copy
+			              pass.transferSource(image).sideEffect();
+		              },
+		              [&graph, image, buffer](VkCommandBuffer commandBuffer) {
+			              const auto &source = graph.getImage(image);
+			              VkBufferImageCopy region{};
+			              region.bufferOffset = 0;
+			              region.bufferRowLength = 0;
+			              region.bufferImageHeight = 0;
+			              region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+			              region.imageOffset = {0, 0, 0};
+			              region.imageExtent = {source.m_extent.width, source.m_extent.height, 1};
+			              vkCmdCopyImageToBuffer(commandBuffer, source.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			                                     buffer, 1, &region);
+
+			              LveComputePipeline::bufferBarrier(commandBuffer, buffer,
+			                                                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			                                                VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+		              });
+	}
+
+	void LveFrameCapture::encode() {
+		std::vector<uint8_t> pixels;
+		while (true) {
+			uint32_t index;
+			{
+				std::unique_lock<std::mutex> lock{m_mutex_};
+				m_slotQueued_.wait(lock, [this] { return m_stopping_ || !m_queue_.empty(); });
+				if (m_queue_.empty()) {
+					return;
+				}
+				index = m_queue_.front();
+				m_queue_.pop_front();
+			}
+
+			write(m_slots_[index], pixels);
+			m_capturedFrames_++;
+
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_slots_[index].m_state = SlotState::Free;
+		}
+	}
+
+	void LveFrameCapture::write(const Slot &slot, std::vector<uint8_t> &pixels) {
+		const auto *source = static_cast<const uint8_t *>(slot.m_buffer->getMappedMemory());
+		const size_t pixelCount = static_cast<size_t>(slot.m_extent.width) * slot.m_extent.height;
+		const bool keepAlpha = m_settings_.m_format == Format::Raw;
+		const size_t channels = keepAlpha ? 4 : 3;
+		const size_t red = isBgra(slot.m_format) ? 2 : 0;
+		const size_t blue = 2 - red;
+
+		pixels.resize(pixelCount * channels);
+		for (size_t i = 0; i < pixelCount; i++) {
+			const uint8_t *texel = source + i * bytesPerPixel;
+			uint8_t *target = pixels.data() + i * channels;
+			target[0] = texel[red];
+			target[1] = texel[1];
+			target[2] = texel[blue];
+			if (keepAlpha) {
+				target[3] = texel[3];
+			}
+		}
+
+		if (m_settings_.m_format == Format::Raw) {
+			if (std::fwrite(pixels.data(), 1, pixels.size(), m_pipe_) != pixels.size()) {
+				std::cerr << "Frame capture: failed to write frame " << slot.m_frameNumber << " to the pipe" << std::endl;
+			}
+			return;
+		}
+
+		std::ostringstream path;
+		path << m_settings_.m_output << std::setw(6) << std::setfill('0') << slot.m_frameNumber
+		     << (m_settings_.m_format == Format::Png ? ".png" : ".ppm");
+		std::ofstream file{path.str(), std::ios::binary};
+		if (!file) {
+			std::cerr << "Frame capture: cannot write " << path.str() << std::endl;
+			return;
+		}
+
+		if (m_settings_.m_format == Format::Png) {
+			auto png = encodePng(pixels.data(), slot.m_extent.width, slot.m_extent.height);
+			file.write(reinterpret_cast<const char *>(png.data()), static_cast<std::streamsize>(png.size()));
+		} else {
+			file << "P6\n" << slot.m_extent.width << " " << slot.m_extent.height << "\n255\n";
+			file.write(reinterpret_cast<const char *>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+		}
+	}
+}
@@ -0,0 +1,108 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEFRAMECAPTURE_HPP
+#define VULKAN_TEST_LVEFRAMECAPTURE_HPP
+
+#include "LveBuffer.hpp"
+#include "LveDevice.hpp"
+#include "LveRenderGraph.hpp"
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	// Records rendered frames to disk without stalling the render loop. Every captured frame is copied into
+	// one of a pool of host-visible readback buffers; once the fence of its frame has been waited on, the
+	// buffer is handed to an encoder thread that writes it out and returns it to the pool. A frame for which
+	// no buffer is free is dropped and counted.
+	class LveFrameCapture {
+	public:
+		enum class Format {
+			// One numbered file per frame, m_output being the path prefix
+			Ppm,
+			Png,
+			// RGBA8 frames written back to back into the standard input of m_output, a command such as
+			// "ffmpeg -f rawvideo -pixel_format rgba -video_size 800x600 -i - capture.mp4"
+			Raw,
+		};
+
+		struct Settings {
+			Format m_format = Format::Png;
+			std::string m_output = "capture_";
+			// Frames in flight plus the frames the encoder may fall behind by
+			uint32_t m_bufferCount = 4;
+		};
+
+		LveFrameCapture(LveDevice &device, Settings settings);
+
+		// Writes the frames still queued; the device must be idle
+		~LveFrameCapture();
+
+		LveFrameCapture(const LveFrameCapture &) = delete;
+
+		LveFrameCapture &operator=(const LveFrameCapture &) = delete;
+
+		// Only 8-bit RGBA and BGRA images can be captured
+		static bool isSupported(VkFormat format);
+
+		// Hands the copies recorded for frameIndex to the encoder; its fence must have been waited on
+		void beginFrame(int frameIndex);
+
+		// Declares a pass copying image, which has to be readable with transferSource(), into a free buffer
+		void addCapturePass(LveRenderGraph &graph, int frameIndex, RenderGraphResource image);
+
+		uint64_t getCapturedFrameCount() const { return m_capturedFrames_; }
+
+		uint64_t getDroppedFrameCount() const { return m_droppedFrames_; }
+
+	private:
+		enum class SlotState {
+			Free,
+			// Copy recorded, waiting for the fence of m_frameIndex
+			InFlight,
+			Encoding,
+		};
+
+		struct Slot {
+			std::unique_ptr<LveBuffer> m_buffer;
+			SlotState m_state = SlotState::Free;
+			int m_frameIndex = 0;
+			uint64_t m_frameNumber = 0;
+			VkExtent2D m_extent{0, 0};
+			VkFormat m_format = VK_FORMAT_UNDEFINED;
+		};
+
+		void encode();
+
+		void write(const Slot &slot, std::vector<uint8_t> &pixels);
+
+		LveDevice &m_lveDevice_;
+		Settings m_settings_;
+		FILE *m_pipe_ = nullptr;
+
+		// Guards the slot states and the queue; buffers and their contents belong to whoever holds the slot
+		std::mutex m_mutex_;
+		std::condition_variable m_slotQueued_;
+		std::vector<Slot> m_slots_;
+		std::deque<uint32_t> m_queue_;
+		bool m_stopping_ = false;
+
+		uint64_t m_frameNumber_ = 0;
+		std::atomic<uint64_t> m_capturedFrames_{0};
+		std::atomic<uint64_t> m_droppedFrames_{0};
+		std::thread m_encoder_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEFRAMECAPTURE_HPP
@@ -0,0 +1,22 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEFRAMEINFO_HPP
+#define VULKAN_TEST_LVEFRAMEINFO_HPP
+
+#include "LveCamera.hpp"
+
+// lib
+#include <vulkan/vulkan.h>
+
+namespace lve {
+	struct FrameInfo {
+		int m_frameIndex;
+		float m_frameTime;
+		VkCommandBuffer m_commandBuffer;
+		LveCamera &m_camera;
+	};
+}
+
+#endif //VULKAN_TEST_LVEFRAMEINFO_HPP
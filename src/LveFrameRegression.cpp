@@ -0,0 +1,245 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveFrameRegression.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		struct Image {
+			uint32_t m_width = 0;
+			uint32_t m_height = 0;
+			std::vector<uint8_t> m_rgb;
+		};
+
+		// Reads the binary PPMs written by LveFrameCapture
+		Image readPpm(const std::string &path) {
+			std::ifstream file{path, std::ios::binary};
+			std::string magic;
+			uint32_t maxValue = 0;
+			Image image{};
+			file >> magic >> image.m_width >> image.m_height >> maxValue;
+			file.get();
+			if (!file || magic != "P6" || maxValue != 255) {
+				throw std::runtime_error("Cannot read image " + path);
+			}
+			image.m_rgb.resize(static_cast<size_t>(image.m_width) * image.m_height * 3);
+			file.read(reinterpret_cast<char *>(image.m_rgb.data()), static_cast<std::streamsize>(image.m_rgb.size()));
+			if (!file) {
+				throw std::runtime_error("Truncated image " + path);
+			}
+			return image;
+		}
+
+		// Squared YIQ distance, which follows perceived color differences more closely than RGB
+		float colorDistance(const uint8_t *a, const uint8_t *b) {
+			float dr = static_cast<float>(a[0]) - static_cast<float>(b[0]);
+			float dg = static_cast<float>(a[1]) - static_cast<float>(b[1]);
+			float db = static_cast<float>(a[2]) - static_cast<float>(b[2]);
+			float y = dr * 0.29889531f + dg * 0.58662247f + db * 0.11448223f;
+			float i = dr * 0.59597799f - dg * 0.27417610f - db * 0.32180189f;
+			float q = dr * 0.21147017f - dg * 0.52261711f + db * 0.31114694f;
+			return 0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q;
+		}
+
+		// Largest possible colorDistance, between black and white
+		constexpr float maxColorDistance = 35215.f;
+	}
+
+	LveFrameRegression::LveFrameRegression(LveDevice &device, Settings settings)
+			: m_lveDevice_{device}, m_settings_{std::move(settings)} {
+		if (m_settings_.m_shots.empty() || m_settings_.m_measuredFrames == 0) {
+			throw std::runtime_error("A regression run needs at least one shot and one measured frame");
+		}
+
+		LveFrameCapture::Settings captureSettings{};
+		captureSettings.m_format = LveFrameCapture::Format::Ppm;
+		captureSettings.m_output = m_settings_.m_outputPrefix;
+		m_capture_ = std::make_unique<LveFrameCapture>(m_lveDevice_, captureSettings);
+		if (LveGpuTimer::isSupported(m_lveDevice_)) {
+			m_gpuTimer_ = std::make_unique<LveGpuTimer>(m_lveDevice_);
+		}
+
+		m_timings_.resize(m_settings_.m_shots.size());
+		m_frameShots_.resize(LveSwapChain::m_maxFramesInFlight, -1);
+	}
+
+	void LveFrameRegression::beginFrame(int frameIndex) {
+		readGpuTime(frameIndex);
+		m_capture_->beginFrame(frameIndex);
+		m_frameStart_ = std::chrono::steady_clock::now();
+	}
+
+	void LveFrameRegression::readGpuTime(int frameIndex) {
+		const int shot = m_frameShots_[frameIndex];
+		m_frameShots_[frameIndex] = -1;
+		if (!m_gpuTimer_) {
+			return;
+		}
+		double milliseconds = m_gpuTimer_->readFrame(frameIndex);
+		if (shot >= 0 && milliseconds >= 0.0) {
+			m_timings_[shot].m_gpuMilliseconds += milliseconds;
+			m_timings_[shot].m_gpuSamples++;
+		}
+	}
+
+	void LveFrameRegression::addBeginPasses(LveRenderGraph &graph, int frameIndex) {
+		if (m_gpuTimer_) {
+			m_gpuTimer_->addBeginPass(graph, frameIndex);
+		}
+	}
+
+	void LveFrameRegression::addEndPasses(LveRenderGraph &graph, int frameIndex, RenderGraphResource color) {
+#ifndef NDEBUG
+		assert(!isFinished() && "All shots have been rendered");
+#endif
+		if (m_gpuTimer_) {
+			m_gpuTimer_->addEndPass(graph, frameIndex);
+		}
+
+		const bool measured = m_shotFrame_ >= m_settings_.m_warmupFrames;
+		m_frameShots_[frameIndex] = measured ? static_cast<int>(m_shot_) : -1;
+		m_cpuShot_ = m_frameShots_[frameIndex];
+
+		// Captures are numbered in order, so the n-th one belongs to shot n
+		if (++m_shotFrame_ == m_settings_.m_warmupFrames + m_settings_.m_measuredFrames) {
+			m_capture_->addCapturePass(graph, frameIndex, color);
+			m_shot_++;
+			m_shotFrame_ = 0;
+		}
+	}
+
+	void LveFrameRegression::endFrame() {
+		if (m_cpuShot_ < 0) {
+			return;
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_frameStart_;
+		m_timings_[m_cpuShot_].m_cpuMilliseconds += elapsed.count();
+		m_timings_[m_cpuShot_].m_cpuSamples++;
+		m_cpuShot_ = -1;
+	}
+
+	std::string LveFrameRegression::capturedFramePath(uint32_t shot) const {
+		std::ostringstream path;
+		path << m_settings_.m_outputPrefix << std::setw(6) << std::setfill('0') << shot << ".ppm";
+		return path.str();
+	}
+
+	void LveFrameRegression::finish() {
+		for (int i = 0; i < LveSwapChain::m_maxFramesInFlight; i++) {
+			readGpuTime(i);
+		}
+		const auto droppedFrames = m_capture_->getDroppedFrameCount();
+		// Writes out the frames still queued
+		m_capture_.reset();
+
+		std::vector<std::string> failures;
+		if (droppedFrames > 0) {
+			failures.push_back(std::to_string(droppedFrames) + " captures were dropped");
+		}
+		if (!isFinished()) {
+			failures.push_back("the run ended before the last shot");
+		}
+
+		const std::filesystem::path goldenDirectory{m_settings_.m_goldenDirectory};
+		const auto baselinePath = goldenDirectory / "baseline.txt";
+
+		if (m_settings_.m_updateGoldens) {
+			std::filesystem::create_directories(goldenDirectory);
+			std::ofstream baseline{baselinePath};
+			for (uint32_t i = 0; i < m_shot_; i++) {
+				const auto &shot = m_settings_.m_shots[i];
+				const auto &timing = m_timings_[i];
+				std::filesystem::copy_file(capturedFramePath(i), goldenDirectory / (shot.m_name + ".ppm"),
+				                           std::filesystem::copy_options::overwrite_existing);
+				baseline << shot.m_name << " "
+				         << (timing.m_cpuSamples ? timing.m_cpuMilliseconds / timing.m_cpuSamples : 0.0) << " "
+				         << (timing.m_gpuSamples ? timing.m_gpuMilliseconds / timing.m_gpuSamples : 0.0) << "\n";
+			}
+			std::cout << "updated " << m_shot_ << " golden frames in " << goldenDirectory.string() << std::endl;
+		} else {
+			// name -> {cpu, gpu} milliseconds
+			std::map<std::string, std::pair<double, double>> baselines;
+			// Goldens that were never recorded must not pass as a run without regressions
+			const std::string recordHint = ", record it with --update-goldens " + goldenDirectory.string();
+			if (!std::filesystem::exists(baselinePath)) {
+				failures.push_back("no baseline " + baselinePath.string() + recordHint);
+			}
+			std::ifstream baseline{baselinePath};
+			std::string name;
+			double cpu;
+			double gpu;
+			while (baseline >> name >> cpu >> gpu) {
+				baselines[name] = {cpu, gpu};
+			}
+
+			const float threshold = maxColorDistance * m_settings_.m_colorThreshold * m_settings_.m_colorThreshold;
+			for (uint32_t i = 0; i < m_shot_; i++) {
+				const auto &shot = m_settings_.m_shots[i];
+				const auto &timing = m_timings_[i];
+				const double cpuMilliseconds = timing.m_cpuSamples ? timing.m_cpuMilliseconds / timing.m_cpuSamples : 0.0;
+				const double gpuMilliseconds = timing.m_gpuSamples ? timing.m_gpuMilliseconds / timing.m_gpuSamples : 0.0;
+
+				const auto goldenPath = goldenDirectory / (shot.m_name + ".ppm");
+				if (!std::filesystem::exists(goldenPath)) {
+					failures.push_back(shot.m_name + ": no golden image " + goldenPath.string() + recordHint);
+					continue;
+				}
+				auto golden = readPpm(goldenPath.string());
+				auto frame = readPpm(capturedFramePath(i));
+				double differing = 1.0;
+				if (golden.m_width == frame.m_width && golden.m_height == frame.m_height) {
+					size_t count = 0;
+					for (size_t p = 0; p < frame.m_rgb.size(); p += 3) {
+						if (colorDistance(&frame.m_rgb[p], &golden.m_rgb[p]) > threshold) {
+							count++;
+						}
+					}
+					differing = static_cast<double>(count) / (static_cast<double>(frame.m_rgb.size()) / 3.0);
+				} else {
+					failures.push_back(shot.m_name + ": frame size differs from the golden image");
+				}
+				if (differing > m_settings_.m_maxDifferingPixels) {
+					failures.push_back(shot.m_name + ": " + std::to_string(differing * 100.0) + "% of the pixels differ");
+				}
+
+				std::cout << shot.m_name << ": " << differing * 100.0 << "% pixels differ, cpu " << cpuMilliseconds
+				          << " ms, gpu " << gpuMilliseconds << " ms";
+				auto reference = baselines.find(shot.m_name);
+				if (reference == baselines.end()) {
+					std::cout << ", no baseline" << std::endl;
+					failures.push_back(shot.m_name + ": not in " + baselinePath.string() + recordHint);
+					continue;
+				}
+				auto [cpuBaseline, gpuBaseline] = reference->second;
+				std::cout << " (baseline cpu " << cpuBaseline << " ms, gpu " << gpuBaseline << " ms)" << std::endl;
+				if (cpuBaseline > 0.0 && cpuMilliseconds > cpuBaseline * m_settings_.m_maxSlowdown) {
+					failures.push_back(shot.m_name + ": cpu frame time regressed");
+				}
+				if (gpuBaseline > 0.0 && gpuMilliseconds > gpuBaseline * m_settings_.m_maxSlowdown) {
+					failures.push_back(shot.m_name + ": gpu frame time regressed");
+				}
+			}
+		}
+
+		if (!failures.empty()) {
+			std::string message = "Frame regression failed:";
+			for (const auto &failure: failures) {
+				message += "\n  " + failure;
+			}
+			throw std::runtime_error(message);
+		}
+	}
+}
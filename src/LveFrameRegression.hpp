@@ -0,0 +1,111 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEFRAMEREGRESSION_HPP
+#define VULKAN_TEST_LVEFRAMEREGRESSION_HPP
+
+#include "LveDevice.hpp"
+#include "LveFrameCapture.hpp"
+#include "LveGpuTimer.hpp"
+#include "LveRenderGraph.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+
+// std
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Renders a scripted sequence of camera shots and checks the result against stored references. The last
+	// frame of every shot is compared with its golden image, and the CPU and GPU frame times measured after
+	// a warm-up are compared with a stored baseline. With m_updateGoldens the references are rewritten from
+	// this run instead.
+	class LveFrameRegression {
+	public:
+		// The app sets up the scene of a shot; besides the camera it picks the render layers drawn and the
+		// debug view, a RenderSystem::DebugView
+		struct Shot {
+			std::string m_name;
+			glm::vec3 m_translation;
+			glm::vec3 m_rotation;
+			uint32_t m_renderLayers = ~0u;
+			uint32_t m_debugView = 0;
+		};
+
+		struct Settings {
+			// Holds <shot name>.ppm per shot and baseline.txt with the frame times
+			std::string m_goldenDirectory;
+			// Prefix of the frames captured by this run
+			std::string m_outputPrefix = "regression_";
+			bool m_updateGoldens = false;
+			std::vector<Shot> m_shots;
+			uint32_t m_warmupFrames = 30;
+			uint32_t m_measuredFrames = 120;
+			// A pixel differs when its YIQ color distance exceeds this fraction of the largest possible one
+			float m_colorThreshold = 0.1f;
+			// Fraction of the pixels that may differ before a shot fails
+			float m_maxDifferingPixels = 0.001f;
+			// Frame times may grow by this factor relative to the baseline
+			float m_maxSlowdown = 1.25f;
+		};
+
+		LveFrameRegression(LveDevice &device, Settings settings);
+
+		LveFrameRegression(const LveFrameRegression &) = delete;
+
+		LveFrameRegression &operator=(const LveFrameRegression &) = delete;
+
+		bool isFinished() const { return m_shot_ >= m_settings_.m_shots.size(); }
+
+		const Shot &getCurrentShot() const { return m_settings_.m_shots[m_shot_]; }
+
+		// Call once the fence of frameIndex has been waited on
+		void beginFrame(int frameIndex);
+
+		// Declared before and after the passes of the frame
+		void addBeginPasses(LveRenderGraph &graph, int frameIndex);
+
+		void addEndPasses(LveRenderGraph &graph, int frameIndex, RenderGraphResource color);
+
+		// Call after the frame has been submitted
+		void endFrame();
+
+		// Compares with or updates the references once the device is idle. Throws when a shot diverges from
+		// its golden image or got slower than the baseline allows.
+		void finish();
+
+	private:
+		struct ShotTiming {
+			double m_cpuMilliseconds = 0.0;
+			uint32_t m_cpuSamples = 0;
+			double m_gpuMilliseconds = 0.0;
+			uint32_t m_gpuSamples = 0;
+		};
+
+		void readGpuTime(int frameIndex);
+
+		std::string capturedFramePath(uint32_t shot) const;
+
+		LveDevice &m_lveDevice_;
+		Settings m_settings_;
+		std::unique_ptr<LveFrameCapture> m_capture_;
+		std::unique_ptr<LveGpuTimer> m_gpuTimer_;
+
+		std::vector<ShotTiming> m_timings_;
+		// Shot whose time each frame in flight measures, -1 during warm-up
+		std::vector<int> m_frameShots_;
+		uint32_t m_shot_ = 0;
+		uint32_t m_shotFrame_ = 0;
+		int m_cpuShot_ = -1;
+		std::chrono::steady_clock::time_point m_frameStart_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEFRAMEREGRESSION_HPP
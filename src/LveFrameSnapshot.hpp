@@ -0,0 +1,42 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEFRAMESNAPSHOT_HPP
+#define VULKAN_TEST_LVEFRAMESNAPSHOT_HPP
+
+#include "LveModel.hpp"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+	// What the render systems draw of a game object
+	struct RenderObject {
+		std::shared_ptr<LveModel> m_model;
+		glm::mat4 m_worldMatrix{1.f};
+		glm::vec3 m_color{};
+		// Objects below 1 are blended and drawn after all opaque objects, back to front
+		float m_opacity = 1.f;
+		uint32_t m_renderLayers = 1u;
+		// TextureId of the LveTextureManager the render system samples from, ~0u for none
+		uint32_t m_texture = ~0u;
+	};
+
+	// State of one simulation step, copied out of the game objects so the render thread can record it
+	// while the simulation already works on the next step
+	struct FrameSnapshot {
+		float m_frameTime = 0.f;
+		glm::vec3 m_cameraTranslation{};
+		glm::vec3 m_cameraRotation{};
+		// Game objects that have a model
+		std::vector<RenderObject> m_objects;
+	};
+}
+
+#endif //VULKAN_TEST_LVEFRAMESNAPSHOT_HPP
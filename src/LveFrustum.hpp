@@ -0,0 +1,54 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEFRUSTUM_HPP
+#define VULKAN_TEST_LVEFRUSTUM_HPP
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+
+namespace lve {
+
+	// View frustum as six inward-facing planes (xyz = normal, w = distance), extracted from a
+	// projection * view matrix using Vulkan's 0..1 clip space depth range.
+	struct LveFrustum {
+		std::array<glm::vec4, 6> m_planes{};
+
+		static LveFrustum fromMatrix(const glm::mat4 &projectionView) {
+			auto row = [&](int i) {
+				return glm::vec4{projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]};
+			};
+			const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+			LveFrustum frustum{};
+			frustum.m_planes[0] = r3 + r0;  // left
+			frustum.m_planes[1] = r3 - r0;  // right
+			frustum.m_planes[2] = r3 + r1;  // top (y points down)
+			frustum.m_planes[3] = r3 - r1;  // bottom
+			frustum.m_planes[4] = r2;       // near
+			frustum.m_planes[5] = r3 - r2;  // far
+
+			for (auto &plane: frustum.m_planes) {
+				plane = plane / glm::length(glm::vec3{plane});
+			}
+			return frustum;
+		}
+
+		bool intersectsSphere(const glm::vec3 &center, float radius) const {
+			for (const auto &plane: m_planes) {
+				if (glm::dot(glm::vec3{plane}, center) + plane.w < -radius) {
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+}
+
+#endif //VULKAN_TEST_LVEFRUSTUM_HPP
@@ -3,3 +3,11 @@
 //
 
 #include "LveGameObject.hpp"
+
+namespace lve {
+
+	LveHandleAllocator &LveGameObject::getHandleAllocator() {
+		static LveHandleAllocator allocator;
+		return allocator;
+	}
+}
@@ -5,7 +5,10 @@
 #ifndef VULKAN_TEST_LVEGAMEOBJECT_HPP
 #define VULKAN_TEST_LVEGAMEOBJECT_HPP
 
+#include "LveHandle.hpp"
 #include "LveModel.hpp"
+#include "LveSceneGraph.hpp"
+#include "LveTransform.hpp"
 
 // libs
 #include "glm/gtc/matrix_transform.hpp"
@@ -14,47 +17,10 @@
 
 // std
 #include <memory>
+#include <utility>
 
 namespace lve {
 
-	struct TransformComponent {
-		glm::vec3 m_translation{};
-		glm::vec3 m_scale{1.f, 1.f, 1.f};
-		glm::vec3 m_rotation{};
-
-		// Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
-		// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
-		// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
-		glm::mat4 mat4() {
-			const float c3 = glm::cos(m_rotation.z);
-			const float s3 = glm::sin(m_rotation.z);
-			const float c2 = glm::cos(m_rotation.x);
-			const float s2 = glm::sin(m_rotation.x);
-			const float c1 = glm::cos(m_rotation.y);
-			const float s1 = glm::sin(m_rotation.y);
-			return glm::mat4{
-					{
-							m_scale.x * (c1 * c3 + s1 * s2 * s3),
-							                 m_scale.x * (c2 * s3),
-							                                  m_scale.x * (c1 * s2 * s3 - c3 * s1),
-							                                                   0.0f,
-					},
-					{
-							m_scale.y * (c3 * s1 * s2 - c1 * s3),
-							                 m_scale.y * (c2 * c3),
-							                                  m_scale.y * (c1 * c3 * s2 + s1 * s3),
-							                                                   0.0f,
-					},
-					{
-							m_scale.z * (c2 * s1),
-							                 m_scale.z * (-s2),
-							                                  m_scale.z * (c1 * c2),
-							                                                   0.0f,
-					},
-					{       m_translation.x, m_translation.y, m_translation.z, 1.0f}};
-		}
-	};
-
 	struct RigidBody2dComponent {
 		glm::vec2 velocity;
 		float mass{1.0f};
@@ -62,12 +28,15 @@ namespace lve {
 
 	class LveGameObject {
 	public:
-		using id_t = unsigned int;
+		// Stays unique while the object exists; once it is destroyed the id is stale and its slot is reused
+		using id_t = LveHandle;
+
+		// Safe to call from any thread
+		static LveGameObject createGameObject() { return LveGameObject{getHandleAllocator().allocate()}; }
 
-		static LveGameObject createGameObject() {
-			static id_t currentId = 0;
-			return LveGameObject{currentId++};
-		}
+		// Issues the ids of every game object. Owners keeping objects in an array can store their position as
+		// the value of the id to find them in O(1).
+		static LveHandleAllocator &getHandleAllocator();
 
 		LveGameObject(const LveGameObject &) = delete;
 
@@ -77,18 +46,54 @@ namespace lve {
 
 		LveGameObject &operator=(LveGameObject &&) = default;
 
-		id_t getId() const { return m_id_; }
+		id_t getId() const { return m_id_.m_handle; }
 
 		std::shared_ptr<LveModel> m_model{};
 		glm::vec3 m_color{};
+		// Objects below 1 are blended and drawn after all opaque objects, back to front
+		float m_opacity{1.f};
+		// Bit mask of the render layers the object belongs to, which views such as regression shots select
+		uint32_t m_renderLayers{1u};
+		// TextureId of the application's LveTextureManager, ~0u for none
+		uint32_t m_texture{~0u};
+		// Relative to the parent of m_sceneNode
 		TransformComponent m_transform{};
+		SceneNode m_sceneNode = LveSceneGraph::m_invalidNode;
+		// Copied from the scene graph after each simulation step; rendering blends from the previous one
+		glm::mat4 m_worldMatrix{1.f};
+		glm::mat4 m_previousWorldMatrix{1.f};
 		RigidBody2dComponent m_rigidBody2D{glm::vec2{0, 0}};
 
 
 	private:
-		LveGameObject(id_t objId) : m_id_{objId} {};
+		// Releases the id when the object is destroyed, moved-from objects hold a null one
+		struct OwnedId {
+			explicit OwnedId(id_t handle) : m_handle{handle} {}
+
+			OwnedId(OwnedId &&other) noexcept: m_handle{std::exchange(other.m_handle, id_t{})} {}
+
+			OwnedId &operator=(OwnedId &&other) noexcept {
+				if (this != &other) {
+					release();
+					m_handle = std::exchange(other.m_handle, id_t{});
+				}
+				return *this;
+			}
+
+			~OwnedId() { release(); }
+
+			void release() {
+				if (!m_handle.isNull()) {
+					getHandleAllocator().release(m_handle);
+				}
+			}
+
+			id_t m_handle;
+		};
+
+		explicit LveGameObject(id_t objId) : m_id_{objId} {};
 
-		id_t m_id_;
+		OwnedId m_id_;
 	};
 }
 
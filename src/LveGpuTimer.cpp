@@ -0,0 +1,73 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveGpuTimer.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <array>
+#include <stdexcept>
+
+namespace lve {
+
+	LveGpuTimer::LveGpuTimer(LveDevice &device)
+			: m_lveDevice_{device},
+			  m_timestampValidBits_{device.findPhysicalQueueFamilies().m_graphicsTimestampValidBits} {
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 2 * LveSwapChain::m_maxFramesInFlight;
+		if (vkCreateQueryPool(m_lveDevice_.device(), &queryPoolInfo, nullptr, &m_queryPool_) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create timestamp query pool");
+		}
+		m_recorded_.resize(LveSwapChain::m_maxFramesInFlight, false);
+	}
+
+	LveGpuTimer::~LveGpuTimer() {
+		vkDestroyQueryPool(m_lveDevice_.device(), m_queryPool_, nullptr);
+	}
+
+	void LveGpuTimer::addBeginPass(LveRenderGraph &graph, int frameIndex) {
+		const auto firstQuery = static_cast<uint32_t>(2 * frameIndex);
+		graph.addPass("gpu timer begin", LveRenderGraph::PassType::Transfer,
+		              [](RenderGraphPassBuilder &pass) { pass.sideEffect(); },
+		              [this, firstQuery](VkCommandBuffer commandBuffer) {
+			              vkCmdResetQueryPool(commandBuffer, m_queryPool_, firstQuery, 2);
+			              vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool_, firstQuery);
+		              });
+	}
+
+	void LveGpuTimer::addEndPass(LveRenderGraph &graph, int frameIndex) {
+		const auto firstQuery = static_cast<uint32_t>(2 * frameIndex);
+		graph.addPass("gpu timer end", LveRenderGraph::PassType::Transfer,
+		              [](RenderGraphPassBuilder &pass) { pass.sideEffect(); },
+		              [this, firstQuery](VkCommandBuffer commandBuffer) {
+			              vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool_,
+			                                  firstQuery + 1);
+		              });
+		m_recorded_[frameIndex] = true;
+	}
+
+	double LveGpuTimer::readFrame(int frameIndex) {
+		if (!m_recorded_[frameIndex]) {
+			return -1.0;
+		}
+		m_recorded_[frameIndex] = false;
+
+		std::array<uint64_t, 2> timestamps{};
+		if (vkGetQueryPoolResults(m_lveDevice_.device(), m_queryPool_, static_cast<uint32_t>(2 * frameIndex), 2,
+		                          sizeof(timestamps), timestamps.data(), sizeof(uint64_t),
+		                          VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+			return -1.0;
+		}
+		// The bits above timestampValidBits are undefined, and the counter may have wrapped between the two
+		// writes; modulo its width the difference is still the elapsed time
+		uint64_t elapsed = timestamps[1] - timestamps[0];
+		if (m_timestampValidBits_ < 64) {
+			const uint64_t mask = (uint64_t{1} << m_timestampValidBits_) - 1;
+			elapsed = ((timestamps[1] & mask) - (timestamps[0] & mask)) & mask;
+		}
+		return static_cast<double>(elapsed) * m_lveDevice_.m_properties.limits.timestampPeriod / 1e6;
+	}
+}
@@ -0,0 +1,51 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEGPUTIMER_HPP
+#define VULKAN_TEST_LVEGPUTIMER_HPP
+
+#include "LveDevice.hpp"
+#include "LveRenderGraph.hpp"
+
+// std
+#include <vector>
+
+namespace lve {
+
+	// Measures the GPU time of a frame with timestamp queries written around its render graph passes, one
+	// query pair per frame in flight.
+	class LveGpuTimer {
+	public:
+		explicit LveGpuTimer(LveDevice &device);
+
+		~LveGpuTimer();
+
+		LveGpuTimer(const LveGpuTimer &) = delete;
+
+		LveGpuTimer &operator=(const LveGpuTimer &) = delete;
+
+		static bool isSupported(LveDevice &device) {
+			return device.m_properties.limits.timestampComputeAndGraphics &&
+			       device.findPhysicalQueueFamilies().m_graphicsTimestampValidBits > 0;
+		}
+
+		// Declare first and last in the frame; every pass in between is measured
+		void addBeginPass(LveRenderGraph &graph, int frameIndex);
+
+		void addEndPass(LveRenderGraph &graph, int frameIndex);
+
+		// Milliseconds measured the last time frameIndex was rendered, negative when nothing was recorded.
+		// The fence of frameIndex must have been waited on.
+		double readFrame(int frameIndex);
+
+	private:
+		LveDevice &m_lveDevice_;
+		VkQueryPool m_queryPool_ = VK_NULL_HANDLE;
+		// Timestamps wrap around within this many bits, at most 64
+		uint32_t m_timestampValidBits_;
+		std::vector<bool> m_recorded_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEGPUTIMER_HPP
@@ -0,0 +1,92 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveHandle.hpp"
+
+// std
+#include <stdexcept>
+
+namespace lve {
+
+	LveHandle LveHandleAllocator::allocate(uint32_t value) {
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		uint32_t index;
+		if (!m_freeSlots_.empty()) {
+			index = m_freeSlots_.back();
+			m_freeSlots_.pop_back();
+		} else {
+			if (m_slotCount_ == m_pageSize * m_maxPages) {
+				throw std::runtime_error("Out of handles");
+			}
+			index = m_slotCount_++;
+			if ((index & (m_pageSize - 1)) == 0) {
+				m_ownedPages_.push_back(std::make_unique<Page>());
+				m_pages_[index >> m_pageBits].store(m_ownedPages_.back().get(), std::memory_order_release);
+			}
+			// Fresh slots start at generation 1, released ones were bumped past their last handle already
+			getSlot(index).m_generation.store(1, std::memory_order_relaxed);
+		}
+
+		auto &slot = getSlot(index);
+		slot.m_value.store(value, std::memory_order_relaxed);
+		m_aliveCount_.fetch_add(1, std::memory_order_relaxed);
+		return LveHandle{index, slot.m_generation.load(std::memory_order_relaxed)};
+	}
+
+	bool LveHandleAllocator::release(LveHandle handle) {
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		if (!isAlive(handle)) {
+			return false;
+		}
+
+		auto &slot = getSlot(handle.m_index);
+		const uint32_t generation = handle.m_generation + 1;
+		slot.m_value.store(m_invalidValue, std::memory_order_relaxed);
+		slot.m_generation.store(generation, std::memory_order_release);
+		m_aliveCount_.fetch_sub(1, std::memory_order_relaxed);
+		// A slot whose generation would wrap around to 0 is retired instead, or old handles could match again
+		if (generation != 0) {
+			m_freeSlots_.push_back(handle.m_index);
+		}
+		return true;
+	}
+
+	bool LveHandleAllocator::isAlive(LveHandle handle) const {
+		const Slot *slot = findSlot(handle.m_index);
+		return slot && !handle.isNull() && slot->m_generation.load(std::memory_order_acquire) == handle.m_generation;
+	}
+
+	uint32_t LveHandleAllocator::lookup(LveHandle handle) const {
+		const Slot *slot = findSlot(handle.m_index);
+		if (!slot || handle.isNull() || slot->m_generation.load(std::memory_order_acquire) != handle.m_generation) {
+			return m_invalidValue;
+		}
+		const uint32_t value = slot->m_value.load(std::memory_order_acquire);
+		// The handle may have been released while the value was read
+		if (slot->m_generation.load(std::memory_order_acquire) != handle.m_generation) {
+			return m_invalidValue;
+		}
+		return value;
+	}
+
+	bool LveHandleAllocator::setValue(LveHandle handle, uint32_t value) {
+		if (!isAlive(handle)) {
+			return false;
+		}
+		getSlot(handle.m_index).m_value.store(value, std::memory_order_release);
+		return true;
+	}
+
+	const LveHandleAllocator::Slot *LveHandleAllocator::findSlot(uint32_t index) const {
+		if ((index >> m_pageBits) >= m_maxPages) {
+			return nullptr;
+		}
+		const Page *page = m_pages_[index >> m_pageBits].load(std::memory_order_acquire);
+		return page ? &page->m_slots[index & (m_pageSize - 1)] : nullptr;
+	}
+
+	LveHandleAllocator::Slot &LveHandleAllocator::getSlot(uint32_t index) const {
+		return m_pages_[index >> m_pageBits].load(std::memory_order_acquire)->m_slots[index & (m_pageSize - 1)];
+	}
+}
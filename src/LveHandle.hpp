@@ -0,0 +1,96 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEHANDLE_HPP
+#define VULKAN_TEST_LVEHANDLE_HPP
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+	// Index of a slot plus the generation it had when the handle was issued. Releasing the slot bumps its
+	// generation, so handles kept past the release no longer match and are detected as stale.
+	struct LveHandle {
+		uint32_t m_index = 0;
+		// 0 is never issued
+		uint32_t m_generation = 0;
+
+		bool isNull() const { return m_generation == 0; }
+
+		bool operator==(const LveHandle &other) const {
+			return m_index == other.m_index && m_generation == other.m_generation;
+		}
+
+		bool operator!=(const LveHandle &other) const { return !(*this == other); }
+	};
+
+	// Issues LveHandles and recycles their slots through a free list. Every slot holds one value, typically
+	// the position of the object in a dense array, which lookup() returns in O(1) for live handles.
+	//
+	// allocate() and release() may be called from any thread. isAlive(), lookup() and setValue() are lock
+	// free and may run concurrently with them for other handles.
+	class LveHandleAllocator {
+	public:
+		static constexpr uint32_t m_invalidValue = ~0u;
+
+		LveHandleAllocator() = default;
+
+		LveHandleAllocator(const LveHandleAllocator &) = delete;
+
+		LveHandleAllocator &operator=(const LveHandleAllocator &) = delete;
+
+		// Throws once every slot is in use
+		LveHandle allocate(uint32_t value = m_invalidValue);
+
+		// Returns false, and leaves the slot alone, when handle is stale
+		bool release(LveHandle handle);
+
+		bool isAlive(LveHandle handle) const;
+
+		// m_invalidValue when handle is stale
+		uint32_t lookup(LveHandle handle) const;
+
+		// Returns false when handle is stale
+		bool setValue(LveHandle handle, uint32_t value);
+
+		uint32_t getAliveCount() const { return m_aliveCount_.load(std::memory_order_relaxed); }
+
+	private:
+		static constexpr uint32_t m_pageBits = 16;
+		static constexpr uint32_t m_pageSize = 1u << m_pageBits;
+		static constexpr uint32_t m_maxPages = 4096;
+
+		struct Slot {
+			std::atomic<uint32_t> m_generation{0};
+			std::atomic<uint32_t> m_value{m_invalidValue};
+		};
+
+		struct Page {
+			std::array<Slot, m_pageSize> m_slots;
+		};
+
+		// Null for slots past the last page; pages are never moved, so lookups need no lock
+		const Slot *findSlot(uint32_t index) const;
+
+		Slot &getSlot(uint32_t index) const;
+
+		std::array<std::atomic<Page *>, m_maxPages> m_pages_{};
+		// Owns the pages published in m_pages_
+		std::vector<std::unique_ptr<Page>> m_ownedPages_;
+		std::atomic<uint32_t> m_aliveCount_{0};
+
+		// Guards the free list and slot creation
+		std::mutex m_mutex_;
+		std::vector<uint32_t> m_freeSlots_;
+		uint32_t m_slotCount_ = 0;
+	};
+}
+
+#endif //VULKAN_TEST_LVEHANDLE_HPP
@@ -0,0 +1,352 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveJobSystem.hpp"
+
+// std
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t noDeque = ~0u;
+
+		// Deque of the worker running on this thread
+		thread_local const LveJobSystem *workerSystem = nullptr;
+		thread_local uint32_t workerIndex = noDeque;
+
+		uint32_t nextRandom() {
+			thread_local uint32_t state = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+	}
+
+	// Chase and Lev, with the memory orderings of Lê et al., "Correct and Efficient Work-Stealing for Weak
+	// Memory Models" (2013)
+	bool LveJobSystem::Deque::push(Task *task) {
+		const int64_t bottom = m_bottom_.load(std::memory_order_relaxed);
+		const int64_t top = m_top_.load(std::memory_order_acquire);
+		if (bottom - top >= m_capacity) {
+			return false;
+		}
+		m_tasks_[bottom & (m_capacity - 1)].store(task, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_bottom_.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	LveJobSystem::Task *LveJobSystem::Deque::pop() {
+		const int64_t bottom = m_bottom_.load(std::memory_order_relaxed) - 1;
+		m_bottom_.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top_.load(std::memory_order_relaxed);
+		if (top > bottom) {
+			m_bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Task *task = m_tasks_[bottom & (m_capacity - 1)].load(std::memory_order_relaxed);
+		if (top == bottom) {
+			// The last task, a thief may be taking it at the same time
+			if (!m_top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				task = nullptr;
+			}
+			m_bottom_.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return task;
+	}
+
+	LveJobSystem::Task *LveJobSystem::Deque::steal() {
+		int64_t top = m_top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t bottom = m_bottom_.load(std::memory_order_acquire);
+		if (top >= bottom) {
+			return nullptr;
+		}
+
+		Task *task = m_tasks_[top & (m_capacity - 1)].load(std::memory_order_relaxed);
+		if (!m_top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return task;
+	}
+
+	LveJobSystem::LveJobSystem(uint32_t workerCount) : m_ownerThread_{std::this_thread::get_id()} {
+		// hardware_concurrency() may report 0
+		if (workerCount > 1024) {
+			workerCount = 0;
+		}
+		for (uint32_t i = 0; i <= workerCount; i++) {
+			m_deques_.push_back(std::make_unique<Deque>());
+		}
+		for (uint32_t i = 0; i < workerCount; i++) {
+			m_workers_.emplace_back(&LveJobSystem::work, this, i + 1);
+		}
+	}
+
+	LveJobSystem::~LveJobSystem() {
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_stopping_ = true;
+		}
+		m_taskQueued_.notify_all();
+		for (auto &worker: m_workers_) {
+			worker.join();
+		}
+		// Without workers the owner's deque is drained here
+		while (tryRunJob()) {}
+	}
+
+	void LveJobSystem::run(Job job, LveJobCounter *counter) {
+		if (counter) {
+			counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+		}
+		auto *task = new Task{std::move(job), counter};
+
+		const uint32_t index = currentIndex();
+		m_queuedTasks_.fetch_add(1);
+		if (index == noDeque) {
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_sharedTasks_.push_back(task);
+		} else if (!m_deques_[index]->push(task)) {
+			m_queuedTasks_.fetch_sub(1);
+			execute(task);
+			return;
+		}
+
+		// Pairs with the sleeping worker checking m_queuedTasks_ under the lock, so the wakeup is not lost
+		if (m_sleepingWorkers_.load() > 0) {
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_taskQueued_.notify_one();
+		}
+	}
+
+	void LveJobSystem::wait(LveJobCounter &counter) {
+		while (!counter.isDone()) {
+			if (!tryRunJob()) {
+				std::this_thread::yield();
+			}
+		}
+
+		std::exception_ptr exception;
+		{
+			std::lock_guard<std::mutex> lock{counter.m_exceptionMutex_};
+			exception = std::exchange(counter.m_exception_, nullptr);
+		}
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void LveJobSystem::parallelFor(uint32_t count, uint32_t grainSize, const RangeJob &job) {
+		grainSize = std::max(grainSize, 1u);
+		const uint32_t rangeCount = (count + grainSize - 1) / grainSize;
+		if (rangeCount < 2 || m_workers_.empty()) {
+			if (count > 0) {
+				job(0, count);
+			}
+			return;
+		}
+
+		LveJobCounter counter;
+		for (uint32_t range = 1; range < rangeCount; range++) {
+			run([&job, range, grainSize, count]() {
+				const uint32_t begin = range * grainSize;
+				job(begin, std::min(begin + grainSize, count));
+			}, &counter);
+		}
+		// The other ranges refer to job and counter, so they have to finish before this one may throw
+		try {
+			job(0, grainSize);
+		} catch (...) {
+			recordException(counter, std::current_exception());
+		}
+		wait(counter);
+	}
+
+	bool LveJobSystem::tryRunJob() {
+		Task *task = findTask(currentIndex());
+		if (!task) {
+			return false;
+		}
+		execute(task);
+		return true;
+	}
+
+	void LveJobSystem::work(uint32_t index) {
+		workerSystem = this;
+		workerIndex = index;
+		while (true) {
+			if (tryRunJob()) {
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock{m_mutex_};
+			m_sleepingWorkers_.fetch_add(1);
+			m_taskQueued_.wait(lock, [this] { return m_stopping_ || m_queuedTasks_.load() > 0; });
+			m_sleepingWorkers_.fetch_sub(1);
+			if (m_stopping_ && m_queuedTasks_.load() == 0) {
+				return;
+			}
+		}
+	}
+
+	LveJobSystem::Task *LveJobSystem::findTask(uint32_t index) {
+		Task *task = index == noDeque ? nullptr : m_deques_[index]->pop();
+
+		// Victims are tried from a random start, so thieves spread over the busy workers
+		const auto dequeCount = static_cast<uint32_t>(m_deques_.size());
+		const uint32_t start = nextRandom() % dequeCount;
+		for (uint32_t i = 0; !task && i < dequeCount; i++) {
+			const uint32_t victim = (start + i) % dequeCount;
+			if (victim != index) {
+				task = m_deques_[victim]->steal();
+			}
+		}
+
+		if (!task) {
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			if (!m_sharedTasks_.empty()) {
+				task = m_sharedTasks_.front();
+				m_sharedTasks_.pop_front();
+			}
+		}
+
+		if (task) {
+			m_queuedTasks_.fetch_sub(1);
+		}
+		return task;
+	}
+
+	void LveJobSystem::execute(Task *task) {
+		// A job that throws still has to finish, or waiting on its counter would never return
+		try {
+			task->m_job();
+		} catch (...) {
+			if (task->m_counter) {
+				recordException(*task->m_counter, std::current_exception());
+			} else {
+				std::cerr << "Unhandled exception in a job without a counter" << std::endl;
+			}
+		}
+		if (task->m_counter) {
+			task->m_counter->m_pending.fetch_sub(1, std::memory_order_release);
+		}
+		delete task;
+	}
+
+	void LveJobSystem::recordException(LveJobCounter &counter, std::exception_ptr exception) {
+		std::lock_guard<std::mutex> lock{counter.m_exceptionMutex_};
+		if (!counter.m_exception_) {
+			counter.m_exception_ = std::move(exception);
+		}
+	}
+
+	uint32_t LveJobSystem::currentIndex() const {
+		if (workerSystem == this) {
+			return workerIndex;
+		}
+		return std::this_thread::get_id() == m_ownerThread_ ? 0 : noDeque;
+	}
+
+	LveJobGraph::Stage LveJobGraph::addStage(const char *name,
+	                                         LveJobSystem::Job job,
+	                                         const std::vector<Stage> &dependencies,
+	                                         bool onCallingThread) {
+		const auto stage = static_cast<Stage>(m_stages_.size());
+		for (auto dependency: dependencies) {
+			if (dependency >= stage) {
+				throw std::runtime_error(std::string("Stage ") + name + " depends on a stage added after it");
+			}
+			m_stages_[dependency].m_successors.push_back(stage);
+		}
+
+		auto &info = m_stages_.emplace_back();
+		info.m_name = name;
+		info.m_job = std::move(job);
+		info.m_onCallingThread = onCallingThread;
+		info.m_dependencyCount = static_cast<uint32_t>(dependencies.size());
+		return stage;
+	}
+
+	void LveJobGraph::run(LveJobSystem &jobSystem) {
+		m_counter_.m_pending.store(static_cast<uint32_t>(m_stages_.size()), std::memory_order_relaxed);
+		for (auto &stage: m_stages_) {
+			stage.m_remaining.store(stage.m_dependencyCount, std::memory_order_relaxed);
+		}
+		for (Stage stage = 0; stage < m_stages_.size(); stage++) {
+			if (m_stages_[stage].m_dependencyCount == 0) {
+				schedule(jobSystem, stage);
+			}
+		}
+
+		while (!m_counter_.isDone()) {
+			Stage ready = 0;
+			bool found = false;
+			{
+				std::lock_guard<std::mutex> lock{m_mutex_};
+				if (!m_readyOnCallingThread_.empty()) {
+					ready = m_readyOnCallingThread_.back();
+					m_readyOnCallingThread_.pop_back();
+					found = true;
+				}
+			}
+
+			if (found) {
+				runStage(jobSystem, ready);
+			} else if (!jobSystem.tryRunJob()) {
+				std::this_thread::yield();
+			}
+		}
+
+		std::exception_ptr exception = std::exchange(m_exception_, nullptr);
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void LveJobGraph::schedule(LveJobSystem &jobSystem, Stage stage) {
+		if (m_stages_[stage].m_onCallingThread) {
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_readyOnCallingThread_.push_back(stage);
+			return;
+		}
+		jobSystem.run([this, &jobSystem, stage]() { runStage(jobSystem, stage); });
+	}
+
+	void LveJobGraph::runStage(LveJobSystem &jobSystem, Stage stage) {
+		bool failed;
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			failed = m_exception_ != nullptr;
+		}
+		// Skipped stages still complete, so run() returns
+		if (!failed) {
+			try {
+				m_stages_[stage].m_job();
+			} catch (...) {
+				std::lock_guard<std::mutex> lock{m_mutex_};
+				if (!m_exception_) {
+					m_exception_ = std::current_exception();
+				}
+			}
+		}
+		complete(jobSystem, stage);
+	}
+
+	void LveJobGraph::complete(LveJobSystem &jobSystem, Stage stage) {
+		for (auto successor: m_stages_[stage].m_successors) {
+			if (m_stages_[successor].m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				schedule(jobSystem, successor);
+			}
+		}
+		m_counter_.m_pending.fetch_sub(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,176 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEJOBSYSTEM_HPP
+#define VULKAN_TEST_LVEJOBSYSTEM_HPP
+
+// std
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	// Counts the unfinished jobs of a group; LveJobSystem::wait() returns once it is back at zero
+	class LveJobCounter {
+	public:
+		bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+		std::atomic<uint32_t> m_pending{0};
+
+	private:
+		friend class LveJobSystem;
+
+		// The first exception thrown by a job of the group, rethrown by LveJobSystem::wait()
+		std::mutex m_exceptionMutex_;
+		std::exception_ptr m_exception_;
+	};
+
+	// Runs jobs on worker threads that each own a Chase-Lev deque: the owner pushes and pops at the bottom,
+	// idle workers steal from the top of a random other deque. The thread constructing the system owns a
+	// deque as well, other threads hand their jobs to a shared queue.
+	//
+	// There are no fibers; a thread waiting on a counter runs other jobs until the counter is done, so a
+	// job may wait on jobs it scheduled itself.
+	class LveJobSystem {
+	public:
+		using Job = std::function<void()>;
+		// Processes the items [begin, end)
+		using RangeJob = std::function<void(uint32_t begin, uint32_t end)>;
+
+		explicit LveJobSystem(uint32_t workerCount = std::thread::hardware_concurrency() - 1);
+
+		// Finishes the queued jobs first
+		~LveJobSystem();
+
+		LveJobSystem(const LveJobSystem &) = delete;
+
+		LveJobSystem &operator=(const LveJobSystem &) = delete;
+
+		// counter, when given, stays above zero until job has returned or thrown. Exceptions of jobs without a
+		// counter have nobody to go to and are only logged.
+		void run(Job job, LveJobCounter *counter = nullptr);
+
+		// Rethrows the first exception one of the jobs threw, once all of them have finished
+		void wait(LveJobCounter &counter);
+
+		// Splits [0, count) into ranges of grainSize items and blocks until all of them have been processed;
+		// rethrows like wait()
+		void parallelFor(uint32_t count, uint32_t grainSize, const RangeJob &job);
+
+		// Runs one queued job on the calling thread; returns false when none could be found
+		bool tryRunJob();
+
+		// Workers plus the owning thread
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers_.size()) + 1; }
+
+	private:
+		struct Task {
+			Job m_job;
+			LveJobCounter *m_counter;
+		};
+
+		// Fixed capacity; push() fails when full and the caller runs the task itself
+		class Deque {
+		public:
+			static constexpr int64_t m_capacity = 4096;
+
+			bool push(Task *task);
+
+			// Owner only
+			Task *pop();
+
+			// Any thread
+			Task *steal();
+
+		private:
+			std::atomic<int64_t> m_top_{0};
+			std::atomic<int64_t> m_bottom_{0};
+			std::array<std::atomic<Task *>, m_capacity> m_tasks_{};
+		};
+
+		void work(uint32_t index);
+
+		Task *findTask(uint32_t index);
+
+		void execute(Task *task);
+
+		static void recordException(LveJobCounter &counter, std::exception_ptr exception);
+
+		// Deque of the calling thread, ~0u for threads outside the system
+		uint32_t currentIndex() const;
+
+		// Index 0 belongs to the owning thread, worker i uses index i + 1
+		std::vector<std::unique_ptr<Deque>> m_deques_;
+		std::thread::id m_ownerThread_;
+		std::vector<std::thread> m_workers_;
+		// Tasks in any deque or the shared queue, lets idle workers sleep
+		std::atomic<uint32_t> m_queuedTasks_{0};
+
+		std::mutex m_mutex_;
+		std::condition_variable m_taskQueued_;
+		// Tasks from threads that own no deque
+		std::deque<Task *> m_sharedTasks_;
+		std::atomic<uint32_t> m_sleepingWorkers_{0};
+		bool m_stopping_ = false;
+	};
+
+	// Stages of a frame and the stages each of them waits for; stages without a path between them may
+	// overlap. Built once and run every frame.
+	class LveJobGraph {
+	public:
+		using Stage = uint32_t;
+
+		LveJobGraph() = default;
+
+		LveJobGraph(const LveJobGraph &) = delete;
+
+		LveJobGraph &operator=(const LveJobGraph &) = delete;
+
+		// Stages on the calling thread run on the thread calling run(), for work such as polling input
+		// that is tied to the main thread. Dependencies must have been added before.
+		Stage addStage(const char *name,
+		               LveJobSystem::Job job,
+		               const std::vector<Stage> &dependencies = {},
+		               bool onCallingThread = false);
+
+		// Blocks until every stage has run; the calling thread runs jobs while it waits. Once a stage has
+		// thrown, the stages not yet started are skipped and the exception is rethrown.
+		void run(LveJobSystem &jobSystem);
+
+	private:
+		struct StageInfo {
+			const char *m_name = nullptr;
+			LveJobSystem::Job m_job;
+			bool m_onCallingThread = false;
+			uint32_t m_dependencyCount = 0;
+			std::vector<Stage> m_successors;
+			std::atomic<uint32_t> m_remaining{0};
+		};
+
+		void schedule(LveJobSystem &jobSystem, Stage stage);
+
+		void runStage(LveJobSystem &jobSystem, Stage stage);
+
+		void complete(LveJobSystem &jobSystem, Stage stage);
+
+		std::deque<StageInfo> m_stages_;
+		LveJobCounter m_counter_;
+
+		// Stages for the calling thread whose dependencies have completed
+		std::mutex m_mutex_;
+		std::vector<Stage> m_readyOnCallingThread_;
+		std::exception_ptr m_exception_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEJOBSYSTEM_HPP
@@ -0,0 +1,291 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveMeshlet.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t unassignedIndex = std::numeric_limits<uint32_t>::max();
+		constexpr uint32_t initialArenaCapacity = 1 << 16;
+		// Models culled per job
+		constexpr uint32_t cullGrainSize = 8;
+
+		void computeBounds(const LveMeshletData &data, LveMeshlet &meshlet, const std::vector<glm::vec3> &positions) {
+			const uint32_t *vertices = data.m_vertices.data() + meshlet.m_vertexOffset;
+			const uint8_t *triangles = data.m_triangles.data() + meshlet.m_triangleOffset;
+
+			glm::vec3 minPosition{std::numeric_limits<float>::max()};
+			glm::vec3 maxPosition{std::numeric_limits<float>::lowest()};
+			for (uint32_t i = 0; i < meshlet.m_vertexCount; i++) {
+				minPosition = glm::min(minPosition, positions[vertices[i]]);
+				maxPosition = glm::max(maxPosition, positions[vertices[i]]);
+			}
+			meshlet.m_center = (minPosition + maxPosition) * .5f;
+			meshlet.m_radius = 0.f;
+			for (uint32_t i = 0; i < meshlet.m_vertexCount; i++) {
+				meshlet.m_radius = std::max(meshlet.m_radius, glm::length(positions[vertices[i]] - meshlet.m_center));
+			}
+
+			// Front faces are clockwise in framebuffer space (see LvePipeline::defaultPipelineConfigInfo),
+			// which makes (p2 - p0) x (p1 - p0) the outward facing normal.
+			std::vector<glm::vec3> normals;
+			normals.reserve(meshlet.m_triangleCount);
+			glm::vec3 axis{0.f};
+			for (uint32_t t = 0; t < meshlet.m_triangleCount; t++) {
+				const glm::vec3 &p0 = positions[vertices[triangles[t * 3 + 0]]];
+				const glm::vec3 &p1 = positions[vertices[triangles[t * 3 + 1]]];
+				const glm::vec3 &p2 = positions[vertices[triangles[t * 3 + 2]]];
+				glm::vec3 normal = glm::cross(p2 - p0, p1 - p0);
+				float area = glm::length(normal);
+				if (area <= std::numeric_limits<float>::epsilon()) {
+					continue;
+				}
+				normal /= area;
+				normals.push_back(normal);
+				axis += normal;
+			}
+
+			meshlet.m_coneAxis = glm::vec3{0.f};
+			meshlet.m_coneCutoff = 1.f;
+
+			float axisLength = glm::length(axis);
+			if (normals.empty() || axisLength <= std::numeric_limits<float>::epsilon()) {
+				return;
+			}
+			axis /= axisLength;
+
+			float minDot = 1.f;
+			for (const auto &normal: normals) {
+				minDot = std::min(minDot, glm::dot(axis, normal));
+			}
+
+			meshlet.m_coneAxis = axis;
+			// Cones close to a half-sphere are practically never culled, so leave those disabled.
+			if (minDot > .1f) {
+				meshlet.m_coneCutoff = std::sqrt(1.f - minDot * minDot);
+			}
+		}
+	}
+
+	LveMeshletData LveMeshletData::build(const std::vector<glm::vec3> &positions,
+	                                     const std::vector<uint32_t> &indices,
+	                                     uint32_t maxVertices,
+	                                     uint32_t maxTriangles) {
+#ifndef NDEBUG
+		assert(maxVertices >= 3 && maxVertices <= 256 && "Meshlet-local vertex indices are stored as bytes");
+		assert(maxTriangles >= 1 && "Meshlets need room for at least one triangle");
+		assert(indices.size() % 3 == 0 && "Meshlets can only be built from triangle lists");
+#endif
+		LveMeshletData data{};
+		std::vector<uint32_t> localIndex(positions.size(), unassignedIndex);
+
+		LveMeshlet current{};
+		auto finishMeshlet = [&]() {
+			if (current.m_triangleCount == 0) {
+				return;
+			}
+			computeBounds(data, current, positions);
+			for (uint32_t i = 0; i < current.m_vertexCount; i++) {
+				localIndex[data.m_vertices[current.m_vertexOffset + i]] = unassignedIndex;
+			}
+			data.m_meshlets.push_back(current);
+
+			current = {};
+			current.m_vertexOffset = static_cast<uint32_t>(data.m_vertices.size());
+			current.m_triangleOffset = static_cast<uint32_t>(data.m_triangles.size());
+		};
+
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			const uint32_t triangle[3] = {indices[i], indices[i + 1], indices[i + 2]};
+
+			uint32_t newVertices = 0;
+			for (uint32_t v: triangle) {
+				newVertices += localIndex[v] == unassignedIndex ? 1 : 0;
+			}
+			if (current.m_vertexCount + newVertices > maxVertices || current.m_triangleCount + 1 > maxTriangles) {
+				finishMeshlet();
+			}
+
+			for (uint32_t v: triangle) {
+				if (localIndex[v] == unassignedIndex) {
+					localIndex[v] = current.m_vertexCount++;
+					data.m_vertices.push_back(v);
+				}
+				data.m_triangles.push_back(static_cast<uint8_t>(localIndex[v]));
+			}
+			current.m_triangleCount++;
+		}
+		finishMeshlet();
+
+		return data;
+	}
+
+	LveMeshletCuller::LveMeshletCuller(LveDevice &device) : m_lveDevice_{device} {
+		m_arenas_.resize(LveSwapChain::m_maxFramesInFlight);
+		for (auto &arena: m_arenas_) {
+			createArena(arena, initialArenaCapacity);
+		}
+	}
+
+	LveMeshletCuller::~LveMeshletCuller() {
+		for (auto &arena: m_arenas_) {
+			destroyArena(arena);
+		}
+	}
+
+	void LveMeshletCuller::createArena(IndexArena &arena, uint32_t capacity) {
+		VkDeviceSize bufferSize = sizeof(uint32_t) * capacity;
+		m_lveDevice_.createBuffer(
+				bufferSize,
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				arena.m_buffer,
+				arena.m_memory
+		);
+
+		void *data;
+		vkMapMemory(m_lveDevice_.device(), arena.m_memory, 0, bufferSize, 0, &data);
+		arena.m_mapped = static_cast<uint32_t *>(data);
+		arena.m_capacity = capacity;
+	}
+
+	void LveMeshletCuller::destroyArena(IndexArena &arena) {
+		if (arena.m_buffer == VK_NULL_HANDLE) {
+			return;
+		}
+		vkUnmapMemory(m_lveDevice_.device(), arena.m_memory);
+		vkDestroyBuffer(m_lveDevice_.device(), arena.m_buffer, nullptr);
+		vkFreeMemory(m_lveDevice_.device(), arena.m_memory, nullptr);
+		arena = {};
+	}
+
+	void LveMeshletCuller::beginFrame(int frameIndex) {
+		auto &arena = m_arenas_[frameIndex];
+
+		// The in-flight fence of this frame index was waited on by LveSwapChain::acquireNextImage, so the
+		// previous contents of the buffer are no longer read by the GPU and it can be replaced.
+		if (arena.m_required > arena.m_capacity) {
+			uint32_t capacity = arena.m_capacity;
+			while (capacity < arena.m_required) {
+				capacity *= 2;
+			}
+			destroyArena(arena);
+			createArena(arena, capacity);
+		}
+
+		arena.m_cursor = 0;
+		arena.m_required = 0;
+		m_currentArena_ = &arena;
+		m_visibleMeshlets_ = 0;
+		m_totalMeshlets_ = 0;
+	}
+
+	void LveMeshletCuller::cull(const std::vector<MeshletCullRequest> &requests,
+	                            const LveFrustum &frustum,
+	                            const glm::vec3 &cameraPosition,
+	                            std::vector<std::optional<MeshletDrawRange>> &ranges,
+	                            LveJobSystem *jobSystem) {
+#ifndef NDEBUG
+		assert(m_currentArena_ != nullptr && "Cannot cull meshlets before beginFrame");
+#endif
+		auto &arena = *m_currentArena_;
+		const auto requestCount = static_cast<uint32_t>(requests.size());
+		if (m_results_.size() < requestCount) {
+			m_results_.resize(requestCount);
+		}
+		ranges.assign(requestCount, std::nullopt);
+
+		auto forEachRequest = [&](auto &&body) {
+			auto processRange = [&](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; i++) {
+					body(i);
+				}
+			};
+			if (jobSystem) {
+				jobSystem->parallelFor(requestCount, cullGrainSize, processRange);
+			} else {
+				processRange(0, requestCount);
+			}
+		};
+
+		// The meshlets of all requests are tested first, so the index ranges can be handed out in order
+		forEachRequest([&](uint32_t i) {
+			const auto &modelMatrix = requests[i].m_modelMatrix;
+			auto &result = m_results_[i];
+			result.m_visibleMeshlets.clear();
+			result.m_indexCount = 0;
+
+			const float scale = std::max({
+					glm::length(glm::vec3{modelMatrix[0]}),
+					glm::length(glm::vec3{modelMatrix[1]}),
+					glm::length(glm::vec3{modelMatrix[2]})});
+			// Back-facing is invariant under the model transform, so the cone test runs in model space.
+			const glm::vec3 cameraInModel{glm::inverse(modelMatrix) * glm::vec4{cameraPosition, 1.f}};
+
+			const auto &meshlets = requests[i].m_meshlets->m_meshlets;
+			for (uint32_t m = 0; m < meshlets.size(); m++) {
+				const auto &meshlet = meshlets[m];
+				const glm::vec3 center{modelMatrix * glm::vec4{meshlet.m_center, 1.f}};
+				if (!frustum.intersectsSphere(center, meshlet.m_radius * scale)) {
+					continue;
+				}
+
+				if (m_coneCulling) {
+					const glm::vec3 view = meshlet.m_center - cameraInModel;
+					if (glm::dot(view, meshlet.m_coneAxis) >=
+					    meshlet.m_coneCutoff * glm::length(view) + meshlet.m_radius) {
+						continue;
+					}
+				}
+
+				result.m_visibleMeshlets.push_back(m);
+				result.m_indexCount += meshlet.m_triangleCount * 3;
+			}
+		});
+
+		for (uint32_t i = 0; i < requestCount; i++) {
+			const auto &result = m_results_[i];
+			m_totalMeshlets_ += static_cast<uint32_t>(requests[i].m_meshlets->m_meshlets.size());
+			m_visibleMeshlets_ += static_cast<uint32_t>(result.m_visibleMeshlets.size());
+			arena.m_required += result.m_indexCount;
+			if (arena.m_cursor + result.m_indexCount <= arena.m_capacity) {
+				ranges[i] = MeshletDrawRange{arena.m_cursor, result.m_indexCount};
+				arena.m_cursor += result.m_indexCount;
+			}
+		}
+
+		forEachRequest([&](uint32_t i) {
+			if (!ranges[i]) {
+				return;
+			}
+			const auto &data = *requests[i].m_meshlets;
+			uint32_t *dst = arena.m_mapped + ranges[i]->m_firstIndex;
+			for (uint32_t m: m_results_[i].m_visibleMeshlets) {
+				const auto &meshlet = data.m_meshlets[m];
+				const uint32_t *vertices = data.m_vertices.data() + meshlet.m_vertexOffset;
+				const uint8_t *triangles = data.m_triangles.data() + meshlet.m_triangleOffset;
+				const uint32_t indexCount = meshlet.m_triangleCount * 3;
+				for (uint32_t index = 0; index < indexCount; index++) {
+					dst[index] = vertices[triangles[index]];
+				}
+				dst += indexCount;
+			}
+		});
+	}
+
+	void LveMeshletCuller::draw(VkCommandBuffer commandBuffer,
+	                            const MeshletDrawRange &range,
+	                            uint32_t firstInstance) const {
+		vkCmdBindIndexBuffer(commandBuffer, m_currentArena_->m_buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexed(commandBuffer, range.m_indexCount, 1, range.m_firstIndex, 0, firstInstance);
+	}
+}
@@ -0,0 +1,129 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEMESHLET_HPP
+#define VULKAN_TEST_LVEMESHLET_HPP
+
+#include "LveDevice.hpp"
+#include "LveFrustum.hpp"
+#include "LveJobSystem.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <glm/glm.hpp>
+
+// std
+#include <optional>
+#include <vector>
+
+namespace lve {
+
+	// A small cluster of triangles with bounds used for culling. Triangles are stored as meshlet-local
+	// vertex indices, which are remapped to model vertices through LveMeshletData::m_vertices.
+	struct LveMeshlet {
+		uint32_t m_vertexOffset;
+		uint32_t m_triangleOffset;
+		uint32_t m_vertexCount;
+		uint32_t m_triangleCount;
+
+		glm::vec3 m_center;
+		float m_radius;
+
+		// Normal cone: the meshlet faces away from the camera when the view direction lies inside it.
+		// A cutoff of 1 disables cone culling for this meshlet.
+		glm::vec3 m_coneAxis;
+		float m_coneCutoff;
+	};
+
+	struct LveMeshletData {
+		static constexpr uint32_t m_defaultMaxVertices = 64;
+		static constexpr uint32_t m_defaultMaxTriangles = 124;
+
+		std::vector<LveMeshlet> m_meshlets;
+		std::vector<uint32_t> m_vertices;
+		std::vector<uint8_t> m_triangles;
+
+		// Greedily partitions an indexed triangle list in submission order.
+		static LveMeshletData build(const std::vector<glm::vec3> &positions,
+		                            const std::vector<uint32_t> &indices,
+		                            uint32_t maxVertices = m_defaultMaxVertices,
+		                            uint32_t maxTriangles = m_defaultMaxTriangles);
+
+		uint32_t triangleCount() const { return static_cast<uint32_t>(m_triangles.size() / 3); }
+	};
+
+	struct MeshletDrawRange {
+		uint32_t m_firstIndex;
+		uint32_t m_indexCount;
+	};
+
+	// One model instance whose meshlets are to be culled
+	struct MeshletCullRequest {
+		const LveMeshletData *m_meshlets;
+		glm::mat4 m_modelMatrix;
+	};
+
+	// Culls meshlets on the CPU and writes the surviving triangles into a persistently mapped index
+	// buffer, one per frame in flight, so the GPU only processes visible clusters.
+	class LveMeshletCuller {
+	public:
+		explicit LveMeshletCuller(LveDevice &device);
+
+		~LveMeshletCuller();
+
+		LveMeshletCuller(const LveMeshletCuller &) = delete;
+
+		LveMeshletCuller &operator=(const LveMeshletCuller &) = delete;
+
+		void beginFrame(int frameIndex);
+
+		// Culls every request, spread over jobSystem when one is given, and lays out the surviving triangles in
+		// request order. ranges[i] is std::nullopt when this frame's index buffer is full; the caller should
+		// then draw requests[i] without culling. The buffer is grown the next time this frame index comes
+		// around.
+		void cull(const std::vector<MeshletCullRequest> &requests,
+		          const LveFrustum &frustum,
+		          const glm::vec3 &cameraPosition,
+		          std::vector<std::optional<MeshletDrawRange>> &ranges,
+		          LveJobSystem *jobSystem = nullptr);
+
+		void draw(VkCommandBuffer commandBuffer, const MeshletDrawRange &range, uint32_t firstInstance = 0) const;
+
+		uint32_t visibleMeshletCount() const { return m_visibleMeshlets_; }
+
+		uint32_t totalMeshletCount() const { return m_totalMeshlets_; }
+
+		bool m_coneCulling{false};
+
+	private:
+		struct IndexArena {
+			VkBuffer m_buffer = VK_NULL_HANDLE;
+			VkDeviceMemory m_memory = VK_NULL_HANDLE;
+			uint32_t *m_mapped = nullptr;
+			uint32_t m_capacity = 0;
+			uint32_t m_cursor = 0;
+			uint32_t m_required = 0;
+		};
+
+		// Meshlets of one request that passed culling
+		struct CullResult {
+			std::vector<uint32_t> m_visibleMeshlets;
+			uint32_t m_indexCount = 0;
+		};
+
+		void createArena(IndexArena &arena, uint32_t capacity);
+
+		void destroyArena(IndexArena &arena);
+
+		LveDevice &m_lveDevice_;
+		std::vector<IndexArena> m_arenas_;
+		IndexArena *m_currentArena_ = nullptr;
+		uint32_t m_visibleMeshlets_ = 0;
+		uint32_t m_totalMeshlets_ = 0;
+		std::vector<CullResult> m_results_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEMESHLET_HPP
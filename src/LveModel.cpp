@@ -11,6 +11,7 @@
 
 #endif
 
+#include <algorithm>
 #include <cstring>
 
 namespace lve {
@@ -19,9 +20,22 @@ namespace lve {
 	    createVertexBuffers(vertices);
     }
 
+	LveModel::LveModel(LveDevice &device, const Builder &builder) : m_lveDevice_{device} {
+		createVertexBuffers(builder.m_vertices);
+		createIndexBuffers(builder.m_indices);
+		if (builder.m_buildMeshlets) {
+			createMeshlets(builder);
+		}
+	}
+
     LveModel::~LveModel() {
 	    vkDestroyBuffer(m_lveDevice_.device(), m_vertexBuffer_, nullptr);
 	    vkFreeMemory(m_lveDevice_.device(), m_vertexBufferMemory_, nullptr);
+
+	    if (m_hasIndexBuffer_) {
+		    vkDestroyBuffer(m_lveDevice_.device(), m_indexBuffer_, nullptr);
+		    vkFreeMemory(m_lveDevice_.device(), m_indexBufferMemory_, nullptr);
+	    }
     }
 
     void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices) {
@@ -29,6 +43,8 @@ namespace lve {
 #ifndef NDEBUG
 	    assert(m_vertexCount_ >= 3 && "Vertex count must be at least 3");
 #endif
+	    computeBoundingSphere(vertices);
+
 	    VkDeviceSize bufferSize = sizeof(vertices[0]) * m_vertexCount_;
 	    m_lveDevice_.createBuffer(
 			    bufferSize,
@@ -44,14 +60,84 @@ namespace lve {
 	    vkUnmapMemory(m_lveDevice_.device(), m_vertexBufferMemory_);
     }
 
+	void LveModel::computeBoundingSphere(const std::vector<Vertex> &vertices) {
+		glm::vec3 minPosition{vertices[0].m_position};
+		glm::vec3 maxPosition{vertices[0].m_position};
+		for (const auto &vertex: vertices) {
+			minPosition = glm::min(minPosition, vertex.m_position);
+			maxPosition = glm::max(maxPosition, vertex.m_position);
+		}
+
+		glm::vec3 center = (minPosition + maxPosition) * .5f;
+		float radius = 0.f;
+		for (const auto &vertex: vertices) {
+			radius = std::max(radius, glm::length(vertex.m_position - center));
+		}
+		m_boundingSphere_ = glm::vec4{center, radius};
+	}
+
+	void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
+		m_indexCount_ = static_cast<uint32_t>(indices.size());
+		m_hasIndexBuffer_ = m_indexCount_ > 0;
+		if (!m_hasIndexBuffer_) {
+			return;
+		}
+
+		VkDeviceSize bufferSize = sizeof(indices[0]) * m_indexCount_;
+		m_lveDevice_.createBuffer(
+				bufferSize,
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				m_indexBuffer_,
+				m_indexBufferMemory_
+		);
+
+		void *data;
+		vkMapMemory(m_lveDevice_.device(), m_indexBufferMemory_, 0, bufferSize, 0, &data);
+		memcpy(data, indices.data(), static_cast<size_t>(bufferSize));
+		vkUnmapMemory(m_lveDevice_.device(), m_indexBufferMemory_);
+	}
+
+	void LveModel::createMeshlets(const Builder &builder) {
+		std::vector<glm::vec3> positions;
+		positions.reserve(builder.m_vertices.size());
+		for (const auto &vertex: builder.m_vertices) {
+			positions.push_back(vertex.m_position);
+		}
+
+		// Non-indexed models are treated as an implicit 0..n-1 triangle list.
+		std::vector<uint32_t> indices = builder.m_indices;
+		if (indices.empty()) {
+			indices.resize(builder.m_vertices.size());
+			for (uint32_t i = 0; i < indices.size(); i++) {
+				indices[i] = i;
+			}
+		}
+
+		m_meshletData_ = LveMeshletData::build(
+				positions,
+				indices,
+				builder.m_maxMeshletVertices,
+				builder.m_maxMeshletTriangles
+		);
+	}
+
 	void LveModel::bind(VkCommandBuffer commandBuffer) {
 		VkBuffer buffers[] = {m_vertexBuffer_};
 		VkDeviceSize offsets[] = {0};
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+		if (m_hasIndexBuffer_) {
+			vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer_, 0, VK_INDEX_TYPE_UINT32);
+		}
 	}
 
-	void LveModel::draw(VkCommandBuffer commandBuffer) const {
-		vkCmdDraw(commandBuffer, m_vertexCount_, 1, 0, 0);
+	void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t firstInstance) const {
+		if (m_hasIndexBuffer_) {
+			vkCmdDrawIndexed(commandBuffer, m_indexCount_, 1, 0, 0, firstInstance);
+		} else {
+			vkCmdDraw(commandBuffer, m_vertexCount_, 1, 0, firstInstance);
+		}
 	}
 
 
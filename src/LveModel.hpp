@@ -6,6 +6,7 @@
 #define VULKAN_TEST_LVEMODEL_HPP
 
 #include "LveDevice.hpp"
+#include "LveMeshlet.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -26,8 +27,20 @@ namespace lve {
 	        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
         };
 
+	    struct Builder {
+		    std::vector<Vertex> m_vertices{};
+		    std::vector<uint32_t> m_indices{};
+
+		    // Partition the geometry into meshlets for cluster-level culling, see LveMeshletCuller
+		    bool m_buildMeshlets = false;
+		    uint32_t m_maxMeshletVertices = LveMeshletData::m_defaultMaxVertices;
+		    uint32_t m_maxMeshletTriangles = LveMeshletData::m_defaultMaxTriangles;
+	    };
+
         LveModel(LveDevice &device, const std::vector<Vertex> &vertices);
 
+	    LveModel(LveDevice &device, const Builder &builder);
+
         ~LveModel();
 
         LveModel(const LveModel &) = delete;
@@ -36,15 +49,40 @@ namespace lve {
 
 	    void bind(VkCommandBuffer commandBuffer);
 
-	    void draw(VkCommandBuffer commandBuffer) const;
+	    void draw(VkCommandBuffer commandBuffer, uint32_t firstInstance = 0) const;
+
+	    bool hasIndexBuffer() const { return m_hasIndexBuffer_; }
+
+	    uint32_t getIndexCount() const { return m_indexCount_; }
+
+	    // xyz = center, w = radius, in model space
+	    const glm::vec4 &getBoundingSphere() const { return m_boundingSphere_; }
+
+	    bool hasMeshlets() const { return !m_meshletData_.m_meshlets.empty(); }
+
+	    const LveMeshletData &getMeshletData() const { return m_meshletData_; }
 
     private:
 	    void createVertexBuffers(const std::vector<Vertex> &vertices);
 
+	    void computeBoundingSphere(const std::vector<Vertex> &vertices);
+
+	    void createIndexBuffers(const std::vector<uint32_t> &indices);
+
+	    void createMeshlets(const Builder &builder);
+
 	    LveDevice &m_lveDevice_;
 	    VkBuffer m_vertexBuffer_;
 	    VkDeviceMemory m_vertexBufferMemory_;
 	    uint32_t m_vertexCount_;
+	    glm::vec4 m_boundingSphere_{0.f};
+
+	    bool m_hasIndexBuffer_ = false;
+	    VkBuffer m_indexBuffer_ = VK_NULL_HANDLE;
+	    VkDeviceMemory m_indexBufferMemory_ = VK_NULL_HANDLE;
+	    uint32_t m_indexCount_ = 0;
+
+	    LveMeshletData m_meshletData_{};
 
     };
 }
@@ -5,6 +5,7 @@
 #include "LvePipeline.hpp"
 #include "LveModel.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
@@ -20,8 +21,6 @@ namespace lve {
     }
 
 	LvePipeline::~LvePipeline() {
-		vkDestroyShaderModule(m_lveDevice_.device(), m_vertShaderModule_, nullptr);
-		vkDestroyShaderModule(m_lveDevice_.device(), m_fragShaderModule_, nullptr);
 		vkDestroyPipeline(m_lveDevice_.device(), m_graphicsPipeline_, nullptr);
 	}
 
@@ -50,34 +49,44 @@ namespace lve {
 				configInfo.m_pipelineLayout != VK_NULL_HANDLE &&
 				"Cannot create graphics pipeline: no m_pipelineLayout_ provided in config_info");
 		assert(
-				configInfo.m_renderPass != VK_NULL_HANDLE &&
-				"Cannot create graphics pipeline: no renderPass provided in config_info");
+				(configInfo.m_renderPass != VK_NULL_HANDLE || !configInfo.m_colorAttachmentFormats.empty() ||
+				 configInfo.m_depthAttachmentFormat != VK_FORMAT_UNDEFINED) &&
+				"Cannot create graphics pipeline: no renderPass or attachment formats provided in config_info");
 #endif
 
-		auto vertCode = readFile(vertFilePath);
-		auto fragCode = readFile(fragFilePath);
-		createShaderModule(vertCode, &m_vertShaderModule_);
-		createShaderModule(fragCode, &m_fragShaderModule_);
+		auto vertCode = LveShaderCode::load(vertFilePath);
+		auto fragCode = LveShaderCode::load(fragFilePath);
+		// Only borrowed for the creation, the pipeline no longer needs them afterwards
+		LveShaderStageModule vertModule{m_lveDevice_.shaderModuleCache(), vertCode};
+		LveShaderStageModule fragModule{m_lveDevice_.shaderModuleCache(), fragCode};
+
+		std::vector<VkSpecializationMapEntry> vertMapEntries;
+		std::vector<VkSpecializationMapEntry> fragMapEntries;
+		VkSpecializationInfo vertSpecialization = configInfo.m_vertSpecialization.getInfo(vertMapEntries);
+		VkSpecializationInfo fragSpecialization = configInfo.m_fragSpecialization.getInfo(fragMapEntries);
 
 		VkPipelineShaderStageCreateInfo shaderStages[2];
 		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-		shaderStages[0].module = m_vertShaderModule_;
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		vertModule.fill(shaderStages[0]);
+		shaderStages[0].pSpecializationInfo =
+				configInfo.m_vertSpecialization.empty() ? nullptr : &vertSpecialization;
 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		shaderStages[1].module = m_fragShaderModule_;
 		shaderStages[1].pName = "main";
 		shaderStages[1].flags = 0;
 		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		fragModule.fill(shaderStages[1]);
+		shaderStages[1].pSpecializationInfo =
+				configInfo.m_fragSpecialization.empty() ? nullptr : &fragSpecialization;
 
+		// Only declare the attributes the vertex shader consumes, and fail early on inputs the vertex lacks
 		auto bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
-		auto attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+		auto attributeDescriptions = getVertexAttributes(reflectShader(vertCode));
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -106,7 +115,18 @@ namespace lve {
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(m_lveDevice_.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+		VkPipelineRenderingCreateInfo renderingInfo{};
+		if (configInfo.m_renderPass == VK_NULL_HANDLE) {
+			renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+			renderingInfo.colorAttachmentCount = static_cast<uint32_t>(configInfo.m_colorAttachmentFormats.size());
+			renderingInfo.pColorAttachmentFormats = configInfo.m_colorAttachmentFormats.data();
+			renderingInfo.depthAttachmentFormat = configInfo.m_depthAttachmentFormat;
+			renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+			pipelineInfo.pNext = &renderingInfo;
+			pipelineInfo.subpass = 0;
+		}
+
+		if (vkCreateGraphicsPipelines(m_lveDevice_.device(), m_lveDevice_.pipelineCache(), 1, &pipelineInfo, nullptr,
 		                              &m_graphicsPipeline_) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to create graphics pipeline.");
 		}
@@ -114,16 +134,23 @@ namespace lve {
 	}
 
 
-	void LvePipeline::createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule) {
-		VkShaderModuleCreateInfo createInfo{};
-
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
-
-		if (vkCreateShaderModule(m_lveDevice_.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
-			throw std::runtime_error("Failed to create shader module");
+	std::vector<VkVertexInputAttributeDescription> LvePipeline::getVertexAttributes(
+			const ShaderReflection &vertReflection) {
+		auto available = LveModel::Vertex::getAttributeDescriptions();
+
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		for (const auto &input: vertReflection.m_inputs) {
+			auto attribute = std::find_if(available.begin(), available.end(),
+			                              [&](const VkVertexInputAttributeDescription &description) {
+				                              return description.location == input.m_location;
+			                              });
+			if (attribute == available.end()) {
+				throw std::runtime_error("Vertex shader input at location " + std::to_string(input.m_location) +
+				                         " is not provided by LveModel::Vertex");
+			}
+			attributes.push_back(*attribute);
 		}
+		return attributes;
 	}
 
     void LvePipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo) {
@@ -198,6 +225,27 @@ namespace lve {
 	    configInfo.m_dynamicStateInfo.flags = 0;
     }
 
+	void LvePipeline::enableAlphaBlending(PipelineConfigInfo &configInfo) {
+		configInfo.m_colorBlendAttachment.blendEnable = VK_TRUE;
+		configInfo.m_colorBlendAttachment.colorWriteMask =
+				VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+				VK_COLOR_COMPONENT_A_BIT;
+		configInfo.m_colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		configInfo.m_colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		configInfo.m_colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		configInfo.m_colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		configInfo.m_colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		configInfo.m_colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		configInfo.m_depthStencilInfo.depthWriteEnable = VK_FALSE;
+	}
+
+	void LvePipeline::setRenderTarget(PipelineConfigInfo &configInfo, const RenderTargetInfo &renderTarget) {
+		configInfo.m_renderPass = renderTarget.m_renderPass;
+		configInfo.m_colorAttachmentFormats = renderTarget.m_colorFormats;
+		configInfo.m_depthAttachmentFormat = renderTarget.m_depthFormat;
+	}
+
 	void LvePipeline::bind(VkCommandBuffer commandBuffer) {
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline_);
 	}
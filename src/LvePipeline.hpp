@@ -6,6 +6,8 @@
 #define VULKAN_TEST_LVEPIPELINE_HPP
 
 #include "LveDevice.hpp"
+#include "LveShaderReflection.hpp"
+#include "LveSpecializationConstants.hpp"
 
 #include <string>
 #include <vector>
@@ -29,9 +31,24 @@ struct PipelineConfigInfo {
 	VkPipelineLayout m_pipelineLayout = nullptr;
 	VkRenderPass m_renderPass = nullptr;
 	uint32_t m_subpass = 0;
+	// Without a render pass the pipeline is created for dynamic rendering into attachments of these formats
+	std::vector<VkFormat> m_colorAttachmentFormats;
+	VkFormat m_depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+	// Compile-time variants of the shaders, see LvePipelineVariants
+	lve::SpecializationConstants m_vertSpecialization;
+	lve::SpecializationConstants m_fragSpecialization;
 };
 
 namespace lve {
+
+	// What graphics pipelines render into. With dynamic rendering there is no render pass, pipelines are
+	// created against the attachment formats and stay valid as long as those do not change.
+	struct RenderTargetInfo {
+		VkRenderPass m_renderPass = VK_NULL_HANDLE;
+		std::vector<VkFormat> m_colorFormats;
+		VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
+	};
+
     class LvePipeline {
     public:
 	    LvePipeline(LveDevice &device,
@@ -49,19 +66,24 @@ namespace lve {
 
 	    static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
 
-    private:
+	    // Straight alpha blending; depth testing stays on but blended geometry no longer writes depth
+	    static void enableAlphaBlending(PipelineConfigInfo &configInfo);
+
+	    static void setRenderTarget(PipelineConfigInfo &configInfo, const RenderTargetInfo &renderTarget);
+
 	    static std::vector<char> readFile(const std::string &filePath);
 
+    private:
+
 	    void createGraphicsPipeline(const std::string &vertFilePath,
 	                                const std::string &fragFilePath,
 	                                const PipelineConfigInfo &configInfo);
 
-	    void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
+	    static std::vector<VkVertexInputAttributeDescription> getVertexAttributes(
+			    const ShaderReflection &vertReflection);
 
 	    LveDevice &m_lveDevice_;
 	    VkPipeline m_graphicsPipeline_;
-	    VkShaderModule m_vertShaderModule_;
-	    VkShaderModule m_fragShaderModule_;
     };
 
 }
@@ -0,0 +1,100 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LvePipelineCompiler.hpp"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+	LvePipelineCompiler::LvePipelineCompiler(LveDevice &device, uint32_t threadCount) : m_lveDevice_{device} {
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		}
+
+		m_workers_.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++) {
+			m_workers_.emplace_back(&LvePipelineCompiler::workerLoop, this);
+		}
+	}
+
+	LvePipelineCompiler::~LvePipelineCompiler() {
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_stopping_ = true;
+		}
+		m_jobAvailable_.notify_all();
+		for (auto &worker: m_workers_) {
+			worker.join();
+		}
+	}
+
+	LveAsyncPipeline<LvePipeline> LvePipelineCompiler::compile(std::string vertFilePath,
+	                                                           std::string fragFilePath,
+	                                                           std::function<void(PipelineConfigInfo &)> configure) {
+		return submit<LvePipeline>(
+				[this, vertFilePath = std::move(vertFilePath), fragFilePath = std::move(fragFilePath),
+						configure = std::move(configure)]() {
+					// The config points into itself, so it is built where it is used rather than copied over
+					PipelineConfigInfo configInfo{};
+					LvePipeline::defaultPipelineConfigInfo(configInfo);
+					configure(configInfo);
+					return std::make_unique<LvePipeline>(m_lveDevice_, vertFilePath, fragFilePath, configInfo);
+				});
+	}
+
+	LveAsyncPipeline<LveComputePipeline> LvePipelineCompiler::compileCompute(
+			std::string compFilePath, std::function<void(ComputePipelineConfigInfo &)> configure) {
+		return submit<LveComputePipeline>(
+				[this, compFilePath = std::move(compFilePath), configure = std::move(configure)]() {
+					ComputePipelineConfigInfo configInfo{};
+					configure(configInfo);
+					return std::make_unique<LveComputePipeline>(m_lveDevice_, compFilePath, configInfo);
+				});
+	}
+
+	template<typename Pipeline>
+	LveAsyncPipeline<Pipeline> LvePipelineCompiler::submit(std::function<std::unique_ptr<Pipeline>()> build) {
+		// std::function needs a copyable target, which packaged_task is not
+		auto task = std::make_shared<std::packaged_task<std::unique_ptr<Pipeline>()>>(std::move(build));
+		auto future = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_jobs_.emplace_back([task]() { (*task)(); });
+		}
+		m_jobAvailable_.notify_one();
+		return LveAsyncPipeline<Pipeline>{std::move(future)};
+	}
+
+	void LvePipelineCompiler::workerLoop() {
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock{m_mutex_};
+				m_jobAvailable_.wait(lock, [this]() { return m_stopping_ || !m_jobs_.empty(); });
+				if (m_jobs_.empty()) {
+					return;
+				}
+				job = std::move(m_jobs_.front());
+				m_jobs_.pop_front();
+				m_activeJobs_++;
+			}
+			// Exceptions are stored in the future by the packaged task
+			job();
+
+			bool idle;
+			{
+				std::lock_guard<std::mutex> lock{m_mutex_};
+				m_activeJobs_--;
+				idle = m_activeJobs_ == 0 && m_jobs_.empty();
+			}
+			// Pipelines keep no reference to their shader modules, so once nothing is being compiled the
+			// modules are only memory
+			if (idle) {
+				m_lveDevice_.shaderModuleCache().trim();
+			}
+		}
+	}
+}
@@ -0,0 +1,138 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEPIPELINECOMPILER_HPP
+#define VULKAN_TEST_LVEPIPELINECOMPILER_HPP
+
+#include "LveComputePipeline.hpp"
+#include "LveDevice.hpp"
+#include "LvePipeline.hpp"
+
+// std
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	// A pipeline being compiled by LvePipelineCompiler. Render systems poll it with get() and draw with a
+	// fallback while it is pending, or block on it with wait() when there is nothing to fall back to.
+	template<typename Pipeline>
+	class LveAsyncPipeline {
+	public:
+		LveAsyncPipeline() = default;
+
+		explicit LveAsyncPipeline(std::future<std::unique_ptr<Pipeline>> future) : m_future_{std::move(future)} {}
+
+		// The compile job may still be using state owned by the caller, such as the pipeline layout
+		~LveAsyncPipeline() { waitForCompletion(); }
+
+		LveAsyncPipeline(const LveAsyncPipeline &) = delete;
+
+		LveAsyncPipeline &operator=(const LveAsyncPipeline &) = delete;
+
+		LveAsyncPipeline(LveAsyncPipeline &&) noexcept = default;
+
+		LveAsyncPipeline &operator=(LveAsyncPipeline &&other) noexcept {
+			if (this != &other) {
+				waitForCompletion();
+				m_future_ = std::move(other.m_future_);
+				m_pipeline_ = std::move(other.m_pipeline_);
+			}
+			return *this;
+		}
+
+		// True once compilation has finished, successfully or not
+		bool isReady() const {
+			return !m_future_.valid() || m_future_.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+		}
+
+		// The pipeline if it has been compiled, nullptr while pending. Rethrows a compile error once.
+		Pipeline *get() {
+			if (!isReady()) {
+				return nullptr;
+			}
+			resolve();
+			return m_pipeline_.get();
+		}
+
+		// Blocks until the pipeline has been compiled
+		Pipeline &wait() {
+			resolve();
+			if (!m_pipeline_) {
+				throw std::runtime_error("Pipeline compilation failed");
+			}
+			return *m_pipeline_;
+		}
+
+	private:
+		void resolve() {
+			if (m_future_.valid()) {
+				m_pipeline_ = m_future_.get();
+			}
+		}
+
+		void waitForCompletion() const {
+			if (m_future_.valid()) {
+				m_future_.wait();
+			}
+		}
+
+		std::future<std::unique_ptr<Pipeline>> m_future_;
+		std::unique_ptr<Pipeline> m_pipeline_;
+	};
+
+	// Compiles pipelines on a pool of worker threads so that creating many of them, at startup or for new
+	// variants, scales with the number of cores. All workers share the device's pipeline cache, and the shader
+	// modules of a batch of pipelines are shared until the queue runs empty.
+	class LvePipelineCompiler {
+	public:
+		// threadCount 0 uses one thread per core, leaving one core for the render thread
+		explicit LvePipelineCompiler(LveDevice &device, uint32_t threadCount = 0);
+
+		// Finishes the queued jobs before joining the workers
+		~LvePipelineCompiler();
+
+		LvePipelineCompiler(const LvePipelineCompiler &) = delete;
+
+		LvePipelineCompiler &operator=(const LvePipelineCompiler &) = delete;
+
+		// configure runs on the worker, on a config already filled in by defaultPipelineConfigInfo. It must
+		// only capture state that outlives the returned pipeline handle.
+		LveAsyncPipeline<LvePipeline> compile(std::string vertFilePath,
+		                                      std::string fragFilePath,
+		                                      std::function<void(PipelineConfigInfo &)> configure);
+
+		LveAsyncPipeline<LveComputePipeline> compileCompute(std::string compFilePath,
+		                                                    std::function<void(ComputePipelineConfigInfo &)> configure);
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers_.size()); }
+
+	private:
+		template<typename Pipeline>
+		LveAsyncPipeline<Pipeline> submit(std::function<std::unique_ptr<Pipeline>()> build);
+
+		void workerLoop();
+
+		LveDevice &m_lveDevice_;
+
+		std::mutex m_mutex_;
+		std::condition_variable m_jobAvailable_;
+		std::deque<std::function<void()>> m_jobs_;
+		uint32_t m_activeJobs_ = 0;
+		bool m_stopping_ = false;
+		std::vector<std::thread> m_workers_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEPIPELINECOMPILER_HPP
@@ -0,0 +1,167 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LvePipelineLayoutCache.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+	LvePipelineLayoutCache::LvePipelineLayoutCache(VkDevice device) : m_device_{device} {}
+
+	LvePipelineLayoutCache::~LvePipelineLayoutCache() {
+		for (auto &[key, pipelineLayout]: m_pipelineLayouts_) {
+			vkDestroyPipelineLayout(m_device_, pipelineLayout, nullptr);
+		}
+		for (auto &[key, setLayout]: m_setLayouts_) {
+			vkDestroyDescriptorSetLayout(m_device_, setLayout, nullptr);
+		}
+	}
+
+	VkPipelineLayout LvePipelineLayoutCache::getPipelineLayout(
+			const std::vector<VkDescriptorSetLayout> &setLayouts,
+			const std::vector<VkPushConstantRange> &pushConstantRanges) {
+		Key key{setLayouts.size()};
+		for (auto setLayout: setLayouts) {
+			key.push_back(reinterpret_cast<uint64_t>(setLayout));
+		}
+		for (const auto &range: pushConstantRanges) {
+			key.push_back(range.stageFlags);
+			key.push_back((static_cast<uint64_t>(range.offset) << 32) | range.size);
+		}
+
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		auto it = m_pipelineLayouts_.find(key);
+		if (it != m_pipelineLayouts_.end()) {
+			return it->second;
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+		VkPipelineLayout pipelineLayout;
+		if (vkCreatePipelineLayout(m_device_, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create pipeline layout");
+		}
+		m_pipelineLayouts_.emplace(std::move(key), pipelineLayout);
+		return pipelineLayout;
+	}
+
+	VkPipelineLayout LvePipelineLayoutCache::getPipelineLayout(const std::vector<ShaderReflection> &shaders,
+	                                                           const std::vector<VkDescriptorSetLayout> &setLayouts) {
+#ifndef NDEBUG
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			for (const auto &shader: shaders) {
+				for (const auto &binding: shader.m_bindings) {
+					assert(binding.m_set < setLayouts.size() && "Shader uses a descriptor set the layout does not have");
+					// Layouts built elsewhere, such as the bindless heap, are trusted
+					auto known = m_setLayoutBindings_.find(setLayouts[binding.m_set]);
+					if (known == m_setLayoutBindings_.end()) {
+						continue;
+					}
+					auto match = std::find_if(known->second.begin(), known->second.end(),
+					                          [&](const VkDescriptorSetLayoutBinding &layoutBinding) {
+						                          return layoutBinding.binding == binding.m_binding;
+					                          });
+					assert(match != known->second.end() && match->descriptorType == binding.m_type &&
+					       (match->stageFlags & shader.m_stage) && "Shader binding does not match the set layout");
+				}
+			}
+		}
+#endif
+		return getPipelineLayout(setLayouts, getPushConstantRanges(shaders));
+	}
+
+	VkDescriptorSetLayout LvePipelineLayoutCache::getDescriptorSetLayout(const std::vector<ShaderReflection> &shaders,
+	                                                                     uint32_t set) {
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		for (const auto &shader: shaders) {
+			for (const auto &binding: shader.m_bindings) {
+				if (binding.m_set != set) {
+					continue;
+				}
+				if (binding.m_count == 0) {
+					throw std::runtime_error("Cannot create a set layout for the runtime sized array at binding " +
+					                         std::to_string(binding.m_binding));
+				}
+
+				auto existing = std::find_if(bindings.begin(), bindings.end(),
+				                             [&](const VkDescriptorSetLayoutBinding &layoutBinding) {
+					                             return layoutBinding.binding == binding.m_binding;
+				                             });
+				if (existing == bindings.end()) {
+					VkDescriptorSetLayoutBinding layoutBinding{};
+					layoutBinding.binding = binding.m_binding;
+					layoutBinding.descriptorType = binding.m_type;
+					layoutBinding.descriptorCount = binding.m_count;
+					layoutBinding.stageFlags = shader.m_stage;
+					bindings.push_back(layoutBinding);
+				} else if (existing->descriptorType != binding.m_type || existing->descriptorCount != binding.m_count) {
+					throw std::runtime_error("Shaders disagree on set " + std::to_string(set) + " binding " +
+					                         std::to_string(binding.m_binding));
+				} else {
+					existing->stageFlags |= shader.m_stage;
+				}
+			}
+		}
+		std::sort(bindings.begin(), bindings.end(),
+		          [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+			          return a.binding < b.binding;
+		          });
+
+		Key key{};
+		for (const auto &binding: bindings) {
+			key.push_back((static_cast<uint64_t>(binding.binding) << 32) | binding.descriptorType);
+			key.push_back((static_cast<uint64_t>(binding.descriptorCount) << 32) | binding.stageFlags);
+		}
+
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		auto it = m_setLayouts_.find(key);
+		if (it != m_setLayouts_.end()) {
+			return it->second;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout;
+		if (vkCreateDescriptorSetLayout(m_device_, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create descriptor set layout");
+		}
+		m_setLayouts_.emplace(std::move(key), setLayout);
+		m_setLayoutBindings_.emplace(setLayout, std::move(bindings));
+		return setLayout;
+	}
+
+	std::vector<VkPushConstantRange> LvePipelineLayoutCache::getPushConstantRanges(
+			const std::vector<ShaderReflection> &shaders) {
+		std::vector<VkPushConstantRange> ranges;
+		for (const auto &shader: shaders) {
+			if (shader.m_pushConstantSize == 0) {
+				continue;
+			}
+			auto existing = std::find_if(ranges.begin(), ranges.end(), [&](const VkPushConstantRange &range) {
+				return range.offset == shader.m_pushConstantOffset && range.size == shader.m_pushConstantSize;
+			});
+			if (existing != ranges.end()) {
+				existing->stageFlags |= shader.m_stage;
+			} else {
+				ranges.push_back({static_cast<VkShaderStageFlags>(shader.m_stage), shader.m_pushConstantOffset,
+				                  shader.m_pushConstantSize});
+			}
+		}
+		return ranges;
+	}
+}
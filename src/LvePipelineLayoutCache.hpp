@@ -0,0 +1,59 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEPIPELINELAYOUTCACHE_HPP
+#define VULKAN_TEST_LVEPIPELINELAYOUTCACHE_HPP
+
+#include "LveShaderReflection.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+	// Creates pipeline and descriptor set layouts from the interface the shaders declare and shares identical
+	// ones between pipelines. Layouts are owned by the cache and live as long as the device.
+	class LvePipelineLayoutCache {
+	public:
+		explicit LvePipelineLayoutCache(VkDevice device);
+
+		~LvePipelineLayoutCache();
+
+		LvePipelineLayoutCache(const LvePipelineLayoutCache &) = delete;
+
+		LvePipelineLayoutCache &operator=(const LvePipelineLayoutCache &) = delete;
+
+		VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts,
+		                                   const std::vector<VkPushConstantRange> &pushConstantRanges);
+
+		// Push constant ranges come from the shaders. Set layouts are still passed in, since binding flags and
+		// variable array sizes cannot be reflected; in debug builds they are checked against the shaders.
+		VkPipelineLayout getPipelineLayout(const std::vector<ShaderReflection> &shaders,
+		                                   const std::vector<VkDescriptorSetLayout> &setLayouts);
+
+		// A set layout with the bindings the shaders declare in set, visible to every stage that uses them.
+		// Throws for runtime sized arrays, which need an explicit size and binding flags.
+		VkDescriptorSetLayout getDescriptorSetLayout(const std::vector<ShaderReflection> &shaders, uint32_t set);
+
+		// One range per stage, stages with identical ranges are merged
+		static std::vector<VkPushConstantRange> getPushConstantRanges(const std::vector<ShaderReflection> &shaders);
+
+	private:
+		// Layouts are compared by their full contents, encoded as words
+		using Key = std::vector<uint64_t>;
+
+		VkDevice m_device_;
+		std::mutex m_mutex_;
+		std::map<Key, VkPipelineLayout> m_pipelineLayouts_;
+		std::map<Key, VkDescriptorSetLayout> m_setLayouts_;
+		// Bindings of the set layouts created here, for validation
+		std::map<VkDescriptorSetLayout, std::vector<VkDescriptorSetLayoutBinding>> m_setLayoutBindings_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEPIPELINELAYOUTCACHE_HPP
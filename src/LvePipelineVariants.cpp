@@ -0,0 +1,35 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LvePipelineVariants.hpp"
+
+namespace lve {
+
+	LvePipelineVariants::LvePipelineVariants(LvePipelineCompiler &compiler,
+	                                         std::string vertFilePath,
+	                                         std::string fragFilePath,
+	                                         std::function<void(PipelineConfigInfo &)> configure)
+			: m_compiler_{compiler},
+			  m_vertFilePath_{std::move(vertFilePath)},
+			  m_fragFilePath_{std::move(fragFilePath)},
+			  m_configure_{std::move(configure)} {}
+
+	LveAsyncPipeline<LvePipeline> &LvePipelineVariants::get(const SpecializationConstants &vertConstants,
+	                                                        const SpecializationConstants &fragConstants) {
+		VariantKey key{vertConstants, fragConstants};
+		auto it = m_variants_.find(key);
+		if (it != m_variants_.end()) {
+			return it->second;
+		}
+
+		auto pipeline = m_compiler_.compile(
+				m_vertFilePath_, m_fragFilePath_,
+				[configure = m_configure_, vertConstants, fragConstants](PipelineConfigInfo &configInfo) {
+					configure(configInfo);
+					configInfo.m_vertSpecialization = vertConstants;
+					configInfo.m_fragSpecialization = fragConstants;
+				});
+		return m_variants_.emplace(std::move(key), std::move(pipeline)).first->second;
+	}
+}
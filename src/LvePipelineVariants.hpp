@@ -0,0 +1,65 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVEPIPELINEVARIANTS_HPP
+#define VULKAN_TEST_LVEPIPELINEVARIANTS_HPP
+
+#include "LvePipeline.hpp"
+#include "LvePipelineCompiler.hpp"
+#include "LveSpecializationConstants.hpp"
+
+// std
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace lve {
+
+	// The specializations of one vertex/fragment shader pair. Each distinct combination of constant values is
+	// compiled once, on first request, and shared by every later request for the same values. This replaces
+	// runtime branches and duplicated .spv files for feature toggles such as debug views.
+	class LvePipelineVariants {
+	public:
+		// configure fills in the fixed function state shared by all variants, as for
+		// LvePipelineCompiler::compile
+		LvePipelineVariants(LvePipelineCompiler &compiler,
+		                    std::string vertFilePath,
+		                    std::string fragFilePath,
+		                    std::function<void(PipelineConfigInfo &)> configure);
+
+		LvePipelineVariants(const LvePipelineVariants &) = delete;
+
+		LvePipelineVariants &operator=(const LvePipelineVariants &) = delete;
+
+		// Queues the variant for compilation if it has not been requested before. The returned reference stays
+		// valid for the lifetime of this object.
+		LveAsyncPipeline<LvePipeline> &get(const SpecializationConstants &vertConstants,
+		                                   const SpecializationConstants &fragConstants);
+
+		size_t size() const { return m_variants_.size(); }
+
+	private:
+		struct VariantKey {
+			SpecializationConstants m_vertConstants;
+			SpecializationConstants m_fragConstants;
+
+			bool operator==(const VariantKey &other) const = default;
+		};
+
+		struct VariantKeyHash {
+			size_t operator()(const VariantKey &key) const {
+				return key.m_vertConstants.hash() * 31 + key.m_fragConstants.hash();
+			}
+		};
+
+		LvePipelineCompiler &m_compiler_;
+		std::string m_vertFilePath_;
+		std::string m_fragFilePath_;
+		std::function<void(PipelineConfigInfo &)> m_configure_;
+
+		std::unordered_map<VariantKey, LveAsyncPipeline<LvePipeline>, VariantKeyHash> m_variants_;
+	};
+}
+
+#endif //VULKAN_TEST_LVEPIPELINEVARIANTS_HPP
@@ -0,0 +1,126 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveRadixSort.hpp"
+#include "LveJobSystem.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+
+namespace lve {
+
+	namespace {
+		// Below this the cost of scheduling jobs outweighs the gain
+		constexpr size_t parallelThreshold = 1 << 16;
+
+		using Histogram = std::array<size_t, 256>;
+
+		inline uint32_t digit(const SortItem &item, uint32_t shift) {
+			return static_cast<uint32_t>((item.m_key >> shift) & 0xFFu);
+		}
+
+		void radixSortSequential(std::vector<SortItem> &items, std::vector<SortItem> &scratch, uint32_t keyBits) {
+			for (uint32_t shift = 0; shift < keyBits; shift += 8) {
+				Histogram counts{};
+				for (const auto &item: items) {
+					counts[digit(item, shift)]++;
+				}
+				if (counts[digit(items.front(), shift)] == items.size()) {
+					continue;
+				}
+
+				size_t offset = 0;
+				for (auto &count: counts) {
+					size_t bucketSize = count;
+					count = offset;
+					offset += bucketSize;
+				}
+				for (const auto &item: items) {
+					scratch[counts[digit(item, shift)]++] = item;
+				}
+				items.swap(scratch);
+			}
+		}
+
+		void radixSortParallel(std::vector<SortItem> &items,
+		                       std::vector<SortItem> &scratch,
+		                       uint32_t keyBits,
+		                       LveJobSystem &jobSystem) {
+			const size_t count = items.size();
+			// No point in more chunks than items
+			const auto chunkCount = static_cast<uint32_t>(std::min<size_t>(jobSystem.getThreadCount(), count));
+			const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+			// Each job histograms and scatters its own contiguous chunk. Offsets are laid out bucket major,
+			// chunk minor, which keeps the sort stable.
+			std::vector<Histogram> histograms(chunkCount);
+			SortItem *src = items.data();
+			SortItem *dst = scratch.data();
+			for (uint32_t shift = 0; shift < keyBits; shift += 8) {
+				jobSystem.parallelFor(chunkCount, 1, [&](uint32_t firstChunk, uint32_t lastChunk) {
+					for (uint32_t chunk = firstChunk; chunk < lastChunk; chunk++) {
+						auto &histogram = histograms[chunk];
+						histogram.fill(0);
+						const size_t end = std::min(count, (chunk + 1) * chunkSize);
+						for (size_t i = chunk * chunkSize; i < end; i++) {
+							histogram[digit(src[i], shift)]++;
+						}
+					}
+				});
+
+				size_t total = 0;
+				bool skipPass = false;
+				for (uint32_t bucket = 0; bucket < 256; bucket++) {
+					size_t bucketTotal = 0;
+					for (auto &histogram: histograms) {
+						bucketTotal += histogram[bucket];
+					}
+					skipPass |= bucketTotal == count;
+
+					for (auto &histogram: histograms) {
+						size_t bucketSize = histogram[bucket];
+						histogram[bucket] = total;
+						total += bucketSize;
+					}
+				}
+				if (skipPass) {
+					continue;
+				}
+
+				jobSystem.parallelFor(chunkCount, 1, [&](uint32_t firstChunk, uint32_t lastChunk) {
+					for (uint32_t chunk = firstChunk; chunk < lastChunk; chunk++) {
+						auto &histogram = histograms[chunk];
+						const size_t end = std::min(count, (chunk + 1) * chunkSize);
+						for (size_t i = chunk * chunkSize; i < end; i++) {
+							dst[histogram[digit(src[i], shift)]++] = src[i];
+						}
+					}
+				});
+				std::swap(src, dst);
+			}
+
+			if (src != items.data()) {
+				items.swap(scratch);
+			}
+		}
+	}
+
+	void radixSort(std::vector<SortItem> &items,
+	               std::vector<SortItem> &scratch,
+	               uint32_t keyBits,
+	               LveJobSystem *jobSystem) {
+		if (items.size() < 2) {
+			return;
+		}
+		scratch.resize(items.size());
+		keyBits = std::min(keyBits, 64u);
+
+		if (jobSystem && jobSystem->getThreadCount() > 1 && items.size() >= parallelThreshold) {
+			radixSortParallel(items, scratch, keyBits, *jobSystem);
+		} else {
+			radixSortSequential(items, scratch, keyBits);
+		}
+	}
+}
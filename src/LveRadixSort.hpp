@@ -0,0 +1,38 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVERADIXSORT_HPP
+#define VULKAN_TEST_LVERADIXSORT_HPP
+
+// std
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace lve {
+
+	class LveJobSystem;
+
+	struct SortItem {
+		uint64_t m_key;
+		uint32_t m_index;
+	};
+
+	// Maps a float to an unsigned integer with the same ordering, negative values included
+	inline uint32_t floatToSortKey(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(float));
+		return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+	}
+
+	// Stable LSD radix sort on the low keyBits bits of each key, ascending, 8 bits per pass. Digits that
+	// are equal for every item are skipped. Large inputs are split over the threads of jobSystem when one
+	// is given; scratch is reused between calls.
+	void radixSort(std::vector<SortItem> &items,
+	               std::vector<SortItem> &scratch,
+	               uint32_t keyBits = 64,
+	               LveJobSystem *jobSystem = nullptr);
+}
+
+#endif //VULKAN_TEST_LVERADIXSORT_HPP
@@ -0,0 +1,851 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveRenderGraph.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+		// Compiled graphs that have not been used for this many frames are destroyed. Has to exceed the
+		// frames in flight, which may still use them.
+		constexpr uint64_t evictAfterFrames = 60;
+
+		constexpr VkAccessFlags writeAccessMask =
+				VK_ACCESS_SHADER_WRITE_BIT |
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+				VK_ACCESS_TRANSFER_WRITE_BIT |
+				VK_ACCESS_HOST_WRITE_BIT |
+				VK_ACCESS_MEMORY_WRITE_BIT;
+
+		bool isDepthFormat(VkFormat format) {
+			return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D32_SFLOAT ||
+			       format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+		}
+
+		bool hasStencilComponent(VkFormat format) {
+			return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+		}
+
+		VkImageAspectFlags barrierAspect(VkFormat format) {
+			if (!isDepthFormat(format)) {
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+			}
+			return hasStencilComponent(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+			                                   : VK_IMAGE_ASPECT_DEPTH_BIT;
+		}
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::colorAttachment(RenderGraphResource image,
+	                                                                VkAttachmentLoadOp loadOp,
+	                                                                VkClearColorValue clearValue) {
+		auto &access = m_graph_.addAccess(m_pass_, image);
+		access.m_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		access.m_stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		access.m_access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+			access.m_access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+		}
+		access.m_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		access.m_write = true;
+		access.m_attachment = true;
+		access.m_loadOp = loadOp;
+		access.m_clearValue.color = clearValue;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::depthAttachment(RenderGraphResource image,
+	                                                                VkAttachmentLoadOp loadOp,
+	                                                                VkClearDepthStencilValue clearValue) {
+		auto &access = m_graph_.addAccess(m_pass_, image);
+		access.m_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		access.m_stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		access.m_access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		access.m_usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		access.m_write = true;
+		access.m_attachment = true;
+		access.m_loadOp = loadOp;
+		access.m_clearValue.depthStencil = clearValue;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::sampledImage(RenderGraphResource image,
+	                                                             VkPipelineStageFlags stages,
+	                                                             VkImageLayout layout) {
+		auto &access = m_graph_.addAccess(m_pass_, image);
+		if (layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+			layout = isDepthFormat(m_graph_.m_resources_[image].m_image.m_format)
+			         ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+			         : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+		access.m_layout = layout;
+		access.m_stages = stages;
+		access.m_access = VK_ACCESS_SHADER_READ_BIT;
+		access.m_usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::storageImage(RenderGraphResource image,
+	                                                             VkPipelineStageFlags stages,
+	                                                             bool write) {
+		auto &access = m_graph_.addAccess(m_pass_, image);
+		access.m_layout = VK_IMAGE_LAYOUT_GENERAL;
+		access.m_stages = stages;
+		access.m_access = write ? VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT;
+		access.m_usage = VK_IMAGE_USAGE_STORAGE_BIT;
+		access.m_write = write;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::transferSource(RenderGraphResource image) {
+		auto &access = m_graph_.addAccess(m_pass_, image);
+		access.m_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		access.m_stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		access.m_access = VK_ACCESS_TRANSFER_READ_BIT;
+		access.m_usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::readBuffer(RenderGraphResource buffer,
+	                                                           VkPipelineStageFlags stages,
+	                                                           VkAccessFlags access) {
+		auto &bufferAccess = m_graph_.addAccess(m_pass_, buffer);
+		bufferAccess.m_stages = stages;
+		bufferAccess.m_access = access;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::writeBuffer(RenderGraphResource buffer,
+	                                                            VkPipelineStageFlags stages,
+	                                                            VkAccessFlags access) {
+		auto &bufferAccess = m_graph_.addAccess(m_pass_, buffer);
+		bufferAccess.m_stages = stages;
+		bufferAccess.m_access = access;
+		bufferAccess.m_write = true;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::sideEffect() {
+		m_graph_.m_passes_[m_pass_].m_sideEffect = true;
+		return *this;
+	}
+
+	LveRenderGraph::LveRenderGraph(LveDevice &device) : m_lveDevice_{device} {}
+
+	LveRenderGraph::~LveRenderGraph() {
+		reset();
+	}
+
+	void LveRenderGraph::beginFrame(int frameIndex) {
+		m_frameIndex_ = frameIndex;
+		m_resources_.clear();
+		m_passes_.clear();
+	}
+
+	RenderGraphResource LveRenderGraph::importImage(const std::string &name,
+	                                                const RenderGraphImageInfo &info,
+	                                                VkImageLayout initialLayout,
+	                                                VkImageLayout finalLayout,
+	                                                VkPipelineStageFlags priorStages,
+	                                                VkAccessFlags priorAccess) {
+		m_resources_.push_back({name, false, true, info, VK_NULL_HANDLE, initialLayout, finalLayout,
+		                        priorStages, priorAccess});
+		return static_cast<RenderGraphResource>(m_resources_.size() - 1);
+	}
+
+	RenderGraphResource LveRenderGraph::importBuffer(const std::string &name,
+	                                                 VkBuffer buffer,
+	                                                 VkPipelineStageFlags priorStages,
+	                                                 VkAccessFlags priorAccess) {
+		m_resources_.push_back({name, true, true, {}, buffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED,
+		                        priorStages, priorAccess});
+		return static_cast<RenderGraphResource>(m_resources_.size() - 1);
+	}
+
+	RenderGraphResource LveRenderGraph::createImage(const std::string &name, VkFormat format, VkExtent2D extent) {
+		RenderGraphImageInfo info{};
+		info.m_format = format;
+		info.m_extent = extent;
+		m_resources_.push_back({name, false, false, info, VK_NULL_HANDLE,
+		                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0});
+		return static_cast<RenderGraphResource>(m_resources_.size() - 1);
+	}
+
+	void LveRenderGraph::addPass(const std::string &name,
+	                             PassType type,
+	                             const std::function<void(RenderGraphPassBuilder &)> &setup,
+	                             std::function<void(VkCommandBuffer)> execute) {
+		m_passes_.push_back({name, type, false, {}, std::move(execute)});
+		RenderGraphPassBuilder builder{*this, static_cast<uint32_t>(m_passes_.size() - 1)};
+		setup(builder);
+	}
+
+	LveRenderGraph::Access &LveRenderGraph::addAccess(uint32_t pass, RenderGraphResource resource) {
+#ifndef NDEBUG
+		assert(resource < m_resources_.size() && "Render graph resource was not declared in this frame");
+#endif
+		auto &access = m_passes_[pass].m_accesses.emplace_back();
+		access.m_resource = resource;
+		access.m_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		access.m_stages = 0;
+		access.m_access = 0;
+		access.m_usage = 0;
+		access.m_write = false;
+		access.m_attachment = false;
+		access.m_loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		access.m_clearValue = {};
+		return access;
+	}
+
+	const RenderGraphImageInfo &LveRenderGraph::getImage(RenderGraphResource image) const {
+#ifndef NDEBUG
+		assert(image < m_resources_.size() && !m_resources_[image].m_buffer && "Not an image of this frame");
+#endif
+		return m_resources_[image].m_image;
+	}
+
+	VkBuffer LveRenderGraph::getBuffer(RenderGraphResource buffer) const {
+#ifndef NDEBUG
+		assert(buffer < m_resources_.size() && m_resources_[buffer].m_buffer && "Not a buffer of this frame");
+#endif
+		return m_resources_[buffer].m_bufferHandle;
+	}
+
+	LveRenderGraph::Key LveRenderGraph::topologyKey() const {
+		Key key;
+		key.push_back(m_resources_.size());
+		for (const auto &resource: m_resources_) {
+			key.push_back(resource.m_buffer);
+			key.push_back(resource.m_imported);
+			key.push_back(resource.m_image.m_format);
+			key.push_back((static_cast<uint64_t>(resource.m_image.m_extent.width) << 32) |
+			              resource.m_image.m_extent.height);
+			key.push_back((static_cast<uint64_t>(resource.m_initialLayout) << 32) | resource.m_finalLayout);
+			key.push_back((static_cast<uint64_t>(resource.m_priorStages) << 32) | resource.m_priorAccess);
+		}
+		key.push_back(m_passes_.size());
+		for (const auto &pass: m_passes_) {
+			key.push_back(static_cast<uint64_t>(pass.m_type));
+			key.push_back(pass.m_sideEffect);
+			key.push_back(pass.m_accesses.size());
+			for (const auto &access: pass.m_accesses) {
+				key.push_back((static_cast<uint64_t>(access.m_resource) << 32) | access.m_layout);
+				key.push_back((static_cast<uint64_t>(access.m_stages) << 32) | access.m_access);
+				key.push_back((static_cast<uint64_t>(access.m_usage) << 32) |
+				              (static_cast<uint64_t>(access.m_loadOp) << 2) |
+				              (access.m_attachment ? 2u : 0u) | (access.m_write ? 1u : 0u));
+			}
+		}
+		return key;
+	}
+
+	std::vector<bool> LveRenderGraph::cullPasses() const {
+		// Walk backwards from the passes with visible results: imported resources outlive the frame, transient
+		// ones only matter when a kept pass reads them
+		std::vector<bool> kept(m_passes_.size(), false);
+		std::vector<bool> needed(m_resources_.size(), false);
+		for (size_t i = m_passes_.size(); i-- > 0;) {
+			const auto &pass = m_passes_[i];
+			bool keep = pass.m_sideEffect;
+			for (const auto &access: pass.m_accesses) {
+				if (access.m_write && (m_resources_[access.m_resource].m_imported || needed[access.m_resource])) {
+					keep = true;
+				}
+			}
+			if (!keep) {
+				continue;
+			}
+			kept[i] = true;
+			for (const auto &access: pass.m_accesses) {
+				bool cleared = access.m_attachment && access.m_loadOp != VK_ATTACHMENT_LOAD_OP_LOAD;
+				if (!cleared && (access.m_access & ~writeAccessMask) != 0) {
+					needed[access.m_resource] = true;
+				}
+			}
+		}
+		return kept;
+	}
+
+	LveRenderGraph::CompiledGraph LveRenderGraph::compile() {
+		CompiledGraph graph{};
+
+		auto kept = cullPasses();
+		std::vector<uint32_t> order;
+		for (uint32_t i = 0; i < m_passes_.size(); i++) {
+			if (kept[i]) {
+				order.push_back(i);
+			}
+		}
+
+		std::vector<uint32_t> firstUse(m_resources_.size(), unused);
+		std::vector<uint32_t> lastUse(m_resources_.size(), unused);
+		for (uint32_t position = 0; position < order.size(); position++) {
+			for (const auto &access: m_passes_[order[position]].m_accesses) {
+				if (firstUse[access.m_resource] == unused) {
+					firstUse[access.m_resource] = position;
+				}
+				lastUse[access.m_resource] = position;
+			}
+		}
+
+		// Transient images sharing memory with an earlier one wait for its last use before their first
+		std::vector<RenderGraphResource> aliasPredecessor(m_resources_.size(), unused);
+		allocateTransients(graph, firstUse, lastUse, aliasPredecessor);
+
+		// Replay the accesses in order, tracking per resource what has to complete before the next access
+		struct State {
+			VkImageLayout m_layout;
+			VkPipelineStageFlags m_writeStages;
+			VkAccessFlags m_writeAccess;
+			VkPipelineStageFlags m_readStages;
+			VkPipelineStageFlags m_visibleStages;
+			VkAccessFlags m_visibleAccess;
+		};
+		std::vector<State> states(m_resources_.size());
+		for (size_t i = 0; i < m_resources_.size(); i++) {
+			const auto &resource = m_resources_[i];
+			// An imported resource counts as written before the graph, so its first read waits for that write
+			states[i] = resource.m_imported
+			            ? State{resource.m_initialLayout, resource.m_priorStages, resource.m_priorAccess, 0, 0, 0}
+			            : State{VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, 0, 0, 0};
+		}
+
+		// Work outside the graph that may still use an imported image, such as presentation, is only known
+		// to have finished somewhere in the pipeline
+		auto sourceStages = [this](RenderGraphResource resource, VkPipelineStageFlags stages) {
+			if (stages != 0) {
+				return stages;
+			}
+			return m_resources_[resource].m_imported ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
+			                                         : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+		};
+
+		for (uint32_t position = 0; position < order.size(); position++) {
+			const auto &pass = m_passes_[order[position]];
+			CompiledPass compiledPass{};
+			compiledPass.m_pass = order[position];
+
+			// A pass may access a resource in several ways, which are synchronized as one
+			std::vector<Access> merged;
+			for (const auto &access: pass.m_accesses) {
+#ifndef NDEBUG
+				assert((!access.m_attachment || pass.m_type == PassType::Raster) &&
+				       "Attachments can only be used by raster passes");
+				assert(m_resources_[access.m_resource].m_buffer == (access.m_layout == VK_IMAGE_LAYOUT_UNDEFINED) &&
+				       "Buffer accessed as an image or image as a buffer");
+#endif
+				auto existing = std::find_if(merged.begin(), merged.end(), [&](const Access &other) {
+					return other.m_resource == access.m_resource;
+				});
+				if (existing == merged.end()) {
+					merged.push_back(access);
+					continue;
+				}
+#ifndef NDEBUG
+				assert(existing->m_layout == access.m_layout && "An image can only be in one layout within a pass");
+#endif
+				existing->m_stages |= access.m_stages;
+				existing->m_access |= access.m_access;
+				existing->m_write = existing->m_write || access.m_write;
+			}
+
+			for (const auto &access: merged) {
+				auto &state = states[access.m_resource];
+				const bool buffer = m_resources_[access.m_resource].m_buffer;
+				const bool layoutChange = !buffer && state.m_layout != access.m_layout;
+
+				Barrier barrier{access.m_resource, state.m_layout, access.m_layout, 0, 0,
+				                access.m_stages, access.m_access};
+				bool needsBarrier;
+				if (access.m_write || layoutChange) {
+					// Writes and layout transitions wait for every earlier access
+					barrier.m_srcStages = state.m_writeStages | state.m_readStages;
+					barrier.m_srcAccess = state.m_writeAccess;
+					if (firstUse[access.m_resource] == position && aliasPredecessor[access.m_resource] != unused) {
+						const auto &predecessor = states[aliasPredecessor[access.m_resource]];
+						barrier.m_srcStages |= predecessor.m_writeStages | predecessor.m_readStages;
+						barrier.m_srcAccess |= predecessor.m_writeAccess;
+					}
+					needsBarrier = layoutChange || barrier.m_srcStages != 0;
+
+					state.m_layout = access.m_layout;
+					state.m_writeStages = access.m_stages;
+					state.m_writeAccess = access.m_access & writeAccessMask;
+					state.m_readStages = access.m_write ? 0 : access.m_stages;
+					state.m_visibleStages = access.m_stages;
+					state.m_visibleAccess = access.m_access;
+				} else {
+					// Reads only wait for the last write, once per stage and access
+					needsBarrier = state.m_writeStages != 0 &&
+					               ((access.m_stages & ~state.m_visibleStages) != 0 ||
+					                (access.m_access & ~state.m_visibleAccess) != 0);
+					barrier.m_srcStages = state.m_writeStages;
+					barrier.m_srcAccess = state.m_writeAccess;
+
+					state.m_readStages |= access.m_stages;
+					if (needsBarrier) {
+						state.m_visibleStages |= access.m_stages;
+						state.m_visibleAccess |= access.m_access;
+					}
+				}
+
+				if (needsBarrier) {
+					barrier.m_srcStages = sourceStages(access.m_resource, barrier.m_srcStages);
+					compiledPass.m_barriers.push_back(barrier);
+				}
+			}
+
+			if (pass.m_type == PassType::Raster && !m_lveDevice_.supportsDynamicRendering()) {
+				compiledPass.m_renderPass = createRenderPass(pass);
+			}
+			graph.m_passes.push_back(std::move(compiledPass));
+		}
+
+		for (RenderGraphResource i = 0; i < m_resources_.size(); i++) {
+			const auto &resource = m_resources_[i];
+			const auto &state = states[i];
+			if (resource.m_buffer || !resource.m_imported || resource.m_finalLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+			    resource.m_finalLayout == state.m_layout) {
+				continue;
+			}
+			graph.m_finalBarriers.push_back({i, state.m_layout, resource.m_finalLayout,
+			                                 sourceStages(i, state.m_writeStages | state.m_readStages),
+			                                 state.m_writeAccess,
+			                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0});
+		}
+
+		return graph;
+	}
+
+	void LveRenderGraph::allocateTransients(CompiledGraph &graph,
+	                                        const std::vector<uint32_t> &firstUse,
+	                                        const std::vector<uint32_t> &lastUse,
+	                                        std::vector<RenderGraphResource> &aliasPredecessor) {
+		graph.m_transients.resize(LveSwapChain::m_maxFramesInFlight);
+		for (auto &frame: graph.m_transients) {
+			frame.m_images.assign(m_resources_.size(), VK_NULL_HANDLE);
+			frame.m_imageViews.assign(m_resources_.size(), VK_NULL_HANDLE);
+		}
+
+		std::vector<RenderGraphResource> transients;
+		std::vector<VkImageUsageFlags> usage(m_resources_.size(), 0);
+		for (uint32_t i = 0; i < m_passes_.size(); i++) {
+			for (const auto &access: m_passes_[i].m_accesses) {
+				usage[access.m_resource] |= access.m_usage;
+			}
+		}
+		for (RenderGraphResource i = 0; i < m_resources_.size(); i++) {
+			if (!m_resources_[i].m_imported && !m_resources_[i].m_buffer && firstUse[i] != unused) {
+				transients.push_back(i);
+			}
+		}
+		if (transients.empty()) {
+			return;
+		}
+
+		for (auto &frame: graph.m_transients) {
+			for (auto resource: transients) {
+				const auto &info = m_resources_[resource].m_image;
+				VkImageCreateInfo imageInfo{};
+				imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageInfo.format = info.m_format;
+				imageInfo.extent = {info.m_extent.width, info.m_extent.height, 1};
+				imageInfo.mipLevels = 1;
+				imageInfo.arrayLayers = 1;
+				imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageInfo.usage = usage[resource];
+				imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				if (vkCreateImage(m_lveDevice_.device(), &imageInfo, nullptr, &frame.m_images[resource]) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to create transient image " + m_resources_[resource].m_name);
+				}
+			}
+		}
+
+		// Largest first, each image goes into the first block none of whose images is alive at the same time
+		struct Block {
+			VkDeviceSize m_size = 0;
+			VkDeviceSize m_alignment = 1;
+			uint32_t m_memoryTypeBits = ~0u;
+			std::vector<RenderGraphResource> m_images;
+		};
+		std::vector<VkMemoryRequirements> requirements(m_resources_.size());
+		for (auto resource: transients) {
+			vkGetImageMemoryRequirements(m_lveDevice_.device(), graph.m_transients[0].m_images[resource],
+			                             &requirements[resource]);
+		}
+		std::sort(transients.begin(), transients.end(), [&](RenderGraphResource a, RenderGraphResource b) {
+			return requirements[a].size > requirements[b].size;
+		});
+
+		std::vector<Block> blocks;
+		for (auto resource: transients) {
+			const auto &requirement = requirements[resource];
+			auto block = std::find_if(blocks.begin(), blocks.end(), [&](const Block &candidate) {
+				if ((candidate.m_memoryTypeBits & requirement.memoryTypeBits) == 0) {
+					return false;
+				}
+				return std::all_of(candidate.m_images.begin(), candidate.m_images.end(),
+				                   [&](RenderGraphResource other) {
+					                   return lastUse[other] < firstUse[resource] ||
+					                          lastUse[resource] < firstUse[other];
+				                   });
+			});
+			if (block == blocks.end()) {
+				block = blocks.insert(blocks.end(), Block{});
+			}
+			block->m_size = std::max(block->m_size, requirement.size);
+			block->m_alignment = std::max(block->m_alignment, requirement.alignment);
+			block->m_memoryTypeBits &= requirement.memoryTypeBits;
+			block->m_images.push_back(resource);
+		}
+
+		for (const auto &block: blocks) {
+			for (auto resource: block.m_images) {
+				for (auto other: block.m_images) {
+					if (lastUse[other] < firstUse[resource] &&
+					    (aliasPredecessor[resource] == unused || lastUse[other] > lastUse[aliasPredecessor[resource]])) {
+						aliasPredecessor[resource] = other;
+					}
+				}
+			}
+		}
+
+		for (auto &frame: graph.m_transients) {
+			for (const auto &block: blocks) {
+				VkMemoryAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				allocInfo.allocationSize = block.m_size;
+				allocInfo.memoryTypeIndex = m_lveDevice_.findMemoryType(block.m_memoryTypeBits,
+				                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				VkDeviceMemory memory;
+				if (vkAllocateMemory(m_lveDevice_.device(), &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+					throw std::runtime_error("Failed to allocate transient image memory");
+				}
+				frame.m_memory.push_back(memory);
+
+				for (auto resource: block.m_images) {
+					vkBindImageMemory(m_lveDevice_.device(), frame.m_images[resource], memory, 0);
+
+					const auto &info = m_resources_[resource].m_image;
+					VkImageViewCreateInfo viewInfo{};
+					viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+					viewInfo.image = frame.m_images[resource];
+					viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+					viewInfo.format = info.m_format;
+					viewInfo.subresourceRange.aspectMask =
+							isDepthFormat(info.m_format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+					viewInfo.subresourceRange.baseMipLevel = 0;
+					viewInfo.subresourceRange.levelCount = 1;
+					viewInfo.subresourceRange.baseArrayLayer = 0;
+					viewInfo.subresourceRange.layerCount = 1;
+					if (vkCreateImageView(m_lveDevice_.device(), &viewInfo, nullptr,
+					                      &frame.m_imageViews[resource]) != VK_SUCCESS) {
+						throw std::runtime_error("Failed to create transient image view " + m_resources_[resource].m_name);
+					}
+				}
+			}
+		}
+	}
+
+	VkRenderPass LveRenderGraph::createRenderPass(const Pass &pass) const {
+		// The graph already moved the attachments into their layouts, so the render pass keeps them there
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorReferences;
+		VkAttachmentReference depthReference{};
+		bool hasDepth = false;
+		for (const auto &access: pass.m_accesses) {
+			if (!access.m_attachment) {
+				continue;
+			}
+			VkAttachmentDescription attachment{};
+			attachment.format = m_resources_[access.m_resource].m_image.m_format;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = access.m_loadOp;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = access.m_layout;
+			attachment.finalLayout = access.m_layout;
+			if (access.m_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+				hasDepth = true;
+				depthReference = {0, access.m_layout};
+			} else {
+				colorReferences.push_back({0, access.m_layout});
+			}
+			attachments.push_back(attachment);
+		}
+
+		// Colors first and depth last, the order compatible render passes such as the swap chain's use
+		std::stable_partition(attachments.begin(), attachments.end(), [](const VkAttachmentDescription &attachment) {
+			return attachment.finalLayout != VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		});
+		for (uint32_t i = 0; i < colorReferences.size(); i++) {
+			colorReferences[i].attachment = i;
+		}
+		depthReference.attachment = static_cast<uint32_t>(colorReferences.size());
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+		subpass.pColorAttachments = colorReferences.data();
+		subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(m_lveDevice_.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create render pass for " + pass.m_name);
+		}
+		return renderPass;
+	}
+
+	VkFramebuffer LveRenderGraph::getFramebuffer(CompiledPass &compiledPass, const Pass &pass, VkExtent2D extent) {
+		std::vector<VkImageView> views;
+		VkImageView depthView = VK_NULL_HANDLE;
+		for (const auto &access: pass.m_accesses) {
+			if (!access.m_attachment) {
+				continue;
+			}
+			if (access.m_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+				depthView = m_resources_[access.m_resource].m_image.m_imageView;
+			} else {
+				views.push_back(m_resources_[access.m_resource].m_image.m_imageView);
+			}
+		}
+		if (depthView != VK_NULL_HANDLE) {
+			views.push_back(depthView);
+		}
+
+		auto [framebuffer, inserted] = compiledPass.m_framebuffers.try_emplace(views, VK_NULL_HANDLE);
+		if (inserted) {
+			VkFramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = compiledPass.m_renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+			framebufferInfo.pAttachments = views.data();
+			framebufferInfo.width = extent.width;
+			framebufferInfo.height = extent.height;
+			framebufferInfo.layers = 1;
+			if (vkCreateFramebuffer(m_lveDevice_.device(), &framebufferInfo, nullptr, &framebuffer->second) !=
+			    VK_SUCCESS) {
+				compiledPass.m_framebuffers.erase(framebuffer);
+				throw std::runtime_error("Failed to create framebuffer for " + pass.m_name);
+			}
+		}
+		return framebuffer->second;
+	}
+
+	void LveRenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> &barriers) const {
+		if (barriers.empty()) {
+			return;
+		}
+
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		for (const auto &barrier: barriers) {
+			const auto &resource = m_resources_[barrier.m_resource];
+			srcStages |= barrier.m_srcStages;
+			dstStages |= barrier.m_dstStages;
+			if (resource.m_buffer) {
+				VkBufferMemoryBarrier bufferBarrier{};
+				bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				bufferBarrier.srcAccessMask = barrier.m_srcAccess;
+				bufferBarrier.dstAccessMask = barrier.m_dstAccess;
+				bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.buffer = resource.m_bufferHandle;
+				bufferBarrier.offset = 0;
+				bufferBarrier.size = VK_WHOLE_SIZE;
+				bufferBarriers.push_back(bufferBarrier);
+			} else {
+				VkImageMemoryBarrier imageBarrier{};
+				imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				imageBarrier.srcAccessMask = barrier.m_srcAccess;
+				imageBarrier.dstAccessMask = barrier.m_dstAccess;
+				imageBarrier.oldLayout = barrier.m_oldLayout;
+				imageBarrier.newLayout = barrier.m_newLayout;
+				imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.image = resource.m_image.m_image;
+				imageBarrier.subresourceRange = {barrierAspect(resource.m_image.m_format), 0, VK_REMAINING_MIP_LEVELS,
+				                                 0, VK_REMAINING_ARRAY_LAYERS};
+				imageBarriers.push_back(imageBarrier);
+			}
+		}
+
+		vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0,
+		                     0, nullptr,
+		                     static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+		                     static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	}
+
+	void LveRenderGraph::beginPass(VkCommandBuffer commandBuffer, CompiledPass &compiledPass, const Pass &pass) {
+		VkExtent2D extent{0, 0};
+		std::vector<VkRenderingAttachmentInfo> colorAttachments;
+		VkRenderingAttachmentInfo depthAttachment{};
+		std::vector<VkClearValue> clearValues;
+		VkClearValue depthClearValue{};
+		bool hasDepth = false;
+		for (const auto &access: pass.m_accesses) {
+			if (!access.m_attachment) {
+				continue;
+			}
+			const auto &image = m_resources_[access.m_resource].m_image;
+#ifndef NDEBUG
+			assert((extent.width == 0 ||
+			        (extent.width == image.m_extent.width && extent.height == image.m_extent.height)) &&
+			       "Attachments of a pass must have the same extent");
+#endif
+			extent = image.m_extent;
+
+			VkRenderingAttachmentInfo attachment{};
+			attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			attachment.imageView = image.m_imageView;
+			attachment.imageLayout = access.m_layout;
+			attachment.loadOp = access.m_loadOp;
+			attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachment.clearValue = access.m_clearValue;
+			if (access.m_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+				depthAttachment = attachment;
+				depthClearValue = access.m_clearValue;
+				hasDepth = true;
+			} else {
+				colorAttachments.push_back(attachment);
+				clearValues.push_back(access.m_clearValue);
+			}
+		}
+		if (hasDepth) {
+			clearValues.push_back(depthClearValue);
+		}
+
+		if (compiledPass.m_renderPass == VK_NULL_HANDLE) {
+			VkRenderingInfo renderingInfo{};
+			renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+			renderingInfo.renderArea = {{0, 0}, extent};
+			renderingInfo.layerCount = 1;
+			renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+			renderingInfo.pColorAttachments = colorAttachments.data();
+			renderingInfo.pDepthAttachment = hasDepth ? &depthAttachment : nullptr;
+			m_lveDevice_.cmdBeginRendering(commandBuffer, &renderingInfo);
+		} else {
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = compiledPass.m_renderPass;
+			renderPassInfo.framebuffer = getFramebuffer(compiledPass, pass, extent);
+			renderPassInfo.renderArea = {{0, 0}, extent};
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+			renderPassInfo.pClearValues = clearValues.data();
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		}
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{{0, 0}, extent};
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void LveRenderGraph::endPass(VkCommandBuffer commandBuffer, const CompiledPass &compiledPass) const {
+		if (compiledPass.m_renderPass == VK_NULL_HANDLE) {
+			m_lveDevice_.cmdEndRendering(commandBuffer);
+		} else {
+			vkCmdEndRenderPass(commandBuffer);
+		}
+	}
+
+	void LveRenderGraph::execute(VkCommandBuffer commandBuffer) {
+		auto key = topologyKey();
+		auto compiled = m_compiledGraphs_.find(key);
+		if (compiled == m_compiledGraphs_.end()) {
+			compiled = m_compiledGraphs_.emplace(std::move(key), compile()).first;
+		}
+		auto &graph = compiled->second;
+		graph.m_lastUsedFrame = m_frameCount_;
+
+		const auto &transients = graph.m_transients[m_frameIndex_];
+		for (RenderGraphResource i = 0; i < m_resources_.size(); i++) {
+			if (!m_resources_[i].m_imported && !m_resources_[i].m_buffer) {
+				m_resources_[i].m_image.m_image = transients.m_images[i];
+				m_resources_[i].m_image.m_imageView = transients.m_imageViews[i];
+			}
+		}
+
+		for (auto &compiledPass: graph.m_passes) {
+			auto &pass = m_passes_[compiledPass.m_pass];
+			recordBarriers(commandBuffer, compiledPass.m_barriers);
+			if (pass.m_type == PassType::Raster) {
+				beginPass(commandBuffer, compiledPass, pass);
+				pass.m_execute(commandBuffer);
+				endPass(commandBuffer, compiledPass);
+			} else {
+				pass.m_execute(commandBuffer);
+			}
+		}
+		recordBarriers(commandBuffer, graph.m_finalBarriers);
+
+		// Graphs of a topology that is no longer declared, e.g. from before a resize
+		for (auto it = m_compiledGraphs_.begin(); it != m_compiledGraphs_.end();) {
+			if (m_frameCount_ - it->second.m_lastUsedFrame > evictAfterFrames) {
+				destroy(it->second);
+				it = m_compiledGraphs_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		m_frameCount_++;
+	}
+
+	void LveRenderGraph::destroy(CompiledGraph &graph) {
+		VkDevice device = m_lveDevice_.device();
+		for (auto &compiledPass: graph.m_passes) {
+			for (auto &[views, framebuffer]: compiledPass.m_framebuffers) {
+				vkDestroyFramebuffer(device, framebuffer, nullptr);
+			}
+			vkDestroyRenderPass(device, compiledPass.m_renderPass, nullptr);
+		}
+		for (auto &frame: graph.m_transients) {
+			for (auto imageView: frame.m_imageViews) {
+				vkDestroyImageView(device, imageView, nullptr);
+			}
+			for (auto image: frame.m_images) {
+				vkDestroyImage(device, image, nullptr);
+			}
+			for (auto memory: frame.m_memory) {
+				vkFreeMemory(device, memory, nullptr);
+			}
+		}
+	}
+
+	void LveRenderGraph::reset() {
+		for (auto &[key, graph]: m_compiledGraphs_) {
+			destroy(graph);
+		}
+		m_compiledGraphs_.clear();
+	}
+}
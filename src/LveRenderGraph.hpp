@@ -0,0 +1,244 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVERENDERGRAPH_HPP
+#define VULKAN_TEST_LVERENDERGRAPH_HPP
+
+#include "LveDevice.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	// Index of an image or buffer declared in the current frame of an LveRenderGraph
+	using RenderGraphResource = uint32_t;
+
+	struct RenderGraphImageInfo {
+		VkImage m_image = VK_NULL_HANDLE;
+		VkImageView m_imageView = VK_NULL_HANDLE;
+		VkFormat m_format = VK_FORMAT_UNDEFINED;
+		VkExtent2D m_extent{0, 0};
+	};
+
+	class LveRenderGraph;
+
+	// Declares what a pass reads and writes; the graph derives the barriers and layout transitions from it
+	class RenderGraphPassBuilder {
+	public:
+		// Attachments of a raster pass, which all have to be of the same extent. Color attachments are bound
+		// in the order they are declared.
+		RenderGraphPassBuilder &colorAttachment(RenderGraphResource image,
+		                                        VkAttachmentLoadOp loadOp,
+		                                        VkClearColorValue clearValue = {{0.f, 0.f, 0.f, 1.f}});
+
+		RenderGraphPassBuilder &depthAttachment(RenderGraphResource image,
+		                                        VkAttachmentLoadOp loadOp,
+		                                        VkClearDepthStencilValue clearValue = {1.f, 0});
+
+		// Read through a sampler. Depth formats are read in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL and
+		// color formats in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL unless another layout is given.
+		RenderGraphPassBuilder &sampledImage(RenderGraphResource image,
+		                                     VkPipelineStageFlags stages,
+		                                     VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+
+		RenderGraphPassBuilder &storageImage(RenderGraphResource image, VkPipelineStageFlags stages, bool write);
+
+		// Source of a copy or blit, in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+		RenderGraphPassBuilder &transferSource(RenderGraphResource image);
+
+		RenderGraphPassBuilder &readBuffer(RenderGraphResource buffer, VkPipelineStageFlags stages, VkAccessFlags access);
+
+		RenderGraphPassBuilder &writeBuffer(RenderGraphResource buffer, VkPipelineStageFlags stages,
+		                                    VkAccessFlags access);
+
+		// Keeps the pass even when nothing in the graph reads what it writes
+		RenderGraphPassBuilder &sideEffect();
+
+	private:
+		friend class LveRenderGraph;
+
+		RenderGraphPassBuilder(LveRenderGraph &graph, uint32_t pass) : m_graph_{graph}, m_pass_{pass} {}
+
+		LveRenderGraph &m_graph_;
+		uint32_t m_pass_;
+	};
+
+	// Records the passes of a frame. Passes are declared every frame with the resources they access; the
+	// graph culls passes whose results are never used, inserts the pipeline barriers and layout transitions
+	// between them, and allocates transient images, aliasing the memory of images whose lifetimes do not
+	// overlap. The compiled form of a graph is cached and reused for as long as the declared topology stays
+	// the same, only the imported handles are allowed to change from frame to frame.
+	//
+	// Raster passes are rendered with dynamic rendering when the device supports it, otherwise the graph
+	// creates compatible render passes and framebuffers.
+	class LveRenderGraph {
+	public:
+		enum class PassType {
+			Raster,
+			Compute,
+			Transfer,
+		};
+
+		explicit LveRenderGraph(LveDevice &device);
+
+		~LveRenderGraph();
+
+		LveRenderGraph(const LveRenderGraph &) = delete;
+
+		LveRenderGraph &operator=(const LveRenderGraph &) = delete;
+
+		// Starts declaring the passes of frameIndex; the previous use of frameIndex must have completed
+		void beginFrame(int frameIndex);
+
+		// An image owned outside the graph, in initialLayout when the frame starts. It is left in finalLayout,
+		// or in the layout of its last use when finalLayout is VK_IMAGE_LAYOUT_UNDEFINED. priorStages and
+		// priorAccess describe the last write to it before the graph runs, such as one from an earlier frame;
+		// the first use in the graph waits for it even when it only reads.
+		RenderGraphResource importImage(const std::string &name,
+		                                const RenderGraphImageInfo &info,
+		                                VkImageLayout initialLayout,
+		                                VkImageLayout finalLayout,
+		                                VkPipelineStageFlags priorStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                                VkAccessFlags priorAccess = VK_ACCESS_MEMORY_WRITE_BIT);
+
+		RenderGraphResource importBuffer(const std::string &name,
+		                                 VkBuffer buffer,
+		                                 VkPipelineStageFlags priorStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		                                 VkAccessFlags priorAccess = VK_ACCESS_MEMORY_WRITE_BIT);
+
+		// An image that only lives within the frame; its contents are undefined at its first use
+		RenderGraphResource createImage(const std::string &name, VkFormat format, VkExtent2D extent);
+
+		// setup declares the accesses of the pass right away, execute records its commands during execute()
+		void addPass(const std::string &name,
+		             PassType type,
+		             const std::function<void(RenderGraphPassBuilder &)> &setup,
+		             std::function<void(VkCommandBuffer)> execute);
+
+		// Valid for imported images, and for transient images while the graph executes
+		const RenderGraphImageInfo &getImage(RenderGraphResource image) const;
+
+		VkBuffer getBuffer(RenderGraphResource buffer) const;
+
+		// Records the passes declared since beginFrame
+		void execute(VkCommandBuffer commandBuffer);
+
+		// Destroys every cached graph; the device must be idle. Needed when imported images are recreated,
+		// since framebuffers refer to their views.
+		void reset();
+
+		uint32_t getCachedGraphCount() const { return static_cast<uint32_t>(m_compiledGraphs_.size()); }
+
+	private:
+		friend class RenderGraphPassBuilder;
+
+		struct Access {
+			RenderGraphResource m_resource;
+			VkImageLayout m_layout;
+			VkPipelineStageFlags m_stages;
+			VkAccessFlags m_access;
+			VkImageUsageFlags m_usage;
+			bool m_write;
+			// Attachments only
+			bool m_attachment;
+			VkAttachmentLoadOp m_loadOp;
+			VkClearValue m_clearValue;
+		};
+
+		struct Resource {
+			std::string m_name;
+			bool m_buffer;
+			bool m_imported;
+			RenderGraphImageInfo m_image;
+			VkBuffer m_bufferHandle;
+			VkImageLayout m_initialLayout;
+			VkImageLayout m_finalLayout;
+			// Last write before the graph, imported resources only
+			VkPipelineStageFlags m_priorStages;
+			VkAccessFlags m_priorAccess;
+		};
+
+		struct Pass {
+			std::string m_name;
+			PassType m_type;
+			bool m_sideEffect;
+			std::vector<Access> m_accesses;
+			std::function<void(VkCommandBuffer)> m_execute;
+		};
+
+		struct Barrier {
+			RenderGraphResource m_resource;
+			VkImageLayout m_oldLayout;
+			VkImageLayout m_newLayout;
+			VkPipelineStageFlags m_srcStages;
+			VkAccessFlags m_srcAccess;
+			VkPipelineStageFlags m_dstStages;
+			VkAccessFlags m_dstAccess;
+		};
+
+		struct CompiledPass {
+			uint32_t m_pass;
+			std::vector<Barrier> m_barriers;
+			// Without dynamic rendering
+			VkRenderPass m_renderPass = VK_NULL_HANDLE;
+			std::map<std::vector<VkImageView>, VkFramebuffer> m_framebuffers;
+		};
+
+		struct TransientFrame {
+			std::vector<VkImage> m_images;
+			std::vector<VkImageView> m_imageViews;
+			std::vector<VkDeviceMemory> m_memory;
+		};
+
+		struct CompiledGraph {
+			std::vector<CompiledPass> m_passes;
+			std::vector<Barrier> m_finalBarriers;
+			// Indexed by frame in flight, then by resource; imported resources have no image
+			std::vector<TransientFrame> m_transients;
+			uint64_t m_lastUsedFrame = 0;
+		};
+
+		// A graph is compared by its full topology, encoded as words
+		using Key = std::vector<uint64_t>;
+
+		Key topologyKey() const;
+
+		CompiledGraph compile();
+
+		std::vector<bool> cullPasses() const;
+
+		void allocateTransients(CompiledGraph &graph,
+		                        const std::vector<uint32_t> &firstUse,
+		                        const std::vector<uint32_t> &lastUse,
+		                        std::vector<RenderGraphResource> &aliasPredecessor);
+
+		VkRenderPass createRenderPass(const Pass &pass) const;
+
+		VkFramebuffer getFramebuffer(CompiledPass &compiledPass, const Pass &pass, VkExtent2D extent);
+
+		void recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> &barriers) const;
+
+		void beginPass(VkCommandBuffer commandBuffer, CompiledPass &compiledPass, const Pass &pass);
+
+		void endPass(VkCommandBuffer commandBuffer, const CompiledPass &compiledPass) const;
+
+		void destroy(CompiledGraph &graph);
+
+		Access &addAccess(uint32_t pass, RenderGraphResource resource);
+
+		LveDevice &m_lveDevice_;
+		int m_frameIndex_ = 0;
+		uint64_t m_frameCount_ = 0;
+		std::vector<Resource> m_resources_;
+		std::vector<Pass> m_passes_;
+		std::map<Key, CompiledGraph> m_compiledGraphs_;
+	};
+}
+
+#endif //VULKAN_TEST_LVERENDERGRAPH_HPP
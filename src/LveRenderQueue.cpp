@@ -0,0 +1,22 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveRenderQueue.hpp"
+
+namespace lve {
+
+	uint64_t LveRenderQueue::makeKey(uint32_t pipeline, uint32_t material, uint32_t model, float viewDepth) {
+		return (static_cast<uint64_t>(pipeline & 0xFFu) << 56) |
+		       (static_cast<uint64_t>(material & 0xFFFFu) << 40) |
+		       (static_cast<uint64_t>(model & 0xFFFFu) << 24) |
+		       static_cast<uint64_t>(floatToSortKey(viewDepth) >> 8);
+	}
+
+	uint64_t LveRenderQueue::makeTransparentKey(uint32_t pipeline, uint32_t material, uint32_t model, float viewDepth) {
+		return (static_cast<uint64_t>(~floatToSortKey(viewDepth)) << 32) |
+		       (static_cast<uint64_t>(pipeline & 0xFFu) << 24) |
+		       (static_cast<uint64_t>(material & 0xFFFFu) << 8) |
+		       static_cast<uint64_t>(model & 0xFFu);
+	}
+}
@@ -0,0 +1,50 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVERENDERQUEUE_HPP
+#define VULKAN_TEST_LVERENDERQUEUE_HPP
+
+#include "LveRadixSort.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Number of state changes recorded in a frame, reset by the render system each frame
+	struct RenderStats {
+		uint32_t m_pipelineBinds = 0;
+		uint32_t m_vertexBufferBinds = 0;
+		uint32_t m_draws = 0;
+	};
+
+	// Collects visible draws with a sort key and orders them so that draws sharing a pipeline, material and
+	// model end up next to each other, letting the recorder skip redundant binds.
+	class LveRenderQueue {
+	public:
+		// Opaque draws, most significant first: pipeline (8 bits), material (16 bits), model (16 bits) and
+		// view depth (24 bits), so draws within a model are ordered front to back for early depth rejection.
+		static uint64_t makeKey(uint32_t pipeline, uint32_t material, uint32_t model, float viewDepth);
+
+		// Blended draws have to be ordered back to front regardless of state, so the inverted view depth
+		// (32 bits) comes first, followed by pipeline (8 bits), material (16 bits) and model (8 bits).
+		static uint64_t makeTransparentKey(uint32_t pipeline, uint32_t material, uint32_t model, float viewDepth);
+
+		void clear() { m_items_.clear(); }
+
+		void push(uint64_t key, uint32_t index) { m_items_.push_back({key, index}); }
+
+		// Large queues are sorted on jobSystem when one is given
+		void sort(LveJobSystem *jobSystem = nullptr) { radixSort(m_items_, m_scratch_, 64, jobSystem); }
+
+		const std::vector<SortItem> &items() const { return m_items_; }
+
+	private:
+		std::vector<SortItem> m_items_;
+		std::vector<SortItem> m_scratch_;
+	};
+}
+
+#endif //VULKAN_TEST_LVERENDERQUEUE_HPP
@@ -4,6 +4,10 @@
 
 #include "LveRenderer.hpp"
 
+// std
+#include <chrono>
+#include <thread>
+
 namespace lve {
 
 	LveRenderer::LveRenderer(LveWindow &window, LveDevice &mLveDevice) : m_lveWindow_(window),
@@ -44,6 +48,14 @@ namespace lve {
 #ifndef NDEBUG
 		assert(!m_isFrameStarted_ && "Can't call beginFrame while already in progress");
 #endif
+		if (m_swapChainOutOfDate_) {
+			recreateSwapChain();
+			if (m_swapChainOutOfDate_) {
+				// Nothing can be presented while the window is minimized, so don't spin on it
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				return nullptr;
+			}
+		}
 		auto result = m_lveSwapChain_->acquireNextImage(&m_currentImageIndex_);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -56,6 +68,9 @@ namespace lve {
 		}
 
 		m_isFrameStarted_ = true;
+		// acquireNextImage waited on this frame's fence
+		m_deletionQueue_.beginFrame(m_currentFrameIndex_);
+		m_renderGraph_.beginFrame(m_currentFrameIndex_);
 
 		auto commandBuffer = getCurrentCommandBuffer();
 
@@ -74,6 +89,7 @@ namespace lve {
 		assert(m_isFrameStarted_ && "Can't call endFrame while frame is not in progress");
 #endif
 		auto commandBuffer = getCurrentCommandBuffer();
+		m_renderGraph_.execute(commandBuffer);
 
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to record command buffer");
@@ -91,61 +107,43 @@ namespace lve {
 		m_currentFrameIndex_ = (m_currentFrameIndex_ + 1) % LveSwapChain::m_maxFramesInFlight;
 	}
 
-	void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
-#ifndef NDEBUG
-		assert(m_isFrameStarted_ && "Can't call beginSwapChainRenderPass if frame is not in progress");
-		assert(
-				commandBuffer == getCurrentCommandBuffer() &&
-				"Can't begin render pass on command buffer from a different frame"
-		);
-#endif
-		VkRenderPassBeginInfo renderPassInfo{};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = m_lveSwapChain_->getRenderPass();
-		renderPassInfo.framebuffer = m_lveSwapChain_->getFrameBuffer(m_currentImageIndex_);
-
-		renderPassInfo.renderArea.offset = {0, 0};
-		renderPassInfo.renderArea.extent = m_lveSwapChain_->getSwapChainExtent();
-
-		std::array<VkClearValue, 2> clearValues{};
-		clearValues[0].color = {0.01f, 0.01f, 0.01f, 1.0f};
-		clearValues[1].depthStencil = {1.0f, 0};
-		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassInfo.pClearValues = clearValues.data();
-
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(m_lveSwapChain_->getSwapChainExtent().width);
-		viewport.height = static_cast<float>(m_lveSwapChain_->getSwapChainExtent().height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		VkRect2D scissor{{0, 0}, m_lveSwapChain_->getSwapChainExtent()};
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-	}
-
-	void LveRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+	LveRenderer::SwapChainTargets LveRenderer::importSwapChainTargets() {
 #ifndef NDEBUG
-		assert(m_isFrameStarted_ && "Can't call endSwapChainRenderPass if frame is not in progress");
-		assert(
-				commandBuffer == getCurrentCommandBuffer() &&
-				"Can't end render pass on command buffer from a different frame"
-		);
+		assert(m_isFrameStarted_ && "Can't call importSwapChainTargets if frame is not in progress");
 #endif
-		vkCmdEndRenderPass(commandBuffer);
+		auto imageIndex = static_cast<int>(m_currentImageIndex_);
+		auto depth = m_lveSwapChain_->getDepthAttachment(imageIndex);
+
+		// Neither image is expected to keep contents from an earlier frame. Offscreen images are not
+		// presented and stay in the layout of their last use.
+		SwapChainTargets targets{};
+		targets.m_color = m_renderGraph_.importImage("swap chain color",
+		                                             {m_lveSwapChain_->getImage(imageIndex),
+		                                              m_lveSwapChain_->getImageView(imageIndex),
+		                                              m_lveSwapChain_->getSwapChainImageFormat(),
+		                                              m_lveSwapChain_->getSwapChainExtent()},
+		                                             VK_IMAGE_LAYOUT_UNDEFINED,
+		                                             m_lveSwapChain_->isOffscreen() ? VK_IMAGE_LAYOUT_UNDEFINED
+		                                                                            : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		targets.m_depth = m_renderGraph_.importImage("swap chain depth",
+		                                             {depth.m_image, depth.m_imageView, depth.m_format, depth.m_extent},
+		                                             VK_IMAGE_LAYOUT_UNDEFINED,
+		                                             VK_IMAGE_LAYOUT_UNDEFINED);
+		return targets;
 	}
 
 	void LveRenderer::recreateSwapChain() {
+		// Frames may be recorded on another thread than the one polling events, so a minimized window is
+		// not waited for here; beginFrame() tries again until it has a size
 		auto extent = m_lveWindow_.getExtent();
-		while (extent.width == 0 || extent.height == 0) {
-			extent = m_lveWindow_.getExtent();
-			glfwWaitEvents();
+		if (m_lveSwapChain_ != nullptr && (extent.width == 0 || extent.height == 0)) {
+			m_swapChainOutOfDate_ = true;
+			return;
 		}
+		m_swapChainOutOfDate_ = false;
 		vkDeviceWaitIdle(m_lveDevice_.device());
+		// Cached framebuffers refer to the old swap chain's image views
+		m_renderGraph_.reset();
 
 		if (m_lveSwapChain_ == nullptr) {
 			m_lveSwapChain_ = std::make_unique<LveSwapChain>(m_lveDevice_, extent);
@@ -7,11 +7,13 @@
 
 
 #include "LveWindow.hpp"
+#include "LveDeletionQueue.hpp"
 #include "LvePipeline.hpp"
 #include "LveGameObject.hpp"
 #include "LveDevice.hpp"
 #include "LveSwapChain.hpp"
 #include "LveModel.hpp"
+#include "LveRenderGraph.hpp"
 
 #include <memory>
 #include <vector>
@@ -29,7 +31,12 @@ namespace lve {
 
 		LveRenderer &operator=(const LveRenderer &) = delete;
 
-		VkRenderPass getSwapChainRenderPass() const { return m_lveSwapChain_->getRenderPass(); }
+		// With dynamic rendering pipelines only depend on the swap chain formats, which recreation keeps
+		RenderTargetInfo getSwapChainRenderTarget() const {
+			return {m_lveSwapChain_->getRenderPass(),
+			        {m_lveSwapChain_->getSwapChainImageFormat()},
+			        m_lveSwapChain_->getSwapChainDepthFormat()};
+		}
 
 		float getAspectRatio() const { return m_lveSwapChain_->extentAspectRatio(); };
 
@@ -46,9 +53,22 @@ namespace lve {
 
 		void endFrame();
 
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// The graph of the current frame; its passes are recorded by endFrame
+		LveRenderGraph &getRenderGraph() { return m_renderGraph_; }
+
+		struct SwapChainTargets {
+			RenderGraphResource m_color;
+			RenderGraphResource m_depth;
+		};
+
+		// Imports the acquired swap chain image, which is presented after the graph, and its depth buffer
+		SwapChainTargets importSwapChainTargets();
+
+		// Whether the imported swap chain color can be read back with transferSource()
+		bool isSwapChainTransferSource() const { return m_lveSwapChain_->isTransferSource(); }
 
-		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// Objects retired here are destroyed once the frames in flight that may use them have completed
+		LveDeletionQueue &getDeletionQueue() { return m_deletionQueue_; }
 
 		int getFrameIndex() const {
 #ifndef DEBUG
@@ -69,10 +89,14 @@ namespace lve {
 		LveDevice &m_lveDevice_;
 		std::unique_ptr<LveSwapChain> m_lveSwapChain_;
 		std::vector<VkCommandBuffer> m_commandBuffers_;
+		LveDeletionQueue m_deletionQueue_;
+		LveRenderGraph m_renderGraph_{m_lveDevice_};
 
 		uint32_t m_currentImageIndex_;
 		int m_currentFrameIndex_ = 0;
 		bool m_isFrameStarted_{false};
+		// The window was minimized when the swap chain had to be recreated
+		bool m_swapChainOutOfDate_{false};
 	};
 }
 
@@ -0,0 +1,193 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveSceneGraph.hpp"
+
+// std
+#include <stdexcept>
+
+namespace lve {
+
+	SceneNode LveSceneGraph::createNode(SceneNode parent, const TransformComponent &transform) {
+		SceneNode node;
+		if (!m_freeNodes_.empty()) {
+			node = m_freeNodes_.back();
+			m_freeNodes_.pop_back();
+		} else {
+			node = static_cast<SceneNode>(m_nodeOrder_.size());
+			m_nodeOrder_.push_back(m_invalidNode);
+		}
+
+		m_nodeOrder_[node] = static_cast<uint32_t>(m_orderNodes_.size());
+		m_orderNodes_.push_back(node);
+		m_parents_.push_back(parent == m_invalidNode ? m_noParent : m_nodeOrder_[parent]);
+		m_localTransforms_.push_back(transform);
+		m_worldMatrices_.emplace_back(1.f);
+		m_localDirty_.push_back(1);
+		m_updatedIn_.push_back(0);
+		m_nodeCount_++;
+		m_orderDirty_ = true;
+		m_anyDirty_ = true;
+		return node;
+	}
+
+	void LveSceneGraph::destroyNode(SceneNode node) {
+		// Descendants become unreachable and are released when the order is rebuilt
+		m_orderNodes_[m_nodeOrder_[node]] = m_invalidNode;
+		m_nodeOrder_[node] = m_invalidNode;
+		m_freeNodes_.push_back(node);
+		m_nodeCount_--;
+		m_orderDirty_ = true;
+	}
+
+	void LveSceneGraph::setParent(SceneNode node, SceneNode parent) {
+		const uint32_t order = m_nodeOrder_[node];
+		if (parent != m_invalidNode) {
+			for (uint32_t ancestor = m_nodeOrder_[parent]; ancestor != m_noParent; ancestor = m_parents_[ancestor]) {
+				if (ancestor == order) {
+					throw std::runtime_error("A scene node cannot be parented to its own subtree");
+				}
+			}
+		}
+
+		m_parents_[order] = parent == m_invalidNode ? m_noParent : m_nodeOrder_[parent];
+		m_localDirty_[order] = 1;
+		m_orderDirty_ = true;
+		m_anyDirty_ = true;
+	}
+
+	SceneNode LveSceneGraph::getParent(SceneNode node) const {
+		const uint32_t parent = m_parents_[m_nodeOrder_[node]];
+		return parent == m_noParent ? m_invalidNode : m_orderNodes_[parent];
+	}
+
+	void LveSceneGraph::setLocalTransform(SceneNode node, const TransformComponent &transform) {
+		const uint32_t order = m_nodeOrder_[node];
+		if (m_localTransforms_[order] == transform) {
+			return;
+		}
+		m_localTransforms_[order] = transform;
+		m_localDirty_[order] = 1;
+		m_anyDirty_ = true;
+	}
+
+	void LveSceneGraph::rebuildOrder() {
+		const auto count = static_cast<uint32_t>(m_orderNodes_.size());
+
+		// Children of every position, grouped by parent in the current order
+		std::vector<uint32_t> childOffsets(count + 1, 0);
+		std::vector<uint32_t> roots;
+		for (uint32_t i = 0; i < count; i++) {
+			if (m_orderNodes_[i] == m_invalidNode) {
+				continue;
+			}
+			if (m_parents_[i] == m_noParent) {
+				roots.push_back(i);
+			} else {
+				childOffsets[m_parents_[i] + 1]++;
+			}
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			childOffsets[i + 1] += childOffsets[i];
+		}
+		std::vector<uint32_t> children(childOffsets[count]);
+		std::vector<uint32_t> cursor(childOffsets.begin(), childOffsets.end() - 1);
+		for (uint32_t i = 0; i < count; i++) {
+			if (m_orderNodes_[i] != m_invalidNode && m_parents_[i] != m_noParent) {
+				children[cursor[m_parents_[i]]++] = i;
+			}
+		}
+
+		// Breadth-first from the roots; nodes below destroyed ones are never reached
+		std::vector<uint32_t> order = std::move(roots);
+		order.reserve(m_nodeCount_);
+		m_levelOffsets_.assign(1, 0);
+		for (uint32_t levelBegin = 0; levelBegin < order.size();) {
+			const auto levelEnd = static_cast<uint32_t>(order.size());
+			for (uint32_t i = levelBegin; i < levelEnd; i++) {
+				const uint32_t parent = order[i];
+				for (uint32_t child = childOffsets[parent]; child < childOffsets[parent + 1]; child++) {
+					order.push_back(children[child]);
+				}
+			}
+			m_levelOffsets_.push_back(levelEnd);
+			levelBegin = levelEnd;
+		}
+
+		std::vector<uint32_t> newPosition(count, m_noParent);
+		for (uint32_t i = 0; i < order.size(); i++) {
+			newPosition[order[i]] = i;
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			if (m_orderNodes_[i] != m_invalidNode && newPosition[i] == m_noParent) {
+				m_nodeOrder_[m_orderNodes_[i]] = m_invalidNode;
+				m_freeNodes_.push_back(m_orderNodes_[i]);
+				m_nodeCount_--;
+			}
+		}
+
+		std::vector<SceneNode> orderNodes(order.size());
+		std::vector<uint32_t> parents(order.size());
+		std::vector<TransformComponent> localTransforms(order.size());
+		std::vector<glm::mat4> worldMatrices(order.size());
+		std::vector<uint8_t> localDirty(order.size());
+		std::vector<uint64_t> updatedIn(order.size());
+		for (uint32_t i = 0; i < order.size(); i++) {
+			const uint32_t old = order[i];
+			orderNodes[i] = m_orderNodes_[old];
+			parents[i] = m_parents_[old] == m_noParent ? m_noParent : newPosition[m_parents_[old]];
+			localTransforms[i] = m_localTransforms_[old];
+			worldMatrices[i] = m_worldMatrices_[old];
+			localDirty[i] = m_localDirty_[old];
+			updatedIn[i] = m_updatedIn_[old];
+			m_nodeOrder_[orderNodes[i]] = i;
+		}
+		m_orderNodes_ = std::move(orderNodes);
+		m_parents_ = std::move(parents);
+		m_localTransforms_ = std::move(localTransforms);
+		m_worldMatrices_ = std::move(worldMatrices);
+		m_localDirty_ = std::move(localDirty);
+		m_updatedIn_ = std::move(updatedIn);
+		m_orderDirty_ = false;
+	}
+
+	void LveSceneGraph::update() {
+		if (m_orderDirty_) {
+			rebuildOrder();
+		}
+		if (!m_anyDirty_) {
+			return;
+		}
+		m_updateCount_++;
+		for (size_t level = 0; level + 1 < m_levelOffsets_.size(); level++) {
+			updateLevel(m_levelOffsets_[level], m_levelOffsets_[level + 1]);
+		}
+		m_anyDirty_ = false;
+	}
+
+	void LveSceneGraph::updateLevel(uint32_t begin, uint32_t end) {
+		if (!m_jobSystem_) {
+			updateRange(begin, end);
+			return;
+		}
+		// Returns once every range is done, which the next level relies on to read these world matrices
+		m_jobSystem_->parallelFor(end - begin, m_chunkSize, [this, begin](uint32_t rangeBegin, uint32_t rangeEnd) {
+			updateRange(begin + rangeBegin, begin + rangeEnd);
+		});
+	}
+
+	void LveSceneGraph::updateRange(uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const uint32_t parent = m_parents_[i];
+			const bool parentChanged = parent != m_noParent && m_updatedIn_[parent] == m_updateCount_;
+			if (!m_localDirty_[i] && !parentChanged) {
+				continue;
+			}
+			const glm::mat4 local = m_localTransforms_[i].mat4();
+			m_worldMatrices_[i] = parent == m_noParent ? local : m_worldMatrices_[parent] * local;
+			m_localDirty_[i] = 0;
+			m_updatedIn_[i] = m_updateCount_;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVESCENEGRAPH_HPP
+#define VULKAN_TEST_LVESCENEGRAPH_HPP
+
+#include "LveJobSystem.hpp"
+#include "LveTransform.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Stable id of a node in an LveSceneGraph
+	using SceneNode = uint32_t;
+
+	// Parent/child hierarchy of transforms. Nodes are kept in breadth-first order in contiguous arrays, so
+	// world matrices are computed in one linear pass per depth level, every parent before its children.
+	// Large levels are split across the threads of the job system. Only nodes whose local transform changed, and their
+	// descendants, are recomputed.
+	//
+	// Structural changes reorder the arrays on the next update(); node ids stay valid throughout.
+	class LveSceneGraph {
+	public:
+		static constexpr SceneNode m_invalidNode = ~0u;
+
+		// Updates run on the calling thread alone without jobSystem
+		explicit LveSceneGraph(LveJobSystem *jobSystem = nullptr) : m_jobSystem_{jobSystem} {}
+
+		LveSceneGraph(const LveSceneGraph &) = delete;
+
+		LveSceneGraph &operator=(const LveSceneGraph &) = delete;
+
+		// A root when parent is m_invalidNode
+		SceneNode createNode(SceneNode parent = m_invalidNode, const TransformComponent &transform = {});
+
+		// Destroys node and all of its descendants
+		void destroyNode(SceneNode node);
+
+		// The local transform is kept, so the node moves along with its new parent. Throws when parent is
+		// node itself or one of its descendants.
+		void setParent(SceneNode node, SceneNode parent);
+
+		SceneNode getParent(SceneNode node) const;
+
+		// Only marks the node dirty when transform differs from its current one
+		void setLocalTransform(SceneNode node, const TransformComponent &transform);
+
+		const TransformComponent &getLocalTransform(SceneNode node) const {
+			return m_localTransforms_[m_nodeOrder_[node]];
+		}
+
+		// As of the last update()
+		const glm::mat4 &getWorldMatrix(SceneNode node) const { return m_worldMatrices_[m_nodeOrder_[node]]; }
+
+		void update();
+
+		uint32_t getNodeCount() const { return m_nodeCount_; }
+
+		// Number of levels after the last update()
+		uint32_t getDepth() const {
+			return m_levelOffsets_.empty() ? 0 : static_cast<uint32_t>(m_levelOffsets_.size() - 1);
+		}
+
+	private:
+		static constexpr uint32_t m_noParent = ~0u;
+		// Nodes per job when a level is split across threads
+		static constexpr uint32_t m_chunkSize = 2048;
+
+		void rebuildOrder();
+
+		void updateLevel(uint32_t begin, uint32_t end);
+
+		void updateRange(uint32_t begin, uint32_t end);
+
+		LveJobSystem *m_jobSystem_;
+
+		// Indexed by node id; m_invalidNode for free ids
+		std::vector<uint32_t> m_nodeOrder_;
+		std::vector<SceneNode> m_freeNodes_;
+		uint32_t m_nodeCount_ = 0;
+
+		// Indexed by position in breadth-first order. Nodes created since the last update() are appended,
+		// destroyed ones are left as holes until the order is rebuilt.
+		std::vector<SceneNode> m_orderNodes_;
+		std::vector<uint32_t> m_parents_;
+		std::vector<TransformComponent> m_localTransforms_;
+		std::vector<glm::mat4> m_worldMatrices_;
+		std::vector<uint8_t> m_localDirty_;
+		// update() during which the world matrix was last recomputed
+		std::vector<uint64_t> m_updatedIn_;
+		// Start of every level, followed by the end of the last one
+		std::vector<uint32_t> m_levelOffsets_;
+		bool m_orderDirty_ = false;
+		bool m_anyDirty_ = false;
+		uint64_t m_updateCount_ = 0;
+	};
+}
+
+#endif //VULKAN_TEST_LVESCENEGRAPH_HPP
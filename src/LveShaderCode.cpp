@@ -0,0 +1,70 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveShaderCode.hpp"
+#include "LvePipeline.hpp"
+
+// std
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lve {
+
+	namespace {
+		std::mutex overrideMutex;
+		// Shader name to the file it was recompiled to
+		std::unordered_map<std::string, std::string> diskOverrides;
+	}
+
+	LveShaderCode LveShaderCode::load(const std::string &filePath) {
+		LveShaderCode code{};
+
+		std::string diskPath;
+		{
+			std::lock_guard<std::mutex> lock{overrideMutex};
+			auto it = diskOverrides.find(std::string{shaderName(filePath)});
+			if (it != diskOverrides.end()) {
+				diskPath = it->second;
+			}
+		}
+		if (diskPath.empty()) {
+			if (const auto *embedded = findEmbedded(filePath)) {
+				code.m_embedded_ = embedded->m_words;
+				code.m_embeddedWordCount_ = embedded->m_wordCount;
+				return code;
+			}
+			diskPath = filePath;
+		}
+
+		auto bytes = LvePipeline::readFile(diskPath);
+		if (bytes.empty() || bytes.size() % sizeof(uint32_t) != 0) {
+			throw std::runtime_error("Invalid SPIR-V file: " + diskPath);
+		}
+		code.m_storage_.resize(bytes.size() / sizeof(uint32_t));
+		std::memcpy(code.m_storage_.data(), bytes.data(), bytes.size());
+		return code;
+	}
+
+	void LveShaderCode::overrideFromDisk(const std::string &shaderName, const std::string &diskPath) {
+		std::lock_guard<std::mutex> lock{overrideMutex};
+		diskOverrides[shaderName] = diskPath;
+	}
+
+	std::string_view LveShaderCode::shaderName(std::string_view filePath) {
+		auto separator = filePath.find_last_of("/\\");
+		return separator == std::string_view::npos ? filePath : filePath.substr(separator + 1);
+	}
+
+	const EmbeddedShader *LveShaderCode::findEmbedded(std::string_view filePath) {
+		// A handful of shaders, a linear scan is cheaper than building an index
+		for (const auto *shader = embeddedShaders; shader->m_name; shader++) {
+			if (filePath == shader->m_name) {
+				return shader;
+			}
+		}
+		return nullptr;
+	}
+}
@@ -0,0 +1,58 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVESHADERCODE_HPP
+#define VULKAN_TEST_LVESHADERCODE_HPP
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lve {
+
+	// A SPIR-V module compiled into the binary by cmake/EmbedShaders.cmake
+	struct EmbeddedShader {
+		const char *m_name;
+		const uint32_t *m_words;
+		size_t m_wordCount;
+	};
+
+	// Defined in the generated source, terminated by an entry without a name
+	extern const EmbeddedShader embeddedShaders[];
+
+	// The words of a SPIR-V module. Embedded shaders are used in place without any file I/O, shaders read
+	// from disk are owned by this object.
+	class LveShaderCode {
+	public:
+		// Shaders are looked up by the path they are compiled to relative to the build directory, e.g.
+		// "src/shaders/simple_vertex.vert.spv". Paths that are not embedded are read from disk relative to the
+		// working directory, overridden shaders from the path they were overridden with.
+		static LveShaderCode load(const std::string &filePath);
+
+		// Makes later loads of any path naming shaderName read diskPath instead, for shaders recompiled while
+		// running
+		static void overrideFromDisk(const std::string &shaderName, const std::string &diskPath);
+
+		// The file name a shader path is matched by on reloads, e.g. "simple_vertex.vert.spv"
+		static std::string_view shaderName(std::string_view filePath);
+
+		static const EmbeddedShader *findEmbedded(std::string_view filePath);
+
+		const uint32_t *data() const { return m_storage_.empty() ? m_embedded_ : m_storage_.data(); }
+
+		size_t wordCount() const { return m_storage_.empty() ? m_embeddedWordCount_ : m_storage_.size(); }
+
+		size_t sizeInBytes() const { return wordCount() * sizeof(uint32_t); }
+
+	private:
+		const uint32_t *m_embedded_ = nullptr;
+		size_t m_embeddedWordCount_ = 0;
+		std::vector<uint32_t> m_storage_;
+	};
+}
+
+#endif //VULKAN_TEST_LVESHADERCODE_HPP
@@ -0,0 +1,122 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveShaderModuleCache.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+	LveShaderModuleCache::LveShaderModuleCache(VkDevice device, bool inlineShaderModules)
+			: m_device_{device}, m_inlineShaderModules_{inlineShaderModules} {}
+
+	LveShaderModuleCache::~LveShaderModuleCache() {
+		for (auto &[hash, entry]: m_entries_) {
+#ifndef NDEBUG
+			assert(entry.m_refCount == 0 && "Shader module cache destroyed while a module is in use");
+#endif
+			vkDestroyShaderModule(m_device_, entry.m_module, nullptr);
+		}
+	}
+
+	uint64_t LveShaderModuleCache::hash(const LveShaderCode &code) {
+		// FNV-1a over the words
+		uint64_t hash = 14695981039346656037ull;
+		const uint32_t *words = code.data();
+		for (size_t i = 0; i < code.wordCount(); i++) {
+			hash ^= words[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	VkShaderModule LveShaderModuleCache::acquire(const LveShaderCode &code) {
+		uint64_t key = hash(code);
+
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		auto [begin, end] = m_entries_.equal_range(key);
+		for (auto it = begin; it != end; ++it) {
+			auto &entry = it->second;
+			if (entry.m_words.size() == code.wordCount() &&
+			    std::equal(entry.m_words.begin(), entry.m_words.end(), code.data())) {
+				entry.m_refCount++;
+				return entry.m_module;
+			}
+		}
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.sizeInBytes();
+		createInfo.pCode = code.data();
+
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(m_device_, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create shader module");
+		}
+
+		m_entries_.emplace(key, Entry{{code.data(), code.data() + code.wordCount()}, shaderModule, 1});
+		m_moduleHashes_.emplace(shaderModule, key);
+		return shaderModule;
+	}
+
+	void LveShaderModuleCache::release(VkShaderModule shaderModule) {
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		auto key = m_moduleHashes_.find(shaderModule);
+#ifndef NDEBUG
+		assert(key != m_moduleHashes_.end() && "Released a shader module that is not in the cache");
+#endif
+		auto [begin, end] = m_entries_.equal_range(key->second);
+		for (auto it = begin; it != end; ++it) {
+			if (it->second.m_module == shaderModule) {
+#ifndef NDEBUG
+				assert(it->second.m_refCount > 0 && "Shader module released more often than acquired");
+#endif
+				it->second.m_refCount--;
+				return;
+			}
+		}
+	}
+
+	void LveShaderModuleCache::trim() {
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		for (auto it = m_entries_.begin(); it != m_entries_.end();) {
+			if (it->second.m_refCount == 0) {
+				vkDestroyShaderModule(m_device_, it->second.m_module, nullptr);
+				m_moduleHashes_.erase(it->second.m_module);
+				it = m_entries_.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	LveShaderStageModule::LveShaderStageModule(LveShaderModuleCache &cache, const LveShaderCode &code)
+			: m_cache_{cache} {
+		m_createInfo_.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		m_createInfo_.codeSize = code.sizeInBytes();
+		m_createInfo_.pCode = code.data();
+		if (!m_cache_.inlinesShaderModules()) {
+			m_module_ = m_cache_.acquire(code);
+		}
+	}
+
+	LveShaderStageModule::~LveShaderStageModule() {
+		if (m_module_ != VK_NULL_HANDLE) {
+			m_cache_.release(m_module_);
+		}
+	}
+
+	void LveShaderStageModule::fill(VkPipelineShaderStageCreateInfo &stage) const {
+		if (m_module_ != VK_NULL_HANDLE) {
+			stage.module = m_module_;
+		} else {
+			// VK_KHR_maintenance5 allows passing the code directly, the driver no longer needs a module
+			stage.module = VK_NULL_HANDLE;
+			stage.pNext = &m_createInfo_;
+		}
+	}
+}
@@ -0,0 +1,86 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVESHADERMODULECACHE_HPP
+#define VULKAN_TEST_LVESHADERMODULECACHE_HPP
+
+#include "LveShaderCode.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+	// Shader modules shared between pipelines, keyed by the contents of their SPIR-V. Pipelines only need a
+	// module while they are being created, so modules are reference counted by the pipelines being created
+	// from them and destroyed by trim() once unused, see LvePipelineCompiler.
+	//
+	// With VK_KHR_maintenance5 no modules are created at all, the code is chained into the shader stage
+	// instead, see LveShaderStageModule.
+	class LveShaderModuleCache {
+	public:
+		LveShaderModuleCache(VkDevice device, bool inlineShaderModules);
+
+		~LveShaderModuleCache();
+
+		LveShaderModuleCache(const LveShaderModuleCache &) = delete;
+
+		LveShaderModuleCache &operator=(const LveShaderModuleCache &) = delete;
+
+		// Returns the module for code, creating it if no module with the same contents exists. Every acquire
+		// must be matched by a release.
+		VkShaderModule acquire(const LveShaderCode &code);
+
+		void release(VkShaderModule shaderModule);
+
+		// Destroys the modules no pipeline is being created from
+		void trim();
+
+		bool inlinesShaderModules() const { return m_inlineShaderModules_; }
+
+	private:
+		struct Entry {
+			// Kept to tell hash collisions apart
+			std::vector<uint32_t> m_words;
+			VkShaderModule m_module;
+			uint32_t m_refCount;
+		};
+
+		static uint64_t hash(const LveShaderCode &code);
+
+		VkDevice m_device_;
+		bool m_inlineShaderModules_;
+		std::mutex m_mutex_;
+		std::unordered_multimap<uint64_t, Entry> m_entries_;
+		std::unordered_map<VkShaderModule, uint64_t> m_moduleHashes_;
+	};
+
+	// The module of one shader stage for the duration of a pipeline creation
+	class LveShaderStageModule {
+	public:
+		// code must outlive this object
+		LveShaderStageModule(LveShaderModuleCache &cache, const LveShaderCode &code);
+
+		~LveShaderStageModule();
+
+		LveShaderStageModule(const LveShaderStageModule &) = delete;
+
+		LveShaderStageModule &operator=(const LveShaderStageModule &) = delete;
+
+		// Sets the module of stage, or chains the code into its pNext when modules are inlined
+		void fill(VkPipelineShaderStageCreateInfo &stage) const;
+
+	private:
+		LveShaderModuleCache &m_cache_;
+		VkShaderModuleCreateInfo m_createInfo_{};
+		VkShaderModule m_module_ = VK_NULL_HANDLE;
+	};
+}
+
+#endif //VULKAN_TEST_LVESHADERMODULECACHE_HPP
@@ -0,0 +1,427 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveShaderReflection.hpp"
+
+// std
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lve {
+
+	namespace {
+		constexpr uint32_t spirvMagic = 0x07230203;
+		constexpr size_t spirvHeaderWords = 5;
+
+		// Opcodes, decorations and enumerants from the SPIR-V specification, limited to what is reflected here
+		enum Op : uint32_t {
+			OpEntryPoint = 15,
+			OpTypeBool = 20,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampler = 26,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpVariable = 59,
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+		};
+
+		enum Decoration : uint32_t {
+			DecorationBlock = 2,
+			DecorationBufferBlock = 3,
+			DecorationArrayStride = 6,
+			DecorationMatrixStride = 7,
+			DecorationBuiltIn = 11,
+			DecorationLocation = 30,
+			DecorationBinding = 33,
+			DecorationDescriptorSet = 34,
+			DecorationOffset = 35,
+		};
+
+		enum StorageClass : uint32_t {
+			StorageClassUniformConstant = 0,
+			StorageClassInput = 1,
+			StorageClassUniform = 2,
+			StorageClassPushConstant = 9,
+			StorageClassStorageBuffer = 12,
+		};
+
+		enum ExecutionModel : uint32_t {
+			ExecutionModelVertex = 0,
+			ExecutionModelTessellationControl = 1,
+			ExecutionModelTessellationEvaluation = 2,
+			ExecutionModelGeometry = 3,
+			ExecutionModelFragment = 4,
+			ExecutionModelGLCompute = 5,
+		};
+
+		constexpr uint32_t dimBuffer = 5;
+		constexpr uint32_t dimSubpassData = 6;
+		constexpr uint32_t noValue = std::numeric_limits<uint32_t>::max();
+
+		struct Id {
+			uint32_t m_opcode = 0;
+			// Operands of the defining instruction, after the result id
+			std::vector<uint32_t> m_operands;
+
+			uint32_t m_location = noValue;
+			uint32_t m_binding = noValue;
+			uint32_t m_set = noValue;
+			uint32_t m_arrayStride = 0;
+			bool m_builtIn = false;
+			bool m_block = false;
+			bool m_bufferBlock = false;
+			std::vector<uint32_t> m_memberOffsets;
+			std::vector<uint32_t> m_memberMatrixStrides;
+		};
+
+		class Module {
+		public:
+			explicit Module(const LveShaderCode &code) : m_words_{code.data()}, m_wordCount_{code.wordCount()} {
+				if (m_wordCount_ < spirvHeaderWords) {
+					throw std::runtime_error("Invalid SPIR-V: module is smaller than its header");
+				}
+				if (m_words_[0] != spirvMagic) {
+					throw std::runtime_error("Invalid SPIR-V: bad magic number");
+				}
+				m_ids_.resize(m_words_[3]);
+				parse();
+			}
+
+			ShaderReflection reflect() const;
+
+		private:
+			void parse();
+
+			Id &id(uint32_t index) {
+				if (index >= m_ids_.size()) {
+					throw std::runtime_error("Invalid SPIR-V: id out of bounds");
+				}
+				return m_ids_[index];
+			}
+
+			const Id &id(uint32_t index) const {
+				if (index >= m_ids_.size()) {
+					throw std::runtime_error("Invalid SPIR-V: id out of bounds");
+				}
+				return m_ids_[index];
+			}
+
+			uint32_t typeSize(uint32_t typeId, uint32_t matrixStride = 0) const;
+
+			uint32_t constantValue(uint32_t constantId) const;
+
+			VkFormat inputFormat(uint32_t typeId) const;
+
+			void reflectBinding(const Id &variable, uint32_t typeId, ShaderReflection &reflection) const;
+
+			const uint32_t *m_words_;
+			size_t m_wordCount_;
+			std::vector<Id> m_ids_;
+			std::vector<uint32_t> m_variables_;
+			uint32_t m_executionModel_ = noValue;
+		};
+
+		void Module::parse() {
+			size_t offset = spirvHeaderWords;
+			while (offset < m_wordCount_) {
+				uint32_t opcode = m_words_[offset] & 0xFFFFu;
+				uint32_t wordCount = m_words_[offset] >> 16;
+				if (wordCount == 0 || offset + wordCount > m_wordCount_) {
+					throw std::runtime_error("Invalid SPIR-V: truncated instruction");
+				}
+				const uint32_t *operands = &m_words_[offset + 1];
+				uint32_t operandCount = wordCount - 1;
+
+				switch (opcode) {
+					case OpEntryPoint:
+						if (m_executionModel_ != noValue) {
+							throw std::runtime_error("Reflection of SPIR-V with several entry points is not supported");
+						}
+						m_executionModel_ = operands[0];
+						break;
+					case OpTypeBool:
+					case OpTypeInt:
+					case OpTypeFloat:
+					case OpTypeVector:
+					case OpTypeMatrix:
+					case OpTypeImage:
+					case OpTypeSampler:
+					case OpTypeSampledImage:
+					case OpTypeArray:
+					case OpTypeRuntimeArray:
+					case OpTypeStruct: {
+						auto &type = id(operands[0]);
+						type.m_opcode = opcode;
+						type.m_operands.assign(operands + 1, operands + operandCount);
+						break;
+					}
+					case OpTypePointer:
+					case OpConstant:
+					case OpVariable: {
+						// Result type comes first for constants and variables, after the result for pointers
+						uint32_t resultIndex = opcode == OpTypePointer ? 0 : 1;
+						auto &result = id(operands[resultIndex]);
+						result.m_opcode = opcode;
+						result.m_operands.clear();
+						for (uint32_t i = 0; i < operandCount; i++) {
+							if (i != resultIndex) {
+								result.m_operands.push_back(operands[i]);
+							}
+						}
+						if (opcode == OpVariable) {
+							m_variables_.push_back(operands[1]);
+						}
+						break;
+					}
+					case OpDecorate: {
+						auto &target = id(operands[0]);
+						uint32_t value = operandCount > 2 ? operands[2] : 0;
+						switch (operands[1]) {
+							case DecorationBlock:
+								target.m_block = true;
+								break;
+							case DecorationBufferBlock:
+								target.m_bufferBlock = true;
+								break;
+							case DecorationArrayStride:
+								target.m_arrayStride = value;
+								break;
+							case DecorationBuiltIn:
+								target.m_builtIn = true;
+								break;
+							case DecorationLocation:
+								target.m_location = value;
+								break;
+							case DecorationBinding:
+								target.m_binding = value;
+								break;
+							case DecorationDescriptorSet:
+								target.m_set = value;
+								break;
+							default:
+								break;
+						}
+						break;
+					}
+					case OpMemberDecorate: {
+						auto &target = id(operands[0]);
+						uint32_t member = operands[1];
+						uint32_t value = operandCount > 3 ? operands[3] : 0;
+						if (operands[2] == DecorationOffset || operands[2] == DecorationMatrixStride) {
+							auto &values = operands[2] == DecorationOffset ? target.m_memberOffsets
+							                                                : target.m_memberMatrixStrides;
+							if (values.size() <= member) {
+								values.resize(member + 1, 0);
+							}
+							values[member] = value;
+						} else if (operands[2] == DecorationBuiltIn) {
+							target.m_builtIn = true;
+						}
+						break;
+					}
+					default:
+						break;
+				}
+				offset += wordCount;
+			}
+
+			if (m_executionModel_ == noValue) {
+				throw std::runtime_error("Invalid SPIR-V: no entry point");
+			}
+		}
+
+		uint32_t Module::constantValue(uint32_t constantId) const {
+			const auto &constant = id(constantId);
+			if (constant.m_opcode != OpConstant || constant.m_operands.size() < 2) {
+				throw std::runtime_error("Reflection of specialization sized arrays is not supported");
+			}
+			return constant.m_operands[1];
+		}
+
+		uint32_t Module::typeSize(uint32_t typeId, uint32_t matrixStride) const {
+			const auto &type = id(typeId);
+			switch (type.m_opcode) {
+				case OpTypeBool:
+					return 4;
+				case OpTypeInt:
+				case OpTypeFloat:
+					return type.m_operands[0] / 8;
+				case OpTypeVector:
+					return typeSize(type.m_operands[0]) * type.m_operands[1];
+				case OpTypeMatrix:
+					// Column major, so the stride separates columns
+					return (matrixStride ? matrixStride : typeSize(type.m_operands[0])) * type.m_operands[1];
+				case OpTypeArray:
+					return type.m_arrayStride * constantValue(type.m_operands[1]);
+				case OpTypeStruct: {
+					uint32_t size = 0;
+					for (uint32_t i = 0; i < type.m_operands.size(); i++) {
+						uint32_t memberOffset = i < type.m_memberOffsets.size() ? type.m_memberOffsets[i] : 0;
+						uint32_t memberStride = i < type.m_memberMatrixStrides.size() ? type.m_memberMatrixStrides[i] : 0;
+						size = std::max(size, memberOffset + typeSize(type.m_operands[i], memberStride));
+					}
+					return size;
+				}
+				default:
+					throw std::runtime_error("Cannot determine the size of a SPIR-V type");
+			}
+		}
+
+		VkFormat Module::inputFormat(uint32_t typeId) const {
+			const auto &type = id(typeId);
+			uint32_t componentCount = 1;
+			const Id *component = &type;
+			if (type.m_opcode == OpTypeVector) {
+				componentCount = type.m_operands[1];
+				component = &id(type.m_operands[0]);
+			}
+			if (component->m_operands.empty() || component->m_operands[0] != 32 || componentCount > 4) {
+				return VK_FORMAT_UNDEFINED;
+			}
+
+			constexpr VkFormat floatFormats[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT,
+			                                     VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+			constexpr VkFormat sintFormats[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT,
+			                                    VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+			constexpr VkFormat uintFormats[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT,
+			                                    VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+			if (component->m_opcode == OpTypeFloat) {
+				return floatFormats[componentCount - 1];
+			}
+			if (component->m_opcode == OpTypeInt) {
+				bool isSigned = component->m_operands.size() > 1 && component->m_operands[1] != 0;
+				return isSigned ? sintFormats[componentCount - 1] : uintFormats[componentCount - 1];
+			}
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		void Module::reflectBinding(const Id &variable, uint32_t typeId, ShaderReflection &reflection) const {
+			ShaderDescriptorBinding binding{};
+			binding.m_set = variable.m_set == noValue ? 0 : variable.m_set;
+			binding.m_binding = variable.m_binding == noValue ? 0 : variable.m_binding;
+			binding.m_count = 1;
+
+			// Arrays of descriptors
+			const Id *type = &id(typeId);
+			while (type->m_opcode == OpTypeArray || type->m_opcode == OpTypeRuntimeArray) {
+				binding.m_count = type->m_opcode == OpTypeArray ? binding.m_count * constantValue(type->m_operands[1])
+				                                                : 0;
+				type = &id(type->m_operands[0]);
+			}
+
+			uint32_t storageClass = variable.m_operands[1];
+			if (storageClass == StorageClassStorageBuffer || type->m_bufferBlock) {
+				binding.m_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			} else if (storageClass == StorageClassUniform) {
+				binding.m_type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			} else if (type->m_opcode == OpTypeSampler) {
+				binding.m_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+			} else if (type->m_opcode == OpTypeSampledImage) {
+				uint32_t dim = id(type->m_operands[0]).m_operands[1];
+				binding.m_type = dim == dimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+				                                  : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			} else if (type->m_opcode == OpTypeImage) {
+				// Operands: sampled type, dim, depth, arrayed, multisampled, sampled (1) or storage (2), format
+				uint32_t dim = type->m_operands[1];
+				bool storage = type->m_operands[5] == 2;
+				if (dim == dimSubpassData) {
+					binding.m_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				} else if (dim == dimBuffer) {
+					binding.m_type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+					                         : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				} else {
+					binding.m_type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+				}
+			} else {
+				return;
+			}
+			reflection.m_bindings.push_back(binding);
+		}
+
+		ShaderReflection Module::reflect() const {
+			ShaderReflection reflection{};
+			switch (m_executionModel_) {
+				case ExecutionModelVertex:
+					reflection.m_stage = VK_SHADER_STAGE_VERTEX_BIT;
+					break;
+				case ExecutionModelTessellationControl:
+					reflection.m_stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+					break;
+				case ExecutionModelTessellationEvaluation:
+					reflection.m_stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+					break;
+				case ExecutionModelGeometry:
+					reflection.m_stage = VK_SHADER_STAGE_GEOMETRY_BIT;
+					break;
+				case ExecutionModelFragment:
+					reflection.m_stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+					break;
+				case ExecutionModelGLCompute:
+					reflection.m_stage = VK_SHADER_STAGE_COMPUTE_BIT;
+					break;
+				default:
+					throw std::runtime_error("Unsupported shader execution model");
+			}
+
+			for (uint32_t variableId: m_variables_) {
+				const auto &variable = id(variableId);
+				// Operands: pointer type, storage class
+				const auto &pointer = id(variable.m_operands[0]);
+				uint32_t typeId = pointer.m_operands[1];
+				uint32_t storageClass = variable.m_operands[1];
+
+				switch (storageClass) {
+					case StorageClassInput:
+						if (!variable.m_builtIn && !id(typeId).m_builtIn && variable.m_location != noValue) {
+							reflection.m_inputs.push_back({variable.m_location, inputFormat(typeId)});
+						}
+						break;
+					case StorageClassPushConstant: {
+						const auto &block = id(typeId);
+						uint32_t begin = block.m_memberOffsets.empty()
+						                 ? 0
+						                 : *std::min_element(block.m_memberOffsets.begin(), block.m_memberOffsets.end());
+						reflection.m_pushConstantOffset = begin;
+						reflection.m_pushConstantSize = typeSize(typeId) - begin;
+						break;
+					}
+					case StorageClassUniformConstant:
+					case StorageClassUniform:
+					case StorageClassStorageBuffer:
+						reflectBinding(variable, typeId, reflection);
+						break;
+					default:
+						break;
+				}
+			}
+
+			std::sort(reflection.m_inputs.begin(), reflection.m_inputs.end(),
+			          [](const ShaderInput &a, const ShaderInput &b) { return a.m_location < b.m_location; });
+			std::sort(reflection.m_bindings.begin(), reflection.m_bindings.end(),
+			          [](const ShaderDescriptorBinding &a, const ShaderDescriptorBinding &b) {
+				          return a.m_set != b.m_set ? a.m_set < b.m_set : a.m_binding < b.m_binding;
+			          });
+			return reflection;
+		}
+	}
+
+	ShaderReflection reflectShader(const LveShaderCode &code) {
+		return Module{code}.reflect();
+	}
+
+	ShaderReflection reflectShaderFile(const std::string &filePath) {
+		return reflectShader(LveShaderCode::load(filePath));
+	}
+}
@@ -0,0 +1,49 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVESHADERREFLECTION_HPP
+#define VULKAN_TEST_LVESHADERREFLECTION_HPP
+
+#include "LveShaderCode.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+	struct ShaderInput {
+		uint32_t m_location;
+		// VK_FORMAT_UNDEFINED for types that cannot be vertex attributes, such as 64-bit or struct inputs
+		VkFormat m_format;
+	};
+
+	struct ShaderDescriptorBinding {
+		uint32_t m_set;
+		uint32_t m_binding;
+		VkDescriptorType m_type;
+		// 0 for runtime sized arrays
+		uint32_t m_count;
+	};
+
+	// The interface of a single shader stage as declared in its SPIR-V: the user defined stage inputs, the
+	// descriptor bindings and the push constant block, if any.
+	struct ShaderReflection {
+		VkShaderStageFlagBits m_stage;
+		std::vector<ShaderInput> m_inputs;
+		std::vector<ShaderDescriptorBinding> m_bindings;
+		uint32_t m_pushConstantOffset = 0;
+		uint32_t m_pushConstantSize = 0;
+	};
+
+	// Throws std::runtime_error on malformed modules and on modules with more than one entry point
+	ShaderReflection reflectShader(const LveShaderCode &code);
+
+	ShaderReflection reflectShaderFile(const std::string &filePath);
+}
+
+#endif //VULKAN_TEST_LVESHADERREFLECTION_HPP
@@ -0,0 +1,137 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveShaderWatcher.hpp"
+#include "LveShaderCode.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+
+#ifdef __linux__
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#endif
+
+namespace lve {
+
+	namespace {
+		constexpr std::array<const char *, 6> shaderExtensions{".vert", ".frag", ".comp", ".geom", ".tesc", ".tese"};
+
+		bool isShaderSource(const std::string &fileName) {
+			return std::any_of(shaderExtensions.begin(), shaderExtensions.end(), [&](const char *extension) {
+				const std::string ext{extension};
+				return fileName.size() > ext.size() &&
+				       fileName.compare(fileName.size() - ext.size(), ext.size(), ext) == 0;
+			});
+		}
+
+		std::string quoted(const std::string &path) {
+			std::string result = "'";
+			for (char c: path) {
+				if (c == '\'') {
+					result += "'\\''";
+				} else {
+					result += c;
+				}
+			}
+			return result + "'";
+		}
+	}
+
+	LveShaderWatcher::LveShaderWatcher(std::string sourceDir, std::string binaryDir, std::string compiler)
+			: m_sourceDir_{std::move(sourceDir)}, m_binaryDir_{std::move(binaryDir)}, m_compiler_{std::move(compiler)} {
+#ifdef __linux__
+		m_inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_inotifyFd_ < 0) {
+			std::cerr << "Shader hot reload disabled: inotify_init1 failed" << std::endl;
+			return;
+		}
+		// Editors either rewrite the file in place or move a temporary file over it
+		if (inotify_add_watch(m_inotifyFd_, m_sourceDir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+			std::cerr << "Shader hot reload disabled: cannot watch " << m_sourceDir_ << std::endl;
+			close(m_inotifyFd_);
+			m_inotifyFd_ = -1;
+			return;
+		}
+
+		m_running_ = true;
+		m_thread_ = std::thread(&LveShaderWatcher::watch, this);
+#endif
+	}
+
+	LveShaderWatcher::~LveShaderWatcher() {
+		m_running_ = false;
+		if (m_thread_.joinable()) {
+			m_thread_.join();
+		}
+#ifdef __linux__
+		if (m_inotifyFd_ >= 0) {
+			close(m_inotifyFd_);
+		}
+#endif
+	}
+
+	std::vector<std::string> LveShaderWatcher::takeChangedShaders() {
+		std::lock_guard<std::mutex> lock{m_mutex_};
+		std::vector<std::string> changed;
+		changed.swap(m_changedShaders_);
+		return changed;
+	}
+
+	void LveShaderWatcher::watch() {
+#ifdef __linux__
+		alignas(inotify_event) char buffer[4096];
+		while (m_running_) {
+			// Wake up regularly to notice the destructor
+			pollfd pfd{m_inotifyFd_, POLLIN, 0};
+			if (poll(&pfd, 1, 100) <= 0) {
+				continue;
+			}
+
+			// A single save often produces several events, compile each file once per batch
+			std::set<std::string> changedFiles;
+			ssize_t length;
+			while ((length = read(m_inotifyFd_, buffer, sizeof(buffer))) > 0) {
+				for (char *ptr = buffer; ptr < buffer + length;) {
+					auto *event = reinterpret_cast<inotify_event *>(ptr);
+					if (event->len > 0 && isShaderSource(event->name)) {
+						changedFiles.insert(event->name);
+					}
+					ptr += sizeof(inotify_event) + event->len;
+				}
+			}
+
+			for (const auto &fileName: changedFiles) {
+				if (compile(fileName)) {
+					// The embedded copy is stale from now on
+					auto shaderName = fileName + ".spv";
+					LveShaderCode::overrideFromDisk(shaderName, m_binaryDir_ + "/" + shaderName);
+					std::lock_guard<std::mutex> lock{m_mutex_};
+					m_changedShaders_.push_back(shaderName);
+				}
+			}
+		}
+#endif
+	}
+
+	bool LveShaderWatcher::compile(const std::string &fileName) const {
+		const std::string command = quoted(m_compiler_) + " " +
+		                            quoted(m_sourceDir_ + "/" + fileName) + " -o " +
+		                            quoted(m_binaryDir_ + "/" + fileName + ".spv");
+		// glslc reports compile errors on stderr itself
+		if (std::system(command.c_str()) != 0) {
+			std::cerr << "Failed to recompile " << fileName << ", keeping the previous pipeline" << std::endl;
+			return false;
+		}
+		std::cout << "Recompiled " << fileName << std::endl;
+		return true;
+	}
+}
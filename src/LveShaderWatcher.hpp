@@ -0,0 +1,55 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVESHADERWATCHER_HPP
+#define VULKAN_TEST_LVESHADERWATCHER_HPP
+
+// std
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	// Development helper: watches the GLSL sources with inotify and recompiles changed files to SPIR-V with
+	// glslc on a background thread. Render systems poll takeChangedShaders() once per frame and rebuild the
+	// pipelines that use them. Does nothing on platforms without inotify.
+	class LveShaderWatcher {
+	public:
+		// sourceDir holds the GLSL files, recompiled .spv files are written to binaryDir and loaded from there
+		LveShaderWatcher(std::string sourceDir, std::string binaryDir, std::string compiler);
+
+		~LveShaderWatcher();
+
+		LveShaderWatcher(const LveShaderWatcher &) = delete;
+
+		LveShaderWatcher &operator=(const LveShaderWatcher &) = delete;
+
+		bool isWatching() const { return m_inotifyFd_ >= 0; }
+
+		// Names of the shaders successfully recompiled since the last call, as LveShaderCode::shaderName()
+		// returns them for the paths the render systems load (<file>.spv)
+		std::vector<std::string> takeChangedShaders();
+
+	private:
+		void watch();
+
+		bool compile(const std::string &fileName) const;
+
+		std::string m_sourceDir_;
+		std::string m_binaryDir_;
+		std::string m_compiler_;
+
+		int m_inotifyFd_ = -1;
+		std::atomic<bool> m_running_{false};
+		std::thread m_thread_;
+
+		std::mutex m_mutex_;
+		std::vector<std::string> m_changedShaders_;
+	};
+}
+
+#endif //VULKAN_TEST_LVESHADERWATCHER_HPP
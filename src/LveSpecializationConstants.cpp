@@ -0,0 +1,70 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveSpecializationConstants.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+
+namespace lve {
+
+	SpecializationConstants &SpecializationConstants::set(uint32_t constantId, uint32_t value) {
+		auto it = std::lower_bound(m_constantIds_.begin(), m_constantIds_.end(), constantId);
+		auto index = static_cast<size_t>(it - m_constantIds_.begin());
+		if (it != m_constantIds_.end() && *it == constantId) {
+			m_values_[index] = value;
+		} else {
+			m_constantIds_.insert(it, constantId);
+			m_values_.insert(m_values_.begin() + static_cast<std::ptrdiff_t>(index), value);
+		}
+		return *this;
+	}
+
+	SpecializationConstants &SpecializationConstants::set(uint32_t constantId, int32_t value) {
+		return set(constantId, static_cast<uint32_t>(value));
+	}
+
+	SpecializationConstants &SpecializationConstants::set(uint32_t constantId, float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return set(constantId, bits);
+	}
+
+	SpecializationConstants &SpecializationConstants::set(uint32_t constantId, bool value) {
+		return set(constantId, static_cast<uint32_t>(value ? VK_TRUE : VK_FALSE));
+	}
+
+	size_t SpecializationConstants::hash() const {
+		// FNV-1a over the (id, value) pairs
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&hash](uint32_t word) {
+			for (int i = 0; i < 4; i++) {
+				hash ^= (word >> (i * 8)) & 0xFFu;
+				hash *= 1099511628211ull;
+			}
+		};
+		for (size_t i = 0; i < m_constantIds_.size(); i++) {
+			mix(m_constantIds_[i]);
+			mix(m_values_[i]);
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	VkSpecializationInfo SpecializationConstants::getInfo(std::vector<VkSpecializationMapEntry> &entries) const {
+		entries.resize(m_constantIds_.size());
+		for (size_t i = 0; i < m_constantIds_.size(); i++) {
+			entries[i].constantID = m_constantIds_[i];
+			entries[i].offset = static_cast<uint32_t>(i * sizeof(uint32_t));
+			entries[i].size = sizeof(uint32_t);
+		}
+
+		VkSpecializationInfo info{};
+		info.mapEntryCount = static_cast<uint32_t>(entries.size());
+		info.pMapEntries = entries.data();
+		info.dataSize = m_values_.size() * sizeof(uint32_t);
+		info.pData = m_values_.data();
+		return info;
+	}
+}
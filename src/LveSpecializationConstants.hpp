@@ -0,0 +1,45 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVESPECIALIZATIONCONSTANTS_HPP
+#define VULKAN_TEST_LVESPECIALIZATIONCONSTANTS_HPP
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+	// Values for the layout(constant_id = N) constants of one shader stage. Constants are kept sorted by id,
+	// so two sets holding the same values compare and hash equal regardless of the order they were set in.
+	// Only 32-bit scalar constants (bool, int, uint, float) are supported.
+	class SpecializationConstants {
+	public:
+		SpecializationConstants &set(uint32_t constantId, uint32_t value);
+
+		SpecializationConstants &set(uint32_t constantId, int32_t value);
+
+		SpecializationConstants &set(uint32_t constantId, float value);
+
+		// SPIR-V booleans are specialized with a VkBool32
+		SpecializationConstants &set(uint32_t constantId, bool value);
+
+		bool empty() const { return m_constantIds_.empty(); }
+
+		size_t hash() const;
+
+		bool operator==(const SpecializationConstants &other) const = default;
+
+		// entries backs the returned info and has to outlive it
+		VkSpecializationInfo getInfo(std::vector<VkSpecializationMapEntry> &entries) const;
+
+	private:
+		std::vector<uint32_t> m_constantIds_;
+		std::vector<uint32_t> m_values_;
+	};
+}
+
+#endif //VULKAN_TEST_LVESPECIALIZATIONCONSTANTS_HPP
@@ -24,11 +24,17 @@ namespace lve {
 	}
 
     void LveSwapChain::init() {
-        createSwapChain();
+	    m_offscreen_ = m_device_.surface() == VK_NULL_HANDLE;
+	    if (m_offscreen_) {
+		    createOffscreenImages();
+	    } else {
+		    createSwapChain();
+	    }
         createImageViews();
-        createRenderPass();
         createDepthResources();
-        createFramebuffers();
+	    if (!m_device_.supportsDynamicRendering()) {
+		    createRenderPass();
+	    }
         createSyncObjects();
     }
 
@@ -42,6 +48,10 @@ namespace lve {
 		    vkDestroySwapchainKHR(m_device_.device(), m_swapChain_, nullptr);
 		    m_swapChain_ = nullptr;
 	    }
+	    for (size_t i = 0; i < m_offscreenImageMemorys_.size(); i++) {
+		    vkDestroyImage(m_device_.device(), m_swapChainImages_[i], nullptr);
+		    vkFreeMemory(m_device_.device(), m_offscreenImageMemorys_[i], nullptr);
+	    }
 
 	    for (int i = 0; i < m_depthImages_.size(); i++) {
 		    vkDestroyImageView(m_device_.device(), m_depthImageViews_[i], nullptr);
@@ -49,10 +59,6 @@ namespace lve {
 		    vkFreeMemory(m_device_.device(), m_depthImageMemorys_[i], nullptr);
 	    }
 
-	    for (auto framebuffer: m_swapChainFramebuffers_) {
-		    vkDestroyFramebuffer(m_device_.device(), framebuffer, nullptr);
-	    }
-
 	    vkDestroyRenderPass(m_device_.device(), m_renderPass_, nullptr);
 
 	    // cleanup synchronization objects
@@ -71,6 +77,11 @@ namespace lve {
 			    VK_TRUE,
 			    std::numeric_limits<uint64_t>::max());
 
+	    if (m_offscreen_) {
+		    *imageIndex = static_cast<uint32_t>(m_currentFrame_);
+		    return VK_SUCCESS;
+	    }
+
 	    VkResult result = vkAcquireNextImageKHR(
 			    m_device_.device(),
 			    m_swapChain_,
@@ -91,9 +102,10 @@ namespace lve {
 	    VkSubmitInfo submitInfo = {};
 	    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+	    // Offscreen images are neither acquired nor presented, so there is nothing to wait for or signal
 	    VkSemaphore waitSemaphores[] = {m_imageAvailableSemaphores_[m_currentFrame_]};
 	    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	    submitInfo.waitSemaphoreCount = 1;
+	    submitInfo.waitSemaphoreCount = m_offscreen_ ? 0 : 1;
 	    submitInfo.pWaitSemaphores = waitSemaphores;
 	    submitInfo.pWaitDstStageMask = waitStages;
 
@@ -101,7 +113,7 @@ namespace lve {
 	    submitInfo.pCommandBuffers = buffers;
 
 	    VkSemaphore signalSemaphores[] = {m_renderFinishedSemaphores_[m_currentFrame_]};
-	    submitInfo.signalSemaphoreCount = 1;
+	    submitInfo.signalSemaphoreCount = m_offscreen_ ? 0 : 1;
 	    submitInfo.pSignalSemaphores = signalSemaphores;
 
 	    vkResetFences(m_device_.device(), 1, &m_inFlightFences_[m_currentFrame_]);
@@ -110,6 +122,11 @@ namespace lve {
 		    throw std::runtime_error("failed to submit draw command buffer!");
 	    }
 
+	    if (m_offscreen_) {
+		    m_currentFrame_ = (m_currentFrame_ + 1) % m_maxFramesInFlight;
+		    return VK_SUCCESS;
+	    }
+
 	    VkPresentInfoKHR presentInfo = {};
 	    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -152,6 +169,12 @@ namespace lve {
 	    createInfo.imageExtent = extent;
 	    createInfo.imageArrayLayers = 1;
 	    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	    // Lets the rendered image be copied back for frame capture
+	    m_transferSource_ =
+			    (swapChainSupport.m_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+	    if (m_transferSource_) {
+		    createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	    }
 
 	    QueueFamilyIndices indices = m_device_.findPhysicalQueueFamilies();
 	    uint32_t queueFamilyIndices[] = {indices.m_graphicsFamily, indices.m_presentFamily};
@@ -190,6 +213,43 @@ namespace lve {
 	    m_swapChainExtent_ = extent;
     }
 
+    void LveSwapChain::createOffscreenImages() {
+	    m_swapChainImageFormat_ = m_device_.findSupportedFormat(
+			    {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+			    VK_IMAGE_TILING_OPTIMAL,
+			    VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+	    m_swapChainExtent_ = m_windowExtent_;
+	    // Offscreen images exist to be read back
+	    m_transferSource_ = true;
+
+	    // One per frame in flight, acquireNextImage hands them out in the order of the frames
+	    m_swapChainImages_.resize(m_maxFramesInFlight);
+	    m_offscreenImageMemorys_.resize(m_maxFramesInFlight);
+	    for (size_t i = 0; i < m_swapChainImages_.size(); i++) {
+		    VkImageCreateInfo imageInfo{};
+		    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		    imageInfo.extent.width = m_swapChainExtent_.width;
+		    imageInfo.extent.height = m_swapChainExtent_.height;
+		    imageInfo.extent.depth = 1;
+		    imageInfo.mipLevels = 1;
+		    imageInfo.arrayLayers = 1;
+		    imageInfo.format = m_swapChainImageFormat_;
+		    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		    imageInfo.flags = 0;
+
+		    m_device_.createImageWithInfo(
+				    imageInfo,
+				    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				    m_swapChainImages_[i],
+				    m_offscreenImageMemorys_[i]);
+	    }
+    }
+
     void LveSwapChain::createImageViews() {
 	    m_swapChainImageViews_.resize(m_swapChainImages_.size());
 	    for (size_t i = 0; i < m_swapChainImages_.size(); i++) {
@@ -212,11 +272,12 @@ namespace lve {
     }
 
     void LveSwapChain::createRenderPass() {
+	    // Only used to create compatible pipelines, the render graph begins its own render passes
         VkAttachmentDescription depthAttachment{};
         depthAttachment.format = findDepthFormat();
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -234,7 +295,9 @@ namespace lve {
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        // The present layout needs the swap chain extension, which a headless device leaves out
+        colorAttachment.finalLayout =
+		        m_offscreen_ ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -270,31 +333,6 @@ namespace lve {
 	    }
     }
 
-    void LveSwapChain::createFramebuffers() {
-	    m_swapChainFramebuffers_.resize(imageCount());
-        for (size_t i = 0; i < imageCount(); i++) {
-	        std::array<VkImageView, 2> attachments = {m_swapChainImageViews_[i], m_depthImageViews_[i]};
-
-            VkExtent2D swapChainExtent = getSwapChainExtent();
-            VkFramebufferCreateInfo framebufferInfo = {};
-	        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	        framebufferInfo.renderPass = m_renderPass_;
-	        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-            framebufferInfo.pAttachments = attachments.data();
-            framebufferInfo.width = swapChainExtent.width;
-            framebufferInfo.height = swapChainExtent.height;
-            framebufferInfo.layers = 1;
-
-	        if (vkCreateFramebuffer(
-			        m_device_.device(),
-			        &framebufferInfo,
-			        nullptr,
-			        &m_swapChainFramebuffers_[i]) != VK_SUCCESS) {
-		        throw std::runtime_error("failed to create framebuffer!");
-	        }
-        }
-    }
-
     void LveSwapChain::createDepthResources() {
 	    VkFormat depthFormat = findDepthFormat();
 	    m_swapChainDepthFormat_ = depthFormat;
@@ -316,7 +354,7 @@ namespace lve {
 		    imageInfo.format = depthFormat;
 		    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 		    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		    imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 		    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		    imageInfo.flags = 0;
@@ -420,7 +458,7 @@ namespace lve {
 	    return m_device_.findSupportedFormat(
 			    {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
 			    VK_IMAGE_TILING_OPTIMAL,
-			    VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+			    VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
     }
 
 }  // namespace lve
\ No newline at end of file
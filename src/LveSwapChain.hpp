@@ -12,6 +12,15 @@
 
 namespace lve {
 
+	struct DepthAttachmentInfo {
+		VkImage m_image;
+		VkImageView m_imageView;
+		VkFormat m_format;
+		VkExtent2D m_extent;
+	};
+
+	// Without a surface, for a headless window, the images are offscreen images owned here. They are
+	// rendered in turn, one per frame in flight, and never presented.
 	class LveSwapChain {
 	public:
 		static constexpr int m_maxFramesInFlight = 2;
@@ -27,16 +36,28 @@ namespace lve {
 
 		LveSwapChain &operator=(const LveSwapChain &) = delete;
 
-		VkFramebuffer getFrameBuffer(int index) { return m_swapChainFramebuffers_[index]; }
-
+		// Only created when the device has no dynamic rendering, for pipelines to be compatible with
 		VkRenderPass getRenderPass() { return m_renderPass_; }
 
+		DepthAttachmentInfo getDepthAttachment(int index) {
+			return {m_depthImages_[index], m_depthImageViews_[index], m_swapChainDepthFormat_, m_swapChainExtent_};
+		}
+
+		VkImage getImage(int index) { return m_swapChainImages_[index]; }
+
 		VkImageView getImageView(int index) { return m_swapChainImageViews_[index]; }
 
+		// Whether the images can be the source of transfer commands, which the surface may not allow
+		bool isTransferSource() const { return m_transferSource_; }
+
+		bool isOffscreen() const { return m_offscreen_; }
+
 		size_t imageCount() { return m_swapChainImages_.size(); }
 
 		VkFormat getSwapChainImageFormat() { return m_swapChainImageFormat_; }
 
+		VkFormat getSwapChainDepthFormat() { return m_swapChainDepthFormat_; }
+
 		VkExtent2D getSwapChainExtent() { return m_swapChainExtent_; }
 
 		uint32_t width() { return m_swapChainExtent_.width; }
@@ -63,14 +84,14 @@ namespace lve {
 
 		void createSwapChain();
 
+		void createOffscreenImages();
+
 		void createImageViews();
 
 		void createDepthResources();
 
 		void createRenderPass();
 
-		void createFramebuffers();
-
 		void createSyncObjects();
 
 		// Helper functions
@@ -85,20 +106,23 @@ namespace lve {
 		VkFormat m_swapChainImageFormat_;
 		VkFormat m_swapChainDepthFormat_;
 		VkExtent2D m_swapChainExtent_;
+		bool m_transferSource_ = false;
+		bool m_offscreen_ = false;
 
-		std::vector<VkFramebuffer> m_swapChainFramebuffers_;
-		VkRenderPass m_renderPass_;
+		VkRenderPass m_renderPass_ = VK_NULL_HANDLE;
 
 		std::vector<VkImage> m_depthImages_;
 		std::vector<VkDeviceMemory> m_depthImageMemorys_;
 		std::vector<VkImageView> m_depthImageViews_;
 		std::vector<VkImage> m_swapChainImages_;
 		std::vector<VkImageView> m_swapChainImageViews_;
+		// Only set for offscreen images, swap chain images are owned by the swap chain
+		std::vector<VkDeviceMemory> m_offscreenImageMemorys_;
 
 		LveDevice &m_device_;
 		VkExtent2D m_windowExtent_;
 
-		VkSwapchainKHR m_swapChain_;
+		VkSwapchainKHR m_swapChain_ = VK_NULL_HANDLE;
 		std::shared_ptr<LveSwapChain> m_oldSwapChain_;
 
 		std::vector<VkSemaphore> m_imageAvailableSemaphores_;
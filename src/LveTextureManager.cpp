@@ -0,0 +1,844 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#include "LveTextureManager.hpp"
+#include "LveSwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace lve {
+
+	namespace {
+		constexpr std::array<uint8_t, 12> ktx2Identifier{0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A,
+		                                                 '\n'};
+		constexpr size_t ktx2HeaderSize = 80;
+		constexpr size_t ktx2LevelIndexEntrySize = 24;
+		// KHR_DF_TRANSFER_SRGB in the basic data format descriptor block
+		constexpr uint8_t dfdTransferSrgb = 2;
+		// Covers the texel block size of every block compressed format, and the 4 bytes copies require
+		constexpr VkDeviceSize stagingAlignment = 16;
+
+		// KTX2 is little endian, as is every host this runs on
+		template<typename T>
+		T readLittleEndian(const uint8_t *data) {
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		}
+
+		std::vector<uint8_t> readRange(std::ifstream &file, uint64_t offset, uint64_t length, uint64_t fileSize,
+		                               const std::string &path) {
+			if (offset > fileSize || length > fileSize - offset) {
+				throw std::runtime_error("Truncated KTX2 file " + path);
+			}
+			std::vector<uint8_t> data(length);
+			file.seekg(static_cast<std::streamoff>(offset));
+			if (!file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(length))) {
+				throw std::runtime_error("Failed to read " + path);
+			}
+			return data;
+		}
+	}
+
+	Ktx2Image Ktx2Image::read(const std::string &path) {
+		std::ifstream file{path, std::ios::binary | std::ios::ate};
+		if (!file) {
+			throw std::runtime_error("Failed to open texture " + path);
+		}
+		const auto fileSize = static_cast<uint64_t>(file.tellg());
+
+		auto header = readRange(file, 0, ktx2HeaderSize, fileSize, path);
+		if (!std::equal(ktx2Identifier.begin(), ktx2Identifier.end(), header.begin())) {
+			throw std::runtime_error(path + " is not a KTX2 file");
+		}
+
+		Ktx2Image image{};
+		image.m_format = static_cast<VkFormat>(readLittleEndian<uint32_t>(&header[12]));
+		image.m_extent = {readLittleEndian<uint32_t>(&header[20]),
+		                  std::max(readLittleEndian<uint32_t>(&header[24]), 1u)};
+		const auto depth = readLittleEndian<uint32_t>(&header[28]);
+		const auto layerCount = readLittleEndian<uint32_t>(&header[32]);
+		const auto faceCount = readLittleEndian<uint32_t>(&header[36]);
+		// Zero asks the loader to generate the levels; the file then holds only the first
+		const auto levelCount = std::max(readLittleEndian<uint32_t>(&header[40]), 1u);
+		image.m_supercompressionScheme = readLittleEndian<uint32_t>(&header[44]);
+		const auto dfdOffset = readLittleEndian<uint32_t>(&header[48]);
+		const auto dfdLength = readLittleEndian<uint32_t>(&header[52]);
+		const auto sgdOffset = readLittleEndian<uint64_t>(&header[64]);
+		const auto sgdLength = readLittleEndian<uint64_t>(&header[72]);
+
+		if (image.m_extent.width == 0 || depth > 1 || layerCount > 1 || faceCount != 1) {
+			throw std::runtime_error(path + " is not a 2D texture");
+		}
+
+		// colorModel, colorPrimaries, transferFunction follow the descriptor's total size and block header
+		if (dfdLength >= 16) {
+			auto dfd = readRange(file, dfdOffset, dfdLength, fileSize, path);
+			image.m_srgb = dfd[14] == dfdTransferSrgb;
+		}
+		if (sgdLength > 0) {
+			image.m_supercompressionGlobalData = readRange(file, sgdOffset, sgdLength, fileSize, path);
+		}
+
+		auto levelIndex = readRange(file, ktx2HeaderSize, static_cast<uint64_t>(levelCount) * ktx2LevelIndexEntrySize,
+		                            fileSize, path);
+		image.m_levels.resize(levelCount);
+		for (uint32_t level = 0; level < levelCount; level++) {
+			const uint8_t *entry = &levelIndex[level * ktx2LevelIndexEntrySize];
+			image.m_levels[level] = readRange(file, readLittleEndian<uint64_t>(entry),
+			                                  readLittleEndian<uint64_t>(entry + 8), fileSize, path);
+		}
+		return image;
+	}
+
+	LveTextureManager::LveTextureManager(LveDevice &device,
+	                                     LveDeletionQueue &deletionQueue,
+	                                     LveBindlessHeap *bindlessHeap,
+	                                     Settings settings)
+			: m_lveDevice_{device},
+			  m_deletionQueue_{deletionQueue},
+			  m_bindlessHeap_{bindlessHeap},
+			  m_settings_{std::move(settings)} {
+		createSampler();
+
+		// Basis Universal transcodes to whichever block compressed family the device samples
+		constexpr VkFormatFeatureFlags features =
+				VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		if (m_lveDevice_.supportsFormat(VK_FORMAT_BC7_UNORM_BLOCK, features) &&
+		    m_lveDevice_.supportsFormat(VK_FORMAT_BC7_SRGB_BLOCK, features)) {
+			m_transcodeFormat_ = VK_FORMAT_BC7_UNORM_BLOCK;
+			m_transcodeFormatSrgb_ = VK_FORMAT_BC7_SRGB_BLOCK;
+		} else if (m_lveDevice_.supportsFormat(VK_FORMAT_ASTC_4x4_UNORM_BLOCK, features) &&
+		           m_lveDevice_.supportsFormat(VK_FORMAT_ASTC_4x4_SRGB_BLOCK, features)) {
+			m_transcodeFormat_ = VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+			m_transcodeFormatSrgb_ = VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+		}
+
+		m_stagingBuffers_.resize(LveSwapChain::m_maxFramesInFlight);
+		m_retiredBytes_.resize(LveSwapChain::m_maxFramesInFlight, 0);
+		for (uint32_t i = 0; i < std::max(m_settings_.m_workerCount, 1u); i++) {
+			m_workers_.emplace_back(&LveTextureManager::work, this);
+		}
+	}
+
+	LveTextureManager::~LveTextureManager() {
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_stopping_ = true;
+		}
+		m_requestQueued_.notify_all();
+		for (auto &worker: m_workers_) {
+			worker.join();
+		}
+
+		for (auto &texture: m_textures_) {
+			destroy(texture, false);
+		}
+		vkDestroySampler(m_lveDevice_.device(), m_sampler_, nullptr);
+	}
+
+	void LveTextureManager::createSampler() {
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.anisotropyEnable = VK_TRUE;
+		samplerInfo.maxAnisotropy = m_lveDevice_.m_properties.limits.maxSamplerAnisotropy;
+		samplerInfo.minLod = 0.f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+		if (vkCreateSampler(m_lveDevice_.device(), &samplerInfo, nullptr, &m_sampler_) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create texture sampler");
+		}
+	}
+
+	TextureId LveTextureManager::load(const std::string &path) {
+		TextureId id;
+		if (!m_freeTextures_.empty()) {
+			id = m_freeTextures_.back();
+			m_freeTextures_.pop_back();
+		} else {
+			id = static_cast<TextureId>(m_textures_.size());
+			m_textures_.emplace_back();
+		}
+
+		auto &texture = m_textures_[id];
+		texture.m_path = path;
+		texture.m_lastUsedFrame = m_frameNumber_;
+		requestRead(id);
+		return id;
+	}
+
+	void LveTextureManager::unload(TextureId texture) {
+		destroy(m_textures_[texture], true);
+		m_streaming_.erase(std::remove(m_streaming_.begin(), m_streaming_.end(), texture), m_streaming_.end());
+		m_reallocating_.erase(std::remove(m_reallocating_.begin(), m_reallocating_.end(), texture),
+		                      m_reallocating_.end());
+		m_freeTextures_.push_back(texture);
+	}
+
+	void LveTextureManager::requestRead(TextureId texture) {
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_requests_.push_back({texture, m_textures_[texture].m_serial, m_textures_[texture].m_path});
+		}
+		m_requestQueued_.notify_one();
+	}
+
+	void LveTextureManager::work() {
+		while (true) {
+			LoadRequest request;
+			{
+				std::unique_lock<std::mutex> lock{m_mutex_};
+				m_requestQueued_.wait(lock, [this] { return m_stopping_ || !m_requests_.empty(); });
+				if (m_stopping_) {
+					return;
+				}
+				request = std::move(m_requests_.front());
+				m_requests_.pop_front();
+			}
+
+			LoadResult result{request.m_texture, request.m_serial, {}, {}};
+			try {
+				result.m_image = readTexture(request.m_path);
+			} catch (const std::exception &e) {
+				result.m_error = e.what();
+			}
+
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			m_results_.push_back(std::move(result));
+		}
+	}
+
+	Ktx2Image LveTextureManager::readTexture(const std::string &path) const {
+		auto image = Ktx2Image::read(path);
+		if (!image.needsTranscoding()) {
+			return image;
+		}
+		if (!m_settings_.m_transcoder) {
+			throw std::runtime_error(path + " is supercompressed or Basis Universal encoded and no transcoder is set");
+		}
+
+		VkFormat format = image.m_format;
+		if (format == VK_FORMAT_UNDEFINED) {
+			format = image.m_srgb ? m_transcodeFormatSrgb_ : m_transcodeFormat_;
+		}
+		m_settings_.m_transcoder(image, format);
+		image.m_format = format;
+		image.m_supercompressionScheme = Ktx2Image::m_supercompressionNone;
+		image.m_supercompressionGlobalData.clear();
+		return image;
+	}
+
+	void LveTextureManager::beginFrame(int frameIndex) {
+		m_frameNumber_++;
+		// The deletion queue has destroyed what was retired the last time this frame index was recorded
+		m_retiredBytes_[frameIndex] = 0;
+
+		std::vector<LoadResult> results;
+		{
+			std::lock_guard<std::mutex> lock{m_mutex_};
+			results.swap(m_results_);
+		}
+
+		for (auto &result: results) {
+			auto &texture = m_textures_[result.m_texture];
+			if (texture.m_serial != result.m_serial) {
+				continue;
+			}
+
+			try {
+				if (!result.m_error.empty()) {
+					throw std::runtime_error(result.m_error);
+				}
+				if (texture.m_state == State::Loading) {
+					createImage(texture, result.m_image);
+				} else {
+					restoreLevels(result.m_texture, result.m_image);
+				}
+			} catch (const std::runtime_error &e) {
+				std::cerr << "Texture " << result.m_texture << ": " << e.what() << std::endl;
+				if (texture.m_state == State::Loading) {
+					texture.m_state = State::Failed;
+				} else {
+					texture.m_reloading = false;
+					texture.m_reloadFailed = true;
+				}
+				continue;
+			}
+			if (std::find(m_streaming_.begin(), m_streaming_.end(), result.m_texture) == m_streaming_.end()) {
+				m_streaming_.push_back(result.m_texture);
+			}
+		}
+
+		balanceMemory();
+	}
+
+	void LveTextureManager::createImage(Texture &texture, Ktx2Image &image) {
+		if (!m_lveDevice_.supportsFormat(image.m_format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+			throw std::runtime_error("The device cannot sample the format of the texture");
+		}
+
+		texture.m_format = image.m_format;
+		texture.m_extent = image.m_extent;
+		texture.m_generateMips =
+				image.m_levels.size() == 1 && std::max(image.m_extent.width, image.m_extent.height) > 1 &&
+				m_lveDevice_.supportsFormat(image.m_format,
+				                            VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+				                            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+		if (texture.m_generateMips) {
+			uint32_t levelCount = 1;
+			while ((std::max(image.m_extent.width, image.m_extent.height) >> levelCount) > 0) {
+				levelCount++;
+			}
+			texture.m_levelCount = levelCount;
+
+			// Blitting only works on uncompressed formats, whose levels are proportional to their texel count
+			const VkDeviceSize texelSize =
+					image.m_levels[0].size() / (static_cast<VkDeviceSize>(image.m_extent.width) * image.m_extent.height);
+			for (uint32_t level = 0; level < levelCount; level++) {
+				auto extent = levelExtent(texture, level);
+				texture.m_levelBytes.push_back(static_cast<VkDeviceSize>(extent.width) * extent.height * texelSize);
+			}
+			image.m_levels.resize(levelCount);
+		} else {
+			texture.m_levelCount = static_cast<uint32_t>(image.m_levels.size());
+			for (const auto &level: image.m_levels) {
+				texture.m_levelBytes.push_back(level.size());
+			}
+		}
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = texture.m_format;
+		imageInfo.extent = {texture.m_extent.width, texture.m_extent.height, 1};
+		imageInfo.mipLevels = texture.m_levelCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		// Transfer source for mip generation and for copying levels into a reallocated image
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+		                  VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		m_lveDevice_.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.m_image,
+		                                 texture.m_memory);
+		m_allocatedBytes_ += allocatedBytes(texture, 0);
+
+		texture.m_state = State::Streaming;
+		texture.m_baseLevel = 0;
+		texture.m_pendingBaseLevel = 0;
+		texture.m_residentLevel = texture.m_levelCount;
+		texture.m_levels = std::move(image.m_levels);
+		for (const auto &level: texture.m_levels) {
+			m_pendingUploadBytes_ += level.size();
+		}
+	}
+
+	void LveTextureManager::restoreLevels(TextureId id, Ktx2Image &image) {
+		auto &texture = m_textures_[id];
+		texture.m_reloading = false;
+		const auto fileLevels = texture.m_generateMips ? 1u : texture.m_levelCount;
+		if (image.m_format != texture.m_format || image.m_extent.width != texture.m_extent.width ||
+		    image.m_extent.height != texture.m_extent.height || image.m_levels.size() != fileLevels) {
+			throw std::runtime_error("The file changed since it was loaded");
+		}
+
+		// Downgraded again while the file was read
+		if (texture.m_pendingBaseLevel != texture.m_baseLevel) {
+			return;
+		}
+
+		const uint32_t restored = texture.m_generateMips ? 1u : texture.m_baseLevel;
+		for (uint32_t level = 0; level < restored; level++) {
+			m_pendingUploadBytes_ += image.m_levels[level].size();
+			texture.m_levels[level] = std::move(image.m_levels[level]);
+		}
+		texture.m_pendingBaseLevel = 0;
+		m_reallocating_.push_back(id);
+	}
+
+	void LveTextureManager::balanceMemory() {
+		const auto budget = m_lveDevice_.queryMemoryBudget();
+		VkDeviceSize limit;
+		VkDeviceSize usage;
+		if (budget.m_exact) {
+			limit = static_cast<VkDeviceSize>(static_cast<double>(budget.m_budget) * m_settings_.m_budgetFraction);
+			VkDeviceSize retired = 0;
+			for (auto bytes: m_retiredBytes_) {
+				retired += bytes;
+			}
+			usage = budget.m_usage - std::min(retired, budget.m_usage);
+		} else {
+			limit = static_cast<VkDeviceSize>(static_cast<double>(budget.m_budget) *
+			                                  m_settings_.m_textureFractionWithoutBudget);
+			usage = m_allocatedBytes_;
+		}
+
+		if (usage > limit) {
+			// Downgrade the least recently used textures first, one level at a time down to the smallest
+			// evictable level, until enough memory will be released
+			std::vector<TextureId> candidates;
+			for (TextureId id = 0; id < m_textures_.size(); id++) {
+				if (m_textures_[id].m_image != VK_NULL_HANDLE) {
+					candidates.push_back(id);
+				}
+			}
+			std::sort(candidates.begin(), candidates.end(), [this](TextureId a, TextureId b) {
+				return m_textures_[a].m_lastUsedFrame < m_textures_[b].m_lastUsedFrame;
+			});
+
+			VkDeviceSize excess = usage - limit;
+			for (auto id: candidates) {
+				auto &texture = m_textures_[id];
+				const uint32_t baseLevel = texture.m_pendingBaseLevel;
+				while (excess > 0 && texture.m_pendingBaseLevel + 1 < texture.m_levelCount) {
+					auto extent = levelExtent(texture, texture.m_pendingBaseLevel);
+					if (std::max(extent.width, extent.height) <= m_settings_.m_minimumEvictedExtent) {
+						break;
+					}
+					excess -= std::min(excess, texture.m_levelBytes[texture.m_pendingBaseLevel]);
+					texture.m_pendingBaseLevel++;
+				}
+				if (texture.m_pendingBaseLevel != baseLevel &&
+				    std::find(m_reallocating_.begin(), m_reallocating_.end(), id) == m_reallocating_.end()) {
+					m_reallocating_.push_back(id);
+				}
+				if (excess == 0) {
+					break;
+				}
+			}
+			return;
+		}
+
+		// Bring back the levels of textures sampled in the previous frame while there is room, keeping a
+		// margin so they are not the next ones to be evicted
+		VkDeviceSize headroom = limit - usage;
+		const VkDeviceSize margin = limit / 10;
+		for (TextureId id = 0; id < m_textures_.size(); id++) {
+			auto &texture = m_textures_[id];
+			if (texture.m_baseLevel == 0 || texture.m_pendingBaseLevel != texture.m_baseLevel ||
+			    texture.m_reloading || texture.m_reloadFailed || texture.m_lastUsedFrame + 1 < m_frameNumber_) {
+				continue;
+			}
+			const VkDeviceSize missing = allocatedBytes(texture, 0) - allocatedBytes(texture, texture.m_baseLevel);
+			if (missing + margin > headroom) {
+				continue;
+			}
+			headroom -= missing;
+			texture.m_reloading = true;
+			requestRead(id);
+		}
+	}
+
+	VkDeviceSize LveTextureManager::allocatedBytes(const Texture &texture, uint32_t baseLevel) const {
+		VkDeviceSize bytes = 0;
+		for (uint32_t level = baseLevel; level < texture.m_levelCount; level++) {
+			bytes += texture.m_levelBytes[level];
+		}
+		return bytes;
+	}
+
+	VkExtent2D LveTextureManager::levelExtent(const Texture &texture, uint32_t level) {
+		return {std::max(texture.m_extent.width >> level, 1u), std::max(texture.m_extent.height >> level, 1u)};
+	}
+
+	bool LveTextureManager::isUploadable(const Texture &texture) const {
+		if (texture.m_residentLevel <= texture.m_baseLevel) {
+			return false;
+		}
+		if (texture.m_generateMips) {
+			return texture.m_baseLevel == 0 && !texture.m_levels[0].empty();
+		}
+		return !texture.m_levels[texture.m_residentLevel - 1].empty();
+	}
+
+	VkDeviceSize LveTextureManager::nextUploadSize(const Texture &texture) const {
+		return texture.m_levels[texture.m_generateMips ? 0 : texture.m_residentLevel - 1].size();
+	}
+
+	void LveTextureManager::addUploadPass(LveRenderGraph &graph, int frameIndex) {
+		TransferBatch batch;
+		for (auto id: m_reallocating_) {
+			reallocate(m_textures_[id], frameIndex, batch);
+		}
+		m_reallocating_.clear();
+		scheduleUploads(frameIndex, batch);
+
+		if (batch.m_toTransfer.empty()) {
+			return;
+		}
+		VkBuffer stagingBuffer = m_stagingBuffers_[frameIndex] ? m_stagingBuffers_[frameIndex]->getBuffer()
+		                                                       : VK_NULL_HANDLE;
+		graph.addPass("texture upload", LveRenderGraph::PassType::Transfer,
+		              [](RenderGraphPassBuilder &pass) { pass.sideEffect(); },
+		              [stagingBuffer, batch = std::move(batch)](VkCommandBuffer commandBuffer) {
+			              recordBatch(commandBuffer, stagingBuffer, batch);
+		              });
+	}
+
+	void LveTextureManager::reallocate(Texture &texture, int frameIndex, TransferBatch &batch) {
+		const uint32_t oldBase = texture.m_baseLevel;
+		const uint32_t newBase = texture.m_pendingBaseLevel;
+		if (oldBase == newBase) {
+			return;
+		}
+
+		auto extent = levelExtent(texture, newBase);
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = texture.m_format;
+		imageInfo.extent = {extent.width, extent.height, 1};
+		imageInfo.mipLevels = texture.m_levelCount - newBase;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+		                  VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkImage image;
+		VkDeviceMemory memory;
+		m_lveDevice_.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+		// Resident levels both images have are copied over; the rest is uploaded or generated again
+		const uint32_t firstCopied = std::max(texture.m_residentLevel, newBase);
+		if (firstCopied < texture.m_levelCount) {
+			const uint32_t copiedCount = texture.m_levelCount - firstCopied;
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+			barrier.image = texture.m_image;
+			barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, firstCopied - oldBase, copiedCount, 0, 1};
+			barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			batch.m_toTransfer.push_back(barrier);
+
+			barrier.image = image;
+			barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, firstCopied - newBase, copiedCount, 0, 1};
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			batch.m_toTransfer.push_back(barrier);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			batch.m_toShaderRead.push_back(barrier);
+
+			ImageCopy copy{texture.m_image, image, {}};
+			for (uint32_t level = firstCopied; level < texture.m_levelCount; level++) {
+				auto copyExtent = levelExtent(texture, level);
+				VkImageCopy region{};
+				region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - oldBase, 0, 1};
+				region.srcOffset = {0, 0, 0};
+				region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - newBase, 0, 1};
+				region.dstOffset = {0, 0, 0};
+				region.extent = {copyExtent.width, copyExtent.height, 1};
+				copy.m_regions.push_back(region);
+			}
+			batch.m_imageCopies.push_back(std::move(copy));
+		}
+
+		// The old image is read by the copies above and by frames in flight
+		VkDevice device = m_lveDevice_.device();
+		m_deletionQueue_.push([device, oldImage = texture.m_image, oldMemory = texture.m_memory]() {
+			vkDestroyImage(device, oldImage, nullptr);
+			vkFreeMemory(device, oldMemory, nullptr);
+		});
+		m_retiredBytes_[frameIndex] += allocatedBytes(texture, oldBase);
+		m_allocatedBytes_ += allocatedBytes(texture, newBase);
+		m_allocatedBytes_ -= allocatedBytes(texture, oldBase);
+
+		// Evicted levels that were still waiting for upload are read again when restored
+		for (uint32_t level = 0; level < newBase; level++) {
+			m_pendingUploadBytes_ -= texture.m_levels[level].size();
+			std::vector<uint8_t>().swap(texture.m_levels[level]);
+		}
+
+		texture.m_image = image;
+		texture.m_memory = memory;
+		texture.m_baseLevel = newBase;
+		texture.m_residentLevel = firstCopied;
+		texture.m_state = texture.m_residentLevel == 0 ? State::Resident : State::Streaming;
+		updateView(texture);
+	}
+
+	void LveTextureManager::scheduleUploads(int frameIndex, TransferBatch &batch) {
+		// Always the smallest level waiting anywhere, so every texture gets a usable level before any
+		// texture gets its large ones
+		std::vector<Upload> uploads;
+		std::vector<TextureId> candidates;
+		for (auto id: m_streaming_) {
+			if (isUploadable(m_textures_[id])) {
+				candidates.push_back(id);
+			}
+		}
+		VkDeviceSize stagingSize = 0;
+		while (!candidates.empty()) {
+			auto next = std::min_element(candidates.begin(), candidates.end(), [this](TextureId a, TextureId b) {
+				return nextUploadSize(m_textures_[a]) < nextUploadSize(m_textures_[b]);
+			});
+			auto &texture = m_textures_[*next];
+			const VkDeviceSize offset = (stagingSize + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+			const VkDeviceSize size = nextUploadSize(texture);
+			if (!uploads.empty() && offset + size > m_settings_.m_uploadBudget) {
+				break;
+			}
+
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = texture.m_image;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			const uint32_t level = texture.m_generateMips ? 0 : texture.m_residentLevel - 1;
+			const uint32_t imageLevel = level - texture.m_baseLevel;
+			if (texture.m_generateMips) {
+				// Every level that is not resident yet is blitted from the first
+				barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.m_residentLevel, 0, 1};
+				batch.m_toTransfer.push_back(barrier);
+				batch.m_mipGenerations.push_back({texture.m_image, texture.m_extent, texture.m_residentLevel});
+
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				if (texture.m_residentLevel > 1) {
+					barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.m_residentLevel - 1, 0, 1};
+					batch.m_toShaderRead.push_back(barrier);
+				}
+				// The last level written is only a blit or copy destination
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, texture.m_residentLevel - 1, 1, 0, 1};
+				batch.m_toShaderRead.push_back(barrier);
+				texture.m_residentLevel = 0;
+			} else {
+				barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, imageLevel, 1, 0, 1};
+				batch.m_toTransfer.push_back(barrier);
+
+				barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				batch.m_toShaderRead.push_back(barrier);
+				texture.m_residentLevel--;
+			}
+
+			auto extent = levelExtent(texture, level);
+			VkBufferImageCopy region{};
+			region.bufferOffset = offset;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, imageLevel, 0, 1};
+			region.imageOffset = {0, 0, 0};
+			region.imageExtent = {extent.width, extent.height, 1};
+			batch.m_bufferCopies.emplace_back(texture.m_image, region);
+
+			uploads.push_back({*next, level, offset});
+			stagingSize = offset + size;
+			if (!isUploadable(texture)) {
+				candidates.erase(next);
+			}
+		}
+		if (uploads.empty()) {
+			return;
+		}
+
+		// This frame's previous uploads have completed, so its staging buffer can be overwritten or replaced
+		auto &staging = m_stagingBuffers_[frameIndex];
+		if (!staging || staging->getBufferSize() < stagingSize) {
+			staging = std::make_unique<LveBuffer>(
+					m_lveDevice_,
+					1,
+					static_cast<uint32_t>(stagingSize),
+					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			staging->map();
+		}
+
+		std::vector<TextureId> updated;
+		for (const auto &upload: uploads) {
+			auto &texture = m_textures_[upload.m_texture];
+			auto &level = texture.m_levels[upload.m_level];
+			staging->writeToBuffer(level.data(), level.size(), upload.m_stagingOffset);
+			m_pendingUploadBytes_ -= level.size();
+			std::vector<uint8_t>().swap(level);
+			if (std::find(updated.begin(), updated.end(), upload.m_texture) == updated.end()) {
+				updated.push_back(upload.m_texture);
+			}
+		}
+
+		// The pass is recorded before anything sampling the new levels, so views can cover them right away
+		for (auto id: updated) {
+			auto &texture = m_textures_[id];
+			updateView(texture);
+			texture.m_state = texture.m_residentLevel == 0 ? State::Resident : State::Streaming;
+		}
+		m_streaming_.erase(std::remove_if(m_streaming_.begin(), m_streaming_.end(), [this](TextureId id) {
+			const auto &levels = m_textures_[id].m_levels;
+			return std::all_of(levels.begin(), levels.end(), [](const auto &level) { return level.empty(); });
+		}), m_streaming_.end());
+	}
+
+	void LveTextureManager::recordBatch(VkCommandBuffer commandBuffer,
+	                                    VkBuffer stagingBuffer,
+	                                    const TransferBatch &batch) {
+		constexpr VkPipelineStageFlags shaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+		                                              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+		                                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		// Images being reallocated may still be sampled by the previous frame
+		vkCmdPipelineBarrier(commandBuffer, shaderStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+		                     static_cast<uint32_t>(batch.m_toTransfer.size()), batch.m_toTransfer.data());
+
+		for (const auto &copy: batch.m_imageCopies) {
+			vkCmdCopyImage(commandBuffer,
+			               copy.m_source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			               copy.m_destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			               static_cast<uint32_t>(copy.m_regions.size()), copy.m_regions.data());
+		}
+		for (const auto &[image, region]: batch.m_bufferCopies) {
+			vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+			                       &region);
+		}
+
+		// Each level is blitted from the one above it, which leaves every level but the last in TRANSFER_SRC
+		for (const auto &generation: batch.m_mipGenerations) {
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = generation.m_image;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			auto width = static_cast<int32_t>(generation.m_extent.width);
+			auto height = static_cast<int32_t>(generation.m_extent.height);
+			for (uint32_t level = 1; level < generation.m_levelCount; level++) {
+				barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 1};
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				                     0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+				VkImageBlit blit{};
+				blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+				blit.srcOffsets[0] = {0, 0, 0};
+				blit.srcOffsets[1] = {width, height, 1};
+				width = std::max(width / 2, 1);
+				height = std::max(height / 2, 1);
+				blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+				blit.dstOffsets[0] = {0, 0, 0};
+				blit.dstOffsets[1] = {width, height, 1};
+				vkCmdBlitImage(commandBuffer,
+				               generation.m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				               generation.m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				               1, &blit, VK_FILTER_LINEAR);
+			}
+		}
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, shaderStages, 0, 0, nullptr, 0, nullptr,
+		                     static_cast<uint32_t>(batch.m_toShaderRead.size()), batch.m_toShaderRead.data());
+	}
+
+	void LveTextureManager::updateView(Texture &texture) {
+		// Frames in flight may still sample through the previous view and its bindless slot
+		if (texture.m_imageView != VK_NULL_HANDLE) {
+			VkDevice device = m_lveDevice_.device();
+			VkImageView retired = texture.m_imageView;
+			m_deletionQueue_.push([device, retired]() { vkDestroyImageView(device, retired, nullptr); });
+			texture.m_imageView = VK_NULL_HANDLE;
+		}
+		if (m_bindlessHeap_ && texture.m_bindlessHandle != m_invalidBindlessHandle) {
+			m_bindlessHeap_->removeTexture(texture.m_bindlessHandle);
+			texture.m_bindlessHandle = m_invalidBindlessHandle;
+		}
+		if (texture.m_residentLevel == texture.m_levelCount) {
+			return;
+		}
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = texture.m_image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = texture.m_format;
+		viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, texture.m_residentLevel - texture.m_baseLevel,
+		                             texture.m_levelCount - texture.m_residentLevel, 0, 1};
+
+		if (vkCreateImageView(m_lveDevice_.device(), &viewInfo, nullptr, &texture.m_imageView) != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create texture image view");
+		}
+		if (m_bindlessHeap_) {
+			texture.m_bindlessHandle = m_bindlessHeap_->addTexture(texture.m_imageView, m_sampler_);
+		}
+	}
+
+	void LveTextureManager::destroy(Texture &texture, bool deferred) {
+		for (const auto &level: texture.m_levels) {
+			m_pendingUploadBytes_ -= level.size();
+		}
+		if (m_bindlessHeap_ && texture.m_bindlessHandle != m_invalidBindlessHandle) {
+			m_bindlessHeap_->removeTexture(texture.m_bindlessHandle);
+		}
+
+		if (texture.m_image != VK_NULL_HANDLE) {
+			m_allocatedBytes_ -= allocatedBytes(texture, texture.m_baseLevel);
+			VkDevice device = m_lveDevice_.device();
+			auto destroyObjects = [device, image = texture.m_image, memory = texture.m_memory,
+					imageView = texture.m_imageView]() {
+				vkDestroyImageView(device, imageView, nullptr);
+				vkDestroyImage(device, image, nullptr);
+				vkFreeMemory(device, memory, nullptr);
+			};
+			if (deferred) {
+				m_deletionQueue_.push(destroyObjects);
+			} else {
+				destroyObjects();
+			}
+		}
+
+		const uint32_t serial = texture.m_serial;
+		texture = Texture{};
+		texture.m_serial = serial + 1;
+	}
+
+	LveTextureManager::Residency LveTextureManager::getResidency(TextureId texture) const {
+		const auto &source = m_textures_[texture];
+		Residency residency{};
+		residency.m_state = source.m_state;
+		residency.m_residentLevel = source.m_residentLevel;
+		residency.m_levelCount = source.m_levelCount;
+		residency.m_allocatedLevel = source.m_baseLevel;
+		residency.m_residentBytes = source.m_image != VK_NULL_HANDLE ? allocatedBytes(source, source.m_residentLevel)
+		                                                             : 0;
+		residency.m_totalBytes = allocatedBytes(source, 0);
+		return residency;
+	}
+
+	VkDescriptorImageInfo LveTextureManager::getDescriptor(TextureId texture) {
+		markUsed(texture);
+		return {m_sampler_, m_textures_[texture].m_imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	}
+}
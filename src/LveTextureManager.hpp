@@ -0,0 +1,289 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVETEXTUREMANAGER_HPP
+#define VULKAN_TEST_LVETEXTUREMANAGER_HPP
+
+#include "LveBindlessHeap.hpp"
+#include "LveBuffer.hpp"
+#include "LveDeletionQueue.hpp"
+#include "LveDevice.hpp"
+#include "LveRenderGraph.hpp"
+
+// std
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+	using TextureId = uint32_t;
+
+	// A 2D texture read from a KTX2 file. m_levels follows the level index of the file, level 0 being the
+	// largest.
+	struct Ktx2Image {
+		static constexpr uint32_t m_supercompressionNone = 0;
+		static constexpr uint32_t m_supercompressionBasisLZ = 1;
+		static constexpr uint32_t m_supercompressionZstd = 2;
+		static constexpr uint32_t m_supercompressionZlib = 3;
+
+		// VK_FORMAT_UNDEFINED for Basis Universal payloads
+		VkFormat m_format = VK_FORMAT_UNDEFINED;
+		VkExtent2D m_extent{0, 0};
+		uint32_t m_supercompressionScheme = m_supercompressionNone;
+		// From the data format descriptor, tells which target format a Basis Universal payload needs
+		bool m_srgb = false;
+		std::vector<uint8_t> m_supercompressionGlobalData;
+		std::vector<std::vector<uint8_t>> m_levels;
+
+		// Throws when the file is not a KTX2 file or holds an array, cube map or 3D texture
+		static Ktx2Image read(const std::string &path);
+
+		bool needsTranscoding() const {
+			return m_format == VK_FORMAT_UNDEFINED || m_supercompressionScheme != m_supercompressionNone;
+		}
+	};
+
+	// Loads KTX2 textures on worker threads and streams their mip levels to the GPU. Levels are uploaded
+	// from the smallest to the largest under a per-frame byte budget, so a texture can be sampled as soon as
+	// its smallest level has arrived and sharpens over the following frames while the frame time stays flat.
+	// The image view of a texture only covers its resident levels and is replaced whenever more arrive.
+	// Textures shipped with a single level get their mip chain generated with blits once it is uploaded.
+	//
+	// Texture memory is kept within the device's memory budget: when usage approaches it, the images of the
+	// least recently used textures are reallocated without their largest levels. Those levels are read
+	// from disk again once the texture is in use and the budget has room for them.
+	class LveTextureManager {
+	public:
+		// Turns image into format in place, for Basis Universal payloads and supercompressed levels. Runs on
+		// the worker threads; applications linking a transcoder such as basisu supply it, without one such
+		// files fail to load.
+		using Transcoder = std::function<void(Ktx2Image &image, VkFormat format)>;
+
+		struct Settings {
+			uint32_t m_workerCount = 2;
+			// Bytes copied into textures per frame; a level larger than this is uploaded alone in its frame
+			VkDeviceSize m_uploadBudget = 8 << 20;
+			Transcoder m_transcoder;
+			// Share of the device local memory budget this process may use before textures are downgraded
+			float m_budgetFraction = 0.9f;
+			// Without VK_EXT_memory_budget only textures are counted, against this share of device local memory
+			float m_textureFractionWithoutBudget = 0.5f;
+			// Levels this large or smaller are never evicted
+			uint32_t m_minimumEvictedExtent = 64;
+		};
+
+		enum class State {
+			Loading,
+			// Not every level is resident, either waiting for upload budget or evicted
+			Streaming,
+			Resident,
+			Failed,
+		};
+
+		struct Residency {
+			State m_state = State::Loading;
+			// Largest level that can be sampled; equal to m_levelCount while none can
+			uint32_t m_residentLevel = 0;
+			uint32_t m_levelCount = 0;
+			// Largest level the image has memory for; levels above it have been evicted
+			uint32_t m_allocatedLevel = 0;
+			VkDeviceSize m_residentBytes = 0;
+			VkDeviceSize m_totalBytes = 0;
+		};
+
+		static constexpr uint32_t m_invalidBindlessHandle = ~0u;
+
+		// Resident textures are added to bindlessHeap when there is one. Replaced views are retired to
+		// deletionQueue, which must be the queue of the renderer recording the uploads.
+		LveTextureManager(LveDevice &device,
+		                  LveDeletionQueue &deletionQueue,
+		                  LveBindlessHeap *bindlessHeap,
+		                  Settings settings);
+
+		// The device must be idle
+		~LveTextureManager();
+
+		LveTextureManager(const LveTextureManager &) = delete;
+
+		LveTextureManager &operator=(const LveTextureManager &) = delete;
+
+		// Queues path for loading; the texture has no view until its first upload
+		TextureId load(const std::string &path);
+
+		// Must be called while a frame is being recorded, the texture is destroyed once it has completed
+		void unload(TextureId texture);
+
+		// Creates the images of textures whose files have been read since the previous frame, and picks the
+		// textures to downgrade or restore; the fence of frameIndex must have been waited on
+		void beginFrame(int frameIndex);
+
+		// Records that texture is sampled in the current frame, which keeps it from being evicted
+		void markUsed(TextureId texture) { m_textures_[texture].m_lastUsedFrame = m_frameNumber_; }
+
+		// Declares a pass copying the next levels into their images within the upload budget. Declare it
+		// before the passes sampling textures, descriptors taken afterwards already include the new levels.
+		void addUploadPass(LveRenderGraph &graph, int frameIndex);
+
+		Residency getResidency(TextureId texture) const;
+
+		// The resident levels of texture, with a null view until the first of them has been uploaded. Marks
+		// texture as used in the current frame, so take it only for textures that are sampled.
+		VkDescriptorImageInfo getDescriptor(TextureId texture);
+
+		// Changes whenever levels become resident, so it should be read every frame. Marks texture as used in
+		// the current frame like getDescriptor().
+		uint32_t getBindlessHandle(TextureId texture) {
+			markUsed(texture);
+			return m_textures_[texture].m_bindlessHandle;
+		}
+
+		// Bytes read from disk and not yet copied into images
+		VkDeviceSize getPendingUploadBytes() const { return m_pendingUploadBytes_; }
+
+		// Device memory of every texture image, excluding images retired but not yet destroyed
+		VkDeviceSize getAllocatedBytes() const { return m_allocatedBytes_; }
+
+	private:
+		struct Texture {
+			State m_state = State::Loading;
+			// Bumped whenever the id is unloaded, so results of reads issued before are discarded
+			uint32_t m_serial = 0;
+			std::string m_path;
+			VkFormat m_format = VK_FORMAT_UNDEFINED;
+			VkExtent2D m_extent{0, 0};
+			uint32_t m_levelCount = 0;
+			// The file has only the first level, the others are blitted from it
+			bool m_generateMips = false;
+			VkImage m_image = VK_NULL_HANDLE;
+			VkDeviceMemory m_memory = VK_NULL_HANDLE;
+			VkImageView m_imageView = VK_NULL_HANDLE;
+			uint32_t m_bindlessHandle = m_invalidBindlessHandle;
+			// Level stored as level 0 of m_image, and the one it is reallocated for in the next upload pass
+			uint32_t m_baseLevel = 0;
+			uint32_t m_pendingBaseLevel = 0;
+			uint32_t m_residentLevel = 0;
+			// Contents of the levels that have not been uploaded yet
+			std::vector<std::vector<uint8_t>> m_levels;
+			std::vector<VkDeviceSize> m_levelBytes;
+			uint64_t m_lastUsedFrame = 0;
+			// Evicted levels are being read again
+			bool m_reloading = false;
+			bool m_reloadFailed = false;
+		};
+
+		struct LoadRequest {
+			TextureId m_texture;
+			uint32_t m_serial;
+			std::string m_path;
+		};
+
+		struct LoadResult {
+			TextureId m_texture;
+			uint32_t m_serial;
+			Ktx2Image m_image;
+			// Empty when the file was read
+			std::string m_error;
+		};
+
+		struct Upload {
+			TextureId m_texture;
+			uint32_t m_level;
+			VkDeviceSize m_stagingOffset;
+		};
+
+		// Levels kept when a texture is reallocated
+		struct ImageCopy {
+			VkImage m_source;
+			VkImage m_destination;
+			std::vector<VkImageCopy> m_regions;
+		};
+
+		// Fills levels 1 to m_levelCount - 1 of m_image by blitting down from level 0
+		struct MipGeneration {
+			VkImage m_image;
+			VkExtent2D m_extent;
+			uint32_t m_levelCount;
+		};
+
+		// Commands of an upload pass, recorded in this order
+		struct TransferBatch {
+			std::vector<VkImageMemoryBarrier> m_toTransfer;
+			std::vector<ImageCopy> m_imageCopies;
+			std::vector<std::pair<VkImage, VkBufferImageCopy>> m_bufferCopies;
+			std::vector<MipGeneration> m_mipGenerations;
+			std::vector<VkImageMemoryBarrier> m_toShaderRead;
+		};
+
+		void work();
+
+		Ktx2Image readTexture(const std::string &path) const;
+
+		void createImage(Texture &texture, Ktx2Image &image);
+
+		void restoreLevels(TextureId id, Ktx2Image &image);
+
+		void balanceMemory();
+
+		void requestRead(TextureId texture);
+
+		void reallocate(Texture &texture, int frameIndex, TransferBatch &batch);
+
+		void scheduleUploads(int frameIndex, TransferBatch &batch);
+
+		static void recordBatch(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, const TransferBatch &batch);
+
+		void updateView(Texture &texture);
+
+		void destroy(Texture &texture, bool deferred);
+
+		bool isUploadable(const Texture &texture) const;
+
+		VkDeviceSize nextUploadSize(const Texture &texture) const;
+
+		VkDeviceSize allocatedBytes(const Texture &texture, uint32_t baseLevel) const;
+
+		static VkExtent2D levelExtent(const Texture &texture, uint32_t level);
+
+		void createSampler();
+
+		LveDevice &m_lveDevice_;
+		LveDeletionQueue &m_deletionQueue_;
+		LveBindlessHeap *m_bindlessHeap_;
+		Settings m_settings_;
+		VkSampler m_sampler_ = VK_NULL_HANDLE;
+		// Targets of Basis Universal payloads on this device
+		VkFormat m_transcodeFormat_ = VK_FORMAT_R8G8B8A8_UNORM;
+		VkFormat m_transcodeFormatSrgb_ = VK_FORMAT_R8G8B8A8_SRGB;
+
+		std::vector<Texture> m_textures_;
+		std::vector<TextureId> m_freeTextures_;
+		// Textures with levels left to upload
+		std::vector<TextureId> m_streaming_;
+		// Textures whose m_pendingBaseLevel differs from m_baseLevel
+		std::vector<TextureId> m_reallocating_;
+		VkDeviceSize m_pendingUploadBytes_ = 0;
+		VkDeviceSize m_allocatedBytes_ = 0;
+		uint64_t m_frameNumber_ = 0;
+		// Indexed by frame in flight; a frame's staging buffer is free again once its fence has been waited on
+		std::vector<std::unique_ptr<LveBuffer>> m_stagingBuffers_;
+		// Image memory retired while recording each frame in flight, still counted in the device's usage
+		std::vector<VkDeviceSize> m_retiredBytes_;
+
+		// Guards both queues
+		std::mutex m_mutex_;
+		std::condition_variable m_requestQueued_;
+		std::deque<LoadRequest> m_requests_;
+		std::vector<LoadResult> m_results_;
+		bool m_stopping_ = false;
+		std::vector<std::thread> m_workers_;
+	};
+}
+
+#endif //VULKAN_TEST_LVETEXTUREMANAGER_HPP
@@ -0,0 +1,104 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVETRANSFORM_HPP
+#define VULKAN_TEST_LVETRANSFORM_HPP
+
+// libs
+#include "glm/gtc/constants.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+namespace lve {
+
+	struct TransformComponent {
+		glm::vec3 m_translation{};
+		glm::vec3 m_scale{1.f, 1.f, 1.f};
+		glm::vec3 m_rotation{};
+
+		// Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
+		// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
+		// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+		glm::mat4 mat4() const {
+			const float c3 = glm::cos(m_rotation.z);
+			const float s3 = glm::sin(m_rotation.z);
+			const float c2 = glm::cos(m_rotation.x);
+			const float s2 = glm::sin(m_rotation.x);
+			const float c1 = glm::cos(m_rotation.y);
+			const float s1 = glm::sin(m_rotation.y);
+			return glm::mat4{
+					{
+							m_scale.x * (c1 * c3 + s1 * s2 * s3),
+							                 m_scale.x * (c2 * s3),
+							                                  m_scale.x * (c1 * s2 * s3 - c3 * s1),
+							                                                   0.0f,
+					},
+					{
+							m_scale.y * (c3 * s1 * s2 - c1 * s3),
+							                 m_scale.y * (c2 * c3),
+							                                  m_scale.y * (c1 * c3 * s2 + s1 * s3),
+							                                                   0.0f,
+					},
+					{
+							m_scale.z * (c2 * s1),
+							                 m_scale.z * (-s2),
+							                                  m_scale.z * (c1 * c2),
+							                                                   0.0f,
+					},
+					{       m_translation.x, m_translation.y, m_translation.z, 1.0f}};
+		}
+
+		bool operator==(const TransformComponent &other) const {
+			return m_translation == other.m_translation && m_scale == other.m_scale && m_rotation == other.m_rotation;
+		}
+	};
+
+	// Blends the angles along the shorter way around, so a yaw wrapping from 2 pi to 0 does not spin back
+	inline TransformComponent interpolate(const TransformComponent &from, const TransformComponent &to, float alpha) {
+		glm::vec3 rotation;
+		for (int i = 0; i < 3; i++) {
+			float delta = glm::mod(to.m_rotation[i] - from.m_rotation[i] + glm::pi<float>(), glm::two_pi<float>()) -
+			              glm::pi<float>();
+			rotation[i] = from.m_rotation[i] + delta * alpha;
+		}
+		return {glm::mix(from.m_translation, to.m_translation, alpha), glm::mix(from.m_scale, to.m_scale, alpha),
+		        rotation};
+	}
+
+	// Blends two affine matrices by lerping translation and axis scales and slerping rotation. Shear, which
+	// non-uniformly scaled parents can introduce, is not preserved.
+	inline glm::mat4 interpolate(const glm::mat4 &from, const glm::mat4 &to, float alpha) {
+		if (from == to) {
+			return to;
+		}
+
+		auto decompose = [](const glm::mat4 &matrix, glm::vec3 &scale, glm::quat &rotation) {
+			glm::mat3 axes{glm::vec3{matrix[0]}, glm::vec3{matrix[1]}, glm::vec3{matrix[2]}};
+			scale = {glm::length(axes[0]), glm::length(axes[1]), glm::length(axes[2])};
+			if (scale.x == 0.f || scale.y == 0.f || scale.z == 0.f) {
+				return false;
+			}
+			// A mirrored basis is not a rotation; flip one axis into the scale
+			if (glm::determinant(axes) < 0.f) {
+				scale.x = -scale.x;
+			}
+			rotation = glm::quat_cast(glm::mat3{axes[0] / scale.x, axes[1] / scale.y, axes[2] / scale.z});
+			return true;
+		};
+		glm::vec3 fromScale, toScale;
+		glm::quat fromRotation, toRotation;
+		if (!decompose(from, fromScale, fromRotation) || !decompose(to, toScale, toRotation)) {
+			return alpha < .5f ? from : to;
+		}
+
+		const glm::vec3 scale = glm::mix(fromScale, toScale, alpha);
+		const glm::mat4 rotation = glm::mat4_cast(glm::slerp(fromRotation, toRotation, alpha));
+		return glm::mat4{rotation[0] * scale.x,
+		                 rotation[1] * scale.y,
+		                 rotation[2] * scale.z,
+		                 glm::vec4{glm::mix(glm::vec3{from[3]}, glm::vec3{to[3]}, alpha), 1.f}};
+	}
+}
+
+#endif //VULKAN_TEST_LVETRANSFORM_HPP
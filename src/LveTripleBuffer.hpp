@@ -0,0 +1,100 @@
+//
+// Created by wdoppenberg on 19-10-26.
+//
+
+#ifndef VULKAN_TEST_LVETRIPLEBUFFER_HPP
+#define VULKAN_TEST_LVETRIPLEBUFFER_HPP
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace lve {
+
+	// Hands values from one producer thread to one consumer thread without locks. The producer fills the
+	// write buffer and publishes it, the consumer acquires the latest published buffer and reads it until
+	// its next acquire. Neither ever touches the buffer the other one holds; the third buffer is swapped
+	// between them through a single atomic word.
+	template<typename T>
+	class LveTripleBuffer {
+	public:
+		LveTripleBuffer() = default;
+
+		LveTripleBuffer(const LveTripleBuffer &) = delete;
+
+		LveTripleBuffer &operator=(const LveTripleBuffer &) = delete;
+
+		// Producer only; keeps the contents it had when it was last handed back, so reuse them with care
+		T &getWriteBuffer() { return m_buffers_[m_writeIndex_]; }
+
+		// Producer only
+		void publish() {
+			uint32_t shared = m_shared_.load(std::memory_order_relaxed);
+			uint32_t published;
+			do {
+				published = m_writeIndex_ | m_freshBit | (shared & m_closedBit);
+			} while (!m_shared_.compare_exchange_weak(shared, published, std::memory_order_acq_rel));
+			m_writeIndex_ = shared & m_indexMask;
+			m_shared_.notify_all();
+		}
+
+		// Consumer only; returns false, keeping the current read buffer, when nothing was published since
+		bool acquire() {
+			uint32_t shared = m_shared_.load(std::memory_order_relaxed);
+			do {
+				if (!(shared & m_freshBit)) {
+					return false;
+				}
+			} while (!m_shared_.compare_exchange_weak(shared, m_readIndex_ | (shared & m_closedBit),
+			                                          std::memory_order_acq_rel));
+			m_readIndex_ = shared & m_indexMask;
+			m_shared_.notify_all();
+			return true;
+		}
+
+		// Consumer only
+		const T &getReadBuffer() const { return m_buffers_[m_readIndex_]; }
+
+		// Consumer side; returns once a buffer is ready to acquire or the buffer has been closed
+		void waitForPublish() const {
+			waitWhile([](uint32_t shared) { return !(shared & m_freshBit); });
+		}
+
+		// Producer side; returns once the last published buffer has been acquired or the buffer has been
+		// closed, which keeps the producer at most one buffer ahead
+		void waitForAcquire() const {
+			waitWhile([](uint32_t shared) { return (shared & m_freshBit) != 0; });
+		}
+
+		// Either side; wakes up the other one for good, a buffer published before can still be acquired
+		void close() {
+			m_shared_.fetch_or(m_closedBit, std::memory_order_acq_rel);
+			m_shared_.notify_all();
+		}
+
+		bool isClosed() const { return (m_shared_.load(std::memory_order_acquire) & m_closedBit) != 0; }
+
+	private:
+		static constexpr uint32_t m_indexMask = 0x3;
+		static constexpr uint32_t m_freshBit = 0x4;
+		static constexpr uint32_t m_closedBit = 0x8;
+
+		template<typename Predicate>
+		void waitWhile(Predicate predicate) const {
+			uint32_t shared = m_shared_.load(std::memory_order_acquire);
+			while (!(shared & m_closedBit) && predicate(shared)) {
+				m_shared_.wait(shared, std::memory_order_acquire);
+				shared = m_shared_.load(std::memory_order_acquire);
+			}
+		}
+
+		std::array<T, 3> m_buffers_{};
+		uint32_t m_writeIndex_ = 0;
+		// Index of the buffer in between, plus the flags
+		std::atomic<uint32_t> m_shared_{1};
+		uint32_t m_readIndex_ = 2;
+	};
+}
+
+#endif //VULKAN_TEST_LVETRIPLEBUFFER_HPP
@@ -5,13 +5,18 @@
 
 
 namespace lve {
-    LveWindow::LveWindow(int w, int h, std::string name) : m_width_{w}, m_height_{h}, m_windowName_{std::move(name)} {
-	    initWindow();
+    LveWindow::LveWindow(int w, int h, std::string name, bool headless)
+		    : m_headless_{headless}, m_width_{w}, m_height_{h}, m_windowName_{std::move(name)} {
+	    if (!m_headless_) {
+		    initWindow();
+	    }
     };
 
     LveWindow::~LveWindow() {
-	    glfwDestroyWindow(m_window_);
-	    glfwTerminate();
+	    if (!m_headless_) {
+		    glfwDestroyWindow(m_window_);
+		    glfwTerminate();
+	    }
     }
 
     void LveWindow::initWindow() {
@@ -32,8 +37,9 @@ namespace lve {
 
     void LveWindow::frameBufferResizeCallback(GLFWwindow *window, int width, int height) {
 	    auto lveWindow = reinterpret_cast<LveWindow *>(glfwGetWindowUserPointer(window));
-	    lveWindow->m_frameBufferResized_ = true;
 	    lveWindow->m_width_ = width;
 	    lveWindow->m_height_ = height;
+	    // Set last, so whoever sees the flag also sees the new size
+	    lveWindow->m_frameBufferResized_ = true;
     }
 }
\ No newline at end of file
@@ -9,12 +9,14 @@
 
 #include <GLFW/glfw3.h>
 
+#include <atomic>
 #include <string>
 
 namespace lve {
     class LveWindow {
     public:
-        LveWindow(int w, int h, std::string name);
+        // A headless window opens nothing and needs no display; the device then renders to offscreen images
+        LveWindow(int w, int h, std::string name, bool headless = false);
 
         ~LveWindow();
 
@@ -25,9 +27,19 @@ namespace lve {
         void initWindow();
 
         bool shouldClose() {
-            return glfwWindowShouldClose(m_window_);
+            return m_window_ != nullptr && glfwWindowShouldClose(m_window_);
         }
 
+	    bool isHeadless() const { return m_headless_; }
+
+	    // Main thread only
+	    void pollEvents() {
+		    if (!m_headless_) {
+			    glfwPollEvents();
+		    }
+	    }
+
+	    // The size and resize flag are written while the main thread polls events and may be read from any thread
 	    VkExtent2D getExtent() const {
 		    return {static_cast<uint32_t>(m_width_), static_cast<uint32_t>(m_height_)};
 	    }
@@ -36,6 +48,7 @@ namespace lve {
 
 	    void resetWindowResizedFlag() { m_frameBufferResized_ = false; }
 
+	    // Null for a headless window
 	    GLFWwindow *getWindow() const { return m_window_; }
 
 	    void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
@@ -43,9 +56,10 @@ namespace lve {
     private:
 	    static void frameBufferResizeCallback(GLFWwindow *window, int width, int height);
 
-	    GLFWwindow *m_window_;
-	    int m_width_, m_height_;
-	    bool m_frameBufferResized_ = false;
+	    GLFWwindow *m_window_ = nullptr;
+	    bool m_headless_;
+	    std::atomic<int> m_width_, m_height_;
+	    std::atomic<bool> m_frameBufferResized_{false};
 
 	    std::string m_windowName_;
 
@@ -3,6 +3,9 @@
 //
 
 #include "RenderSystem.hpp"
+#include "LveShaderCode.hpp"
+#include "LveShaderReflection.hpp"
+#include "LveSwapChain.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -10,36 +13,138 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+// std
+#include <algorithm>
+#include <iostream>
+
 namespace lve {
-	struct SimplePushConstantData {
-		glm::mat4 m_transform{1.f};
-		alignas(16) glm::vec3 m_color;
-	};
+	namespace {
+		constexpr VkDeviceSize initialFrameAllocatorCapacity = 64 * 1024;
+		// Objects frustum culled per job
+		constexpr uint32_t cullGrainSize = 256;
+
+		// Mirrors GlobalUbo in simple_vertex.vert (std140)
+		struct GlobalUbo {
+			glm::mat4 m_projectionView{1.f};
+		};
+
+		// Mirrors ObjectData in simple_vertex.vert (std430), indexed with the instance index of each draw
+		struct ObjectData {
+			glm::mat4 m_model{1.f};
+			glm::vec4 m_color{0.f};
+			uint32_t m_material;
+			// Bindless handle of the texture, LveTextureManager::m_invalidBindlessHandle for none
+			uint32_t m_texture;
+			uint32_t m_pad1;
+			uint32_t m_pad2;
+		};
+
+		// Mirrors Material in simple_bindless.frag (std430)
+		struct MaterialData {
+			glm::vec4 m_baseColor{1.f};
+		};
+
+		// constant_id of debugView in simple_fragment.frag and simple_bindless.frag
+		constexpr uint32_t debugViewConstantId = 0;
+
+		SpecializationConstants debugViewConstants(RenderSystem::DebugView debugView) {
+			SpecializationConstants constants{};
+			constants.set(debugViewConstantId, static_cast<uint32_t>(debugView));
+			return constants;
+		}
 
+		static_assert(sizeof(ObjectData) == 96, "ObjectData must match the std430 layout in simple_vertex.vert");
+	}
 
-	RenderSystem::RenderSystem(LveDevice &device, VkRenderPass renderPass) : m_lveDevice_{device} {
+	RenderSystem::RenderSystem(LveDevice &device,
+	                           const RenderTargetInfo &renderTarget,
+	                           LvePipelineCompiler &pipelineCompiler,
+	                           LveBindlessHeap *bindlessHeap,
+	                           LveTextureManager *textureManager,
+	                           LveJobSystem *jobSystem)
+			: m_lveDevice_{device},
+			  m_renderTarget_{renderTarget},
+			  m_vertFilePath_{"src/shaders/simple_vertex.vert.spv"},
+			  m_fragFilePath_{bindlessHeap ? "src/shaders/simple_bindless.frag.spv"
+			                               : "src/shaders/simple_fragment.frag.spv"},
+			  m_pipelineCompiler_{pipelineCompiler},
+			  m_frameAllocator_{device, initialFrameAllocatorCapacity},
+			  m_bindlessHeap_{bindlessHeap},
+			  m_textureManager_{textureManager},
+			  m_jobSystem_{jobSystem} {
+		createDescriptorSets();
+		createDefaultMaterial();
 		createPipelineLayout();
-		createPipeline(renderPass);
+		m_pipelines_ = compilePipelines();
 	}
 
 	RenderSystem::~RenderSystem() {
+		// Pending compile jobs still use the pipeline layout
+		m_pendingPipelines_.reset();
+		m_pipelines_ = Pipelines{};
+		if (m_bindlessHeap_) {
+			m_bindlessHeap_->removeBuffer(m_defaultMaterial_);
+		}
 		vkDestroyPipelineLayout(m_lveDevice_.device(), m_pipelineLayout_, nullptr);
 	}
 
-	void RenderSystem::createPipelineLayout() {
+	void RenderSystem::createDefaultMaterial() {
+		if (!m_bindlessHeap_) {
+			return;
+		}
 
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(SimplePushConstantData);
+		m_defaultMaterialBuffer_ = std::make_unique<LveBuffer>(
+				m_lveDevice_,
+				sizeof(MaterialData),
+				1,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		MaterialData material{};
+		m_defaultMaterialBuffer_->map();
+		m_defaultMaterialBuffer_->writeToBuffer(&material);
+		m_defaultMaterialBuffer_->unmap();
 
+		m_defaultMaterial_ = m_bindlessHeap_->addBuffer(m_defaultMaterialBuffer_->descriptorInfo());
+	}
+
+	void RenderSystem::createDescriptorSets() {
+		m_setLayout_ = LveDescriptorSetLayout::Builder(m_lveDevice_)
+				.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+				.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+				.build();
+
+		m_descriptorPool_ = LveDescriptorPool::Builder(m_lveDevice_)
+				.setMaxSets(LveSwapChain::m_maxFramesInFlight)
+				.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::m_maxFramesInFlight)
+				.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, LveSwapChain::m_maxFramesInFlight)
+				.build();
+
+		m_descriptorSets_.resize(LveSwapChain::m_maxFramesInFlight);
+		for (auto &set: m_descriptorSets_) {
+			if (!m_descriptorPool_->allocateDescriptorSet(m_setLayout_->getDescriptorSetLayout(), set)) {
+				throw std::runtime_error("Failed to allocate descriptor sets");
+			}
+		}
+	}
+
+	void RenderSystem::createPipelineLayout() {
+		std::vector<VkDescriptorSetLayout> setLayouts{m_setLayout_->getDescriptorSetLayout()};
+		if (m_bindlessHeap_) {
+			setLayouts.push_back(m_bindlessHeap_->getDescriptorSetLayout());
+		}
+
+		// The set layouts belong to this system, so the layout is not shared through the device's layout
+		// cache, but push constants still follow whatever the shaders declare
+		std::vector<ShaderReflection> shaders{reflectShaderFile(m_vertFilePath_), reflectShaderFile(m_fragFilePath_)};
+		auto pushConstantRanges = LvePipelineLayoutCache::getPushConstantRanges(shaders);
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 0;
-		pipelineLayoutInfo.pSetLayouts = nullptr;
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 
 		if (vkCreatePipelineLayout(m_lveDevice_.device(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout_) !=
 		    VK_SUCCESS) {
@@ -47,44 +152,254 @@ namespace lve {
 		}
 	}
 
-	void RenderSystem::createPipeline(VkRenderPass renderPass) {
+	RenderSystem::Pipelines RenderSystem::compilePipelines() {
 #ifndef NDEBUG
 		assert(m_pipelineLayout_ != nullptr && "Cannot create pipeline before pipeline layout");
 #endif
-		PipelineConfigInfo pipelineConfig{};
-		LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.m_renderPass = renderPass;
-		pipelineConfig.m_pipelineLayout = m_pipelineLayout_;
-		m_lvePipeline_ = std::make_unique<LvePipeline>(
-				m_lveDevice_,
-				"src/shaders/simple_vertex.vert.spv",
-				"src/shaders/simple_fragment.frag.spv",
-				pipelineConfig
-		);
+		RenderTargetInfo renderTarget = m_renderTarget_;
+		VkPipelineLayout pipelineLayout = m_pipelineLayout_;
+
+		Pipelines pipelines{};
+		pipelines.m_opaque = std::make_unique<LvePipelineVariants>(
+				m_pipelineCompiler_, m_vertFilePath_, m_fragFilePath_,
+				[renderTarget, pipelineLayout](PipelineConfigInfo &pipelineConfig) {
+					LvePipeline::setRenderTarget(pipelineConfig, renderTarget);
+					pipelineConfig.m_pipelineLayout = pipelineLayout;
+				});
+		pipelines.m_transparent = std::make_unique<LvePipelineVariants>(
+				m_pipelineCompiler_, m_vertFilePath_, m_fragFilePath_,
+				[renderTarget, pipelineLayout](PipelineConfigInfo &transparentConfig) {
+					LvePipeline::enableAlphaBlending(transparentConfig);
+					LvePipeline::setRenderTarget(transparentConfig, renderTarget);
+					transparentConfig.m_pipelineLayout = pipelineLayout;
+				});
+
+		// Start compiling the shaded variants, every other view falls back to them
+		auto shadedConstants = debugViewConstants(DebugView::Shaded);
+		pipelines.m_opaque->get({}, shadedConstants);
+		pipelines.m_transparent->get({}, shadedConstants);
+		return pipelines;
 	}
 
+	void RenderSystem::reloadShaders(const std::vector<std::string> &changedShaders,
+	                                 LveDeletionQueue &deletionQueue) {
+		// Changes that arrive while a reload is compiling are picked up by the next one
+		m_reloadRequested_ |= std::any_of(changedShaders.begin(), changedShaders.end(),
+		                                  [&](const std::string &shaderName) {
+			                                  return shaderName == LveShaderCode::shaderName(m_vertFilePath_) ||
+			                                         shaderName == LveShaderCode::shaderName(m_fragFilePath_);
+		                                  });
 
-	void RenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &gameObjects,
-	                                     const LveCamera &camera) {
-		m_lvePipeline_->bind(commandBuffer);
+		if (m_pendingPipelines_) {
+			// Swap once the variants currently on screen are ready, the others are recompiled on demand
+			auto fragConstants = debugViewConstants(m_debugView_);
+			auto &opaque = m_pendingPipelines_->m_opaque->get({}, fragConstants);
+			auto &transparent = m_pendingPipelines_->m_transparent->get({}, fragConstants);
+			if (!opaque.isReady() || !transparent.isReady()) {
+				return;
+			}
 
-		auto projectionView = camera.getProjection() * camera.getView();
+			try {
+				opaque.wait();
+				transparent.wait();
+				deletionQueue.retire(std::make_unique<Pipelines>(std::move(m_pipelines_)));
+				m_pipelines_ = std::move(*m_pendingPipelines_);
+			} catch (const std::exception &e) {
+				std::cerr << "Shader reload failed, keeping the previous pipelines: " << e.what() << std::endl;
+			}
+			m_pendingPipelines_.reset();
+		}
+
+		if (m_reloadRequested_) {
+			m_pendingPipelines_ = compilePipelines();
+			m_reloadRequested_ = false;
+		}
+	}
+
+	void RenderSystem::waitForDebugView() {
+		auto fragConstants = debugViewConstants(m_debugView_);
+		m_pipelines_.m_opaque->get({}, fragConstants).wait();
+		m_pipelines_.m_transparent->get({}, fragConstants).wait();
+	}
+
+	void RenderSystem::addRenderPass(LveRenderGraph &graph,
+	                                 FrameInfo &frameInfo,
+	                                 const std::vector<RenderObject> &renderObjects,
+	                                 RenderGraphResource color,
+	                                 RenderGraphResource depth) {
+		graph.addPass("render game objects", LveRenderGraph::PassType::Raster,
+		              [&](RenderGraphPassBuilder &pass) {
+			              pass.colorAttachment(color, VK_ATTACHMENT_LOAD_OP_CLEAR, {{0.01f, 0.01f, 0.01f, 1.0f}})
+					              .depthAttachment(depth, VK_ATTACHMENT_LOAD_OP_CLEAR);
+		              },
+		              [this, frameInfo, &renderObjects](VkCommandBuffer commandBuffer) mutable {
+			              frameInfo.m_commandBuffer = commandBuffer;
+			              renderGameObjects(frameInfo, renderObjects);
+		              });
+	}
+
+	void RenderSystem::renderGameObjects(FrameInfo &frameInfo, const std::vector<RenderObject> &renderObjects) {
+		auto fragConstants = debugViewConstants(m_debugView_);
+		LvePipeline *opaquePipeline = m_pipelines_.m_opaque->get({}, fragConstants).get();
+		if (!opaquePipeline) {
+			opaquePipeline = &m_pipelines_.m_opaque->get({}, debugViewConstants(DebugView::Shaded)).wait();
+		}
+		opaquePipeline->bind(frameInfo.m_commandBuffer);
+		m_meshletCuller_.beginFrame(frameInfo.m_frameIndex);
+		m_frameAllocator_.beginFrame(frameInfo.m_frameIndex);
+
+		auto projectionView = frameInfo.m_camera.getProjection() * frameInfo.m_camera.getView();
+		auto frustum = LveFrustum::fromMatrix(projectionView);
+		auto cameraPosition = frameInfo.m_camera.getPosition();
 
-		for (auto &obj: gameObjects) {
-			SimplePushConstantData push{};
-			push.m_color = obj.m_color;
-			push.m_transform = projectionView * obj.m_transform.mat4();
+		GlobalUbo ubo{};
+		ubo.m_projectionView = projectionView;
+		auto uboAllocation = m_frameAllocator_.upload(ubo);
 
-			vkCmdPushConstants(commandBuffer,
-			                   m_pipelineLayout_,
-			                   VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-			                   0,
-			                   sizeof(SimplePushConstantData),
-			                   &push);
+		// A zero sized range is not a valid descriptor, so always reserve at least one object
+		auto objectAllocation = m_frameAllocator_.allocate(
+				sizeof(ObjectData) * std::max<size_t>(renderObjects.size(), 1));
+		auto *objects = static_cast<ObjectData *>(objectAllocation.m_data);
 
-			obj.m_model->bind(commandBuffer);
-			obj.m_model->draw(commandBuffer);
+		// The set of this frame index is no longer in use once its fence has been waited on
+		auto uboInfo = uboAllocation.descriptorInfo();
+		auto objectInfo = objectAllocation.descriptorInfo();
+		VkDescriptorSet descriptorSet = m_descriptorSets_[frameInfo.m_frameIndex];
+		LveDescriptorWriter(*m_setLayout_, *m_descriptorPool_)
+				.writeBuffer(0, &uboInfo)
+				.writeBuffer(1, &objectInfo)
+				.overwrite(descriptorSet);
+
+		vkCmdBindDescriptorSets(frameInfo.m_commandBuffer,
+		                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+		                        m_pipelineLayout_,
+		                        0, 1, &descriptorSet,
+		                        0, nullptr);
+		if (m_bindlessHeap_) {
+			m_bindlessHeap_->bind(frameInfo.m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout_, 1);
 		}
 
+		// Culling only writes the state of its own objects, so it runs in parallel; the queues, model ids and
+		// texture residency are then filled in on this thread
+		const auto objectCount = static_cast<uint32_t>(renderObjects.size());
+		const glm::mat4 &view = frameInfo.m_camera.getView();
+		m_visibility_.resize(objectCount);
+		auto cullObjects = [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++) {
+				auto &obj = renderObjects[i];
+				m_visibility_[i] = {false, 0.f};
+				if (!obj.m_model) {
+					continue;
+				}
+				const auto &modelMatrix = obj.m_worldMatrix;
+
+				auto sphere = obj.m_model->getBoundingSphere();
+				glm::vec3 center{modelMatrix * glm::vec4{glm::vec3{sphere}, 1.f}};
+				// Parents may scale too, so the radius grows with the longest axis of the world matrix
+				float scale = glm::max(glm::max(glm::length(glm::vec3{modelMatrix[0]}),
+				                                glm::length(glm::vec3{modelMatrix[1]})),
+				                       glm::length(glm::vec3{modelMatrix[2]}));
+				if (!frustum.intersectsSphere(center, sphere.w * scale)) {
+					continue;
+				}
+
+				objects[i].m_model = modelMatrix;
+				objects[i].m_color = glm::vec4{obj.m_color, obj.m_opacity};
+				objects[i].m_material = m_defaultMaterial_;
+				m_visibility_[i] = {true, (view * glm::vec4{center, 1.f}).z};
+			}
+		};
+		if (m_jobSystem_) {
+			m_jobSystem_->parallelFor(objectCount, cullGrainSize, cullObjects);
+		} else {
+			cullObjects(0, objectCount);
+		}
+
+		// Queue the visible objects: opaque ones sorted by state and then front to back, blended ones back to
+		// front so they composite correctly
+		m_opaqueQueue_.clear();
+		m_transparentQueue_.clear();
+		m_modelIds_.clear();
+		for (uint32_t i = 0; i < objectCount; i++) {
+			if (!m_visibility_[i].m_visible) {
+				continue;
+			}
+			auto &obj = renderObjects[i];
+
+			// Taking the handle marks the texture as used, so only visible objects keep theirs resident
+			objects[i].m_texture = m_textureManager_ && obj.m_texture != ~0u
+			                       ? m_textureManager_->getBindlessHandle(obj.m_texture)
+			                       : LveTextureManager::m_invalidBindlessHandle;
+
+			auto [modelId, inserted] = m_modelIds_.try_emplace(obj.m_model.get(),
+			                                                   static_cast<uint32_t>(m_modelIds_.size()));
+			float viewDepth = m_visibility_[i].m_viewDepth;
+			if (obj.m_opacity < 1.f) {
+				m_transparentQueue_.push(
+						LveRenderQueue::makeTransparentKey(0, m_defaultMaterial_, modelId->second, viewDepth), i);
+			} else {
+				m_opaqueQueue_.push(LveRenderQueue::makeKey(0, m_defaultMaterial_, modelId->second, viewDepth), i);
+			}
+		}
+		m_opaqueQueue_.sort(m_jobSystem_);
+		m_transparentQueue_.sort(m_jobSystem_);
+
+		// The meshlets of the queued objects are culled up front, in the order they are drawn. objects is
+		// mapped device memory, which is slow to read back, so the matrices come from the snapshot.
+		m_meshletRequests_.clear();
+		for (const auto *queue: {&m_opaqueQueue_, &m_transparentQueue_}) {
+			for (const auto &item: queue->items()) {
+				auto &obj = renderObjects[item.m_index];
+				if (obj.m_model->hasMeshlets()) {
+					m_meshletRequests_.push_back({&obj.m_model->getMeshletData(), obj.m_worldMatrix});
+				}
+			}
+		}
+		m_meshletCuller_.cull(m_meshletRequests_, frustum, cameraPosition, m_meshletRanges_, m_jobSystem_);
+
+		m_renderStats_ = {};
+		m_renderStats_.m_pipelineBinds = 1;
+
+		const LveModel *boundModel = nullptr;
+		bool modelIndexBufferBound = false;
+		size_t meshletRequest = 0;
+		auto recordQueue = [&](const LveRenderQueue &queue) {
+			for (const auto &item: queue.items()) {
+				auto &obj = renderObjects[item.m_index];
+
+				std::optional<MeshletDrawRange> meshletRange{};
+				if (obj.m_model->hasMeshlets()) {
+					meshletRange = m_meshletRanges_[meshletRequest++];
+					if (meshletRange && meshletRange->m_indexCount == 0) {
+						continue;
+					}
+				}
+
+				// Meshlet draws bind their own index buffer, so the model's has to be restored for a regular draw
+				if (obj.m_model.get() != boundModel || (!meshletRange && !modelIndexBufferBound)) {
+					obj.m_model->bind(frameInfo.m_commandBuffer);
+					boundModel = obj.m_model.get();
+					modelIndexBufferBound = true;
+					m_renderStats_.m_vertexBufferBinds++;
+				}
+				if (meshletRange) {
+					m_meshletCuller_.draw(frameInfo.m_commandBuffer, *meshletRange, item.m_index);
+					modelIndexBufferBound = false;
+				} else {
+					obj.m_model->draw(frameInfo.m_commandBuffer, item.m_index);
+				}
+				m_renderStats_.m_draws++;
+			}
+		};
+
+		recordQueue(m_opaqueQueue_);
+		if (!m_transparentQueue_.items().empty()) {
+			// Blended objects are drawn opaque until their pipeline has been compiled
+			if (LvePipeline *transparentPipeline = m_pipelines_.m_transparent->get({}, fragConstants).get()) {
+				transparentPipeline->bind(frameInfo.m_commandBuffer);
+				m_renderStats_.m_pipelineBinds++;
+			}
+			recordQueue(m_transparentQueue_);
+		}
 	}
-}
\ No newline at end of file
+}
@@ -5,21 +5,53 @@
 #ifndef VULKAN_TEST_RENDERSYSTEM_HPP
 #define VULKAN_TEST_RENDERSYSTEM_HPP
 
+#include "LveBindlessHeap.hpp"
+#include "LveBuffer.hpp"
 #include "LveCamera.hpp"
+#include "LveDeletionQueue.hpp"
+#include "LveDescriptors.hpp"
+#include "LveFrameAllocator.hpp"
 #include "LvePipeline.hpp"
-#include "LveGameObject.hpp"
+#include "LvePipelineCompiler.hpp"
+#include "LvePipelineVariants.hpp"
+#include "LveFrameSnapshot.hpp"
 #include "LveDevice.hpp"
+#include "LveFrameInfo.hpp"
+#include "LveJobSystem.hpp"
+#include "LveMeshlet.hpp"
+#include "LveRenderGraph.hpp"
+#include "LveRenderQueue.hpp"
+#include "LveTextureManager.hpp"
 
 // std
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <stdexcept>
 
 namespace lve {
 	class RenderSystem {
 	public:
-
-		RenderSystem(LveDevice &device, VkRenderPass renderPass);
+		// Selected with a specialization constant of the fragment shader, so the shaded path carries no debug
+		// branches. Material needs the bindless heap and is drawn shaded without it.
+		enum class DebugView : uint32_t {
+			Shaded = 0,
+			Depth = 1,
+			Material = 2,
+		};
+
+		// With a bindless heap, objects look up their material through it (set 1), and objects with a texture
+		// of textureManager sample it through the heap as well; without one every object is drawn with its
+		// vertex colors. Pipelines are compiled on pipelineCompiler, the first frame waits for the opaque one.
+		// Objects and meshlets are culled and large render queues sorted on jobSystem when one is given.
+		RenderSystem(LveDevice &device,
+		             const RenderTargetInfo &renderTarget,
+		             LvePipelineCompiler &pipelineCompiler,
+		             LveBindlessHeap *bindlessHeap = nullptr,
+		             LveTextureManager *textureManager = nullptr,
+		             LveJobSystem *jobSystem = nullptr);
 
 		~RenderSystem();
 
@@ -27,18 +59,84 @@ namespace lve {
 
 		RenderSystem &operator=(const RenderSystem &) = delete;
 
-		void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &gameObjects,
-		                       const LveCamera &camera);
+		void renderGameObjects(FrameInfo &frameInfo, const std::vector<RenderObject> &renderObjects);
+
+		// Declares a pass that clears color and depth and renders renderObjects into them
+		void addRenderPass(LveRenderGraph &graph,
+		                   FrameInfo &frameInfo,
+		                   const std::vector<RenderObject> &renderObjects,
+		                   RenderGraphResource color,
+		                   RenderGraphResource depth);
+
+		const LveMeshletCuller &getMeshletCuller() const { return m_meshletCuller_; }
+
+		// Binds and draws recorded by the last renderGameObjects call
+		const RenderStats &getRenderStats() const { return m_renderStats_; }
+
+		// Views other than Shaded are compiled on first use and drawn shaded until they are ready
+		void setDebugView(DebugView debugView) { m_debugView_ = debugView; }
+
+		// Blocks until the pipelines of the current debug view have compiled, so it is drawn from the next
+		// frame on instead of the shaded fallback
+		void waitForDebugView();
+
+		// Recompiles the pipelines when one of their shaders is in changedShaders, which holds shader names as
+		// LveShaderWatcher reports them, and swaps them in on a later call once compilation has finished. The
+		// replaced pipelines may still be used by frames in flight, so they are handed to deletionQueue. Must be
+		// called outside a render pass.
+		void reloadShaders(const std::vector<std::string> &changedShaders, LveDeletionQueue &deletionQueue);
 
 	private:
+		struct Pipelines {
+			std::unique_ptr<LvePipelineVariants> m_opaque;
+			std::unique_ptr<LvePipelineVariants> m_transparent;
+		};
+
+		// Frustum culling result of one render object
+		struct ObjectVisibility {
+			bool m_visible;
+			float m_viewDepth;
+		};
+
 		void createPipelineLayout();
 
-		void createPipeline(VkRenderPass renderPass);
+		Pipelines compilePipelines();
+
+		void createDescriptorSets();
+
+		void createDefaultMaterial();
 
 		LveDevice &m_lveDevice_;
-		std::unique_ptr<LvePipeline> m_lvePipeline_;
+		RenderTargetInfo m_renderTarget_;
+		std::string m_vertFilePath_;
+		std::string m_fragFilePath_;
+		LvePipelineCompiler &m_pipelineCompiler_;
 		VkPipelineLayout m_pipelineLayout_;
-
+		Pipelines m_pipelines_;
+		std::optional<Pipelines> m_pendingPipelines_;
+		bool m_reloadRequested_ = false;
+		DebugView m_debugView_ = DebugView::Shaded;
+		LveMeshletCuller m_meshletCuller_{m_lveDevice_};
+
+		// Camera and per-object data are uploaded once per frame and bound through one set per frame in flight
+		std::unique_ptr<LveDescriptorSetLayout> m_setLayout_;
+		std::unique_ptr<LveDescriptorPool> m_descriptorPool_;
+		std::vector<VkDescriptorSet> m_descriptorSets_;
+		LveFrameAllocator m_frameAllocator_;
+
+		LveBindlessHeap *m_bindlessHeap_;
+		LveTextureManager *m_textureManager_;
+		LveJobSystem *m_jobSystem_;
+		std::unique_ptr<LveBuffer> m_defaultMaterialBuffer_;
+		uint32_t m_defaultMaterial_ = 0;
+
+		LveRenderQueue m_opaqueQueue_;
+		LveRenderQueue m_transparentQueue_;
+		std::unordered_map<const LveModel *, uint32_t> m_modelIds_;
+		std::vector<ObjectVisibility> m_visibility_;
+		std::vector<MeshletCullRequest> m_meshletRequests_;
+		std::vector<std::optional<MeshletDrawRange>> m_meshletRanges_;
+		RenderStats m_renderStats_{};
 
 	};
 }
@@ -1,11 +1,65 @@
 #include "FirstApp.hpp"
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
-int main() {
-    lve::FirstApp app{};
+int main(int argc, char **argv) {
+    // --offscreen renders without a window or display, for regression runs on CI
+    bool offscreen = std::any_of(argv + 1, argv + argc, [](const char *arg) {
+        return std::strcmp(arg, "--offscreen") == 0;
+    });
+    lve::FirstApp app{offscreen};
+
+    // --capture <png|ppm|raw> <path prefix, or command receiving raw frames>
+    // --regression <golden directory>, or --update-goldens <golden directory> to record new references
+    // --texture <KTX2 file>, may be repeated
+    // --sim-rate <simulation steps per second>
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--offscreen") == 0) {
+            continue;
+        } else if (std::strcmp(argv[i], "--capture") == 0 && i + 2 < argc) {
+            lve::LveFrameCapture::Settings settings{};
+            std::string format = argv[i + 1];
+            if (format == "ppm") {
+                settings.m_format = lve::LveFrameCapture::Format::Ppm;
+            } else if (format == "raw") {
+                settings.m_format = lve::LveFrameCapture::Format::Raw;
+            } else if (format != "png") {
+                std::cerr << "Unknown capture format " << format << "\n";
+                return EXIT_FAILURE;
+            }
+            settings.m_output = argv[i + 2];
+            app.setFrameCapture(settings);
+            i += 2;
+        } else if ((std::strcmp(argv[i], "--regression") == 0 || std::strcmp(argv[i], "--update-goldens") == 0) &&
+                   i + 1 < argc) {
+            lve::LveFrameRegression::Settings settings{};
+            settings.m_goldenDirectory = argv[i + 1];
+            settings.m_updateGoldens = std::strcmp(argv[i], "--update-goldens") == 0;
+            app.setFrameRegression(settings);
+            i += 1;
+        } else if (std::strcmp(argv[i], "--texture") == 0 && i + 1 < argc) {
+            app.addTexture(argv[i + 1]);
+            i += 1;
+        } else if (std::strcmp(argv[i], "--sim-rate") == 0 && i + 1 < argc) {
+            float rate = std::strtof(argv[i + 1], nullptr);
+            if (!(rate > 0.f)) {
+                std::cerr << "Invalid simulation rate " << argv[i + 1] << "\n";
+                return EXIT_FAILURE;
+            }
+            app.setSimulationRate(rate);
+            i += 1;
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--offscreen] [--capture <png|ppm|raw> <output>]"
+                      << " [--regression|--update-goldens <directory>]"
+                      << " [--texture <file>]... [--sim-rate <steps per second>]\n";
+            return EXIT_FAILURE;
+        }
+    }
 
     try {
         app.run();
@@ -15,4 +69,4 @@ int main() {
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,31 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+layout(location = 0) out vec3 fragColor;
+
+struct ObjectData {
+    mat4 m_model;
+    vec4 m_boundingSphere;
+    vec4 m_color;
+    uint m_batch;
+    uint m_drawSlot;
+    uint m_pad0;
+    uint m_pad1;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+layout(push_constant) uniform Push {
+    mat4 m_projectionView;
+} push;
+
+void main() {
+    // The culling pass stores the object index in firstInstance, which gl_InstanceIndex includes.
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_Position = push.m_projectionView * object.m_model * vec4(position, 1.0);
+    fragColor = color;
+}
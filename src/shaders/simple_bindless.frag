@@ -0,0 +1,51 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (location = 0) in vec4 fragColor;
+layout (location = 1) flat in uint fragMaterial;
+layout (location = 2) in vec3 fragObjectPosition;
+layout (location = 3) flat in uint fragTexture;
+layout (location = 0) out vec4 outColor;
+
+// Arrays of the bindless heap, see LveBindlessHeap
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+layout(std430, set = 1, binding = 1) readonly buffer Material {
+    vec4 m_baseColor;
+} materials[];
+
+// LveTextureManager::m_invalidBindlessHandle
+const uint noTexture = 0xFFFFFFFFu;
+
+// RenderSystem::DebugView, specialized per pipeline variant
+layout (constant_id = 0) const uint debugView = 0;
+
+vec3 materialIdColor(uint material) {
+    uint hash = material * 2654435761u;
+    return vec3(hash & 0xFFu, (hash >> 8) & 0xFFu, (hash >> 16) & 0xFFu) / 255.0;
+}
+
+// Models have no texture coordinates, so textures are projected along the dominant axis of the face
+vec2 boxProjection(vec3 position) {
+    vec3 normal = abs(cross(dFdx(position), dFdy(position)));
+    if (normal.x >= normal.y && normal.x >= normal.z) {
+        return position.zy + 0.5;
+    }
+    if (normal.y >= normal.z) {
+        return position.xz + 0.5;
+    }
+    return position.xy + 0.5;
+}
+
+void main() {
+    if (debugView == 1) {
+        outColor = vec4(vec3(gl_FragCoord.z), 1.0);
+    } else if (debugView == 2) {
+        outColor = vec4(materialIdColor(fragMaterial), 1.0);
+    } else {
+        outColor = fragColor * materials[nonuniformEXT(fragMaterial)].m_baseColor;
+        // The handle is flat, so every invocation of a primitive takes the same branch
+        if (fragTexture != noTexture) {
+            outColor.rgb *= texture(textures[nonuniformEXT(fragTexture)], boxProjection(fragObjectPosition)).rgb;
+        }
+    }
+}
@@ -1,13 +1,15 @@
 #version 450
 
-layout (location = 0) in vec3 fragColor;
+layout (location = 0) in vec4 fragColor;
 layout (location = 0) out vec4 outColor;
 
-layout(push_constant) uniform Push {
-    mat4 m_transform;
-    vec3 m_color;
-} push;
+// RenderSystem::DebugView, specialized per pipeline variant
+layout (constant_id = 0) const uint debugView = 0;
 
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    if (debugView == 1) {
+        outColor = vec4(vec3(gl_FragCoord.z), 1.0);
+    } else {
+        outColor = fragColor;
+    }
 }
@@ -3,14 +3,35 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 
-layout(location = 0) out vec3 fragColor;
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) flat out uint fragMaterial;
+layout(location = 2) out vec3 fragObjectPosition;
+layout(location = 3) flat out uint fragTexture;
 
-layout(push_constant) uniform Push {
-  mat4 m_transform;
-  vec3 m_color;
-} push;
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 m_projectionView;
+} ubo;
+
+struct ObjectData {
+  mat4 m_model;
+  vec4 m_color;
+  uint m_material;
+  uint m_texture;
+  uint m_pad1;
+  uint m_pad2;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer Objects {
+  ObjectData objects[];
+};
 
 void main() {
-    gl_Position = push.m_transform * vec4(position, 1.0);
-    fragColor = color;
+    // Each draw passes its object index as firstInstance
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_Position = ubo.m_projectionView * object.m_model * vec4(position, 1.0);
+    // Alpha carries the object opacity, only blended when drawn with the transparent pipeline
+    fragColor = vec4(color, object.m_color.a);
+    fragMaterial = object.m_material;
+    fragObjectPosition = position;
+    fragTexture = object.m_texture;
 }